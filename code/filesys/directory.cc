@@ -21,10 +21,37 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "debug.h"
 #include "filehdr.h"
 #include "directory.h"
+#include "pool.h"
 #define NumDirEntries       10
 
+// Directories are read in for almost every file system operation, so
+// they, and their tables if they are the usual size, come from pools.
+static Pool *directoryPool = NULL;
+static Pool *entryPool = NULL;
+
+//----------------------------------------------------------------------
+// Directory::operator new, Directory::operator delete
+//	Allocate a directory from a pool, and free it again.
+//----------------------------------------------------------------------
+
+void *
+Directory::operator new(size_t size)
+{
+    ASSERT(size == sizeof(Directory));
+    if (directoryPool == NULL)
+	directoryPool = new Pool("directory", sizeof(Directory));
+    return directoryPool->Get();
+}
+
+void
+Directory::operator delete(void *p)
+{
+    directoryPool->Put(p);
+}
+
 //----------------------------------------------------------------------
 // Directory::Directory
 // 	Initialize a directory; initially, the directory is completely
@@ -37,7 +64,14 @@
 
 Directory::Directory(int size)
 {
-    table = new DirectoryEntry[size];
+    if (size == NumDirEntries) {
+	if (entryPool == NULL)
+	    entryPool = new Pool("directory table",
+				sizeof(DirectoryEntry) * NumDirEntries);
+	table = (DirectoryEntry *) entryPool->Get();
+    } else {
+	table = new DirectoryEntry[size];
+    }
 	
 	// MP4 mod tag
 	memset(table, 0, sizeof(DirectoryEntry) * size);  // dummy operation to keep valgrind happy
@@ -54,7 +88,10 @@ Directory::Directory(int size)
 
 Directory::~Directory()
 { 
-    delete [] table;
+    if (tableSize == NumDirEntries)
+	entryPool->Put(table);
+    else
+	delete [] table;
 } 
 
 //----------------------------------------------------------------------
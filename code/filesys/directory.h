@@ -54,6 +54,9 @@ class Directory {
 					// with space for "size" files
     ~Directory();			// De-allocate the directory
 
+    void *operator new(size_t size);	// allocate from a pool
+    void operator delete(void *p);	// and give back to it
+
     void FetchFrom(OpenFile *file);  	// Init directory contents from disk
     void WriteBack(OpenFile *file);	// Write modifications to 
 					// directory contents back to disk
@@ -28,6 +28,50 @@
 #include "debug.h"
 #include "synchdisk.h"
 #include "main.h"
+#include "pool.h"
+
+static Pool *tablePool = NULL;		// where indirect tables come from
+static Pool *headerPool = NULL;		// and file headers
+
+//----------------------------------------------------------------------
+// indirectTable::operator new, indirectTable::operator delete
+//	Allocate an indirect table from a pool, and free it again.
+//----------------------------------------------------------------------
+
+void *
+indirectTable::operator new(size_t size)
+{
+    ASSERT(size == sizeof(indirectTable));
+    if (tablePool == NULL)
+	tablePool = new Pool("indirect table", sizeof(indirectTable));
+    return tablePool->Get();
+}
+
+void
+indirectTable::operator delete(void *p)
+{
+    tablePool->Put(p);
+}
+
+//----------------------------------------------------------------------
+// FileHeader::operator new, FileHeader::operator delete
+//	Allocate a file header from a pool, and free it again.
+//----------------------------------------------------------------------
+
+void *
+FileHeader::operator new(size_t size)
+{
+    ASSERT(size == sizeof(FileHeader));
+    if (headerPool == NULL)
+	headerPool = new Pool("file header", sizeof(FileHeader));
+    return headerPool->Get();
+}
+
+void
+FileHeader::operator delete(void *p)
+{
+    headerPool->Put(p);
+}
 
 //----------------------------------------------------------------------
 // MP4 mod tag
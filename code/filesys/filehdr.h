@@ -35,10 +35,16 @@
 // There is no constructor; rather the file header can be initialized
 // by allocating blocks for the file (if it is a new file), or by
 // reading it from disk.
+//
+// Both indirect tables and file headers are allocated and freed all the
+// time, so they come from pools rather than the host's allocator.
+
 class indirectTable {
   public:
     int dataSectors[NumInDirect];		// Disk sector numbers for each data 
 
+    void *operator new(size_t size);	// allocate from a pool
+    void operator delete(void *p);	// and give back to it
 };
 
 class FileHeader {
@@ -46,6 +52,9 @@ class FileHeader {
 	// MP4 mod tag
 	FileHeader(); // dummy constructor to keep valgrind happy
 	~FileHeader();
+
+    void *operator new(size_t size);	// allocate from a pool
+    void operator delete(void *p);	// and give back to it
 	
     bool Allocate(PersistentBitmap *bitMap, int fileSize);// Initialize a file header, 
 						//  including allocating space 
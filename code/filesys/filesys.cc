@@ -30,7 +30,9 @@
 //
 // 	Our implementation at this point has the following restrictions:
 //
-//	   there is no synchronization for concurrent accesses
+//	   directories are locked while they are searched or changed,
+//	     and the bitmap while it is changed, but recursively removing
+//	     a directory only locks its top level
 //	   files have a fixed size, set when the file is created
 //	   files cannot be bigger than about 3KB in size
 //	   there is no hierarchical directory structure, and only a limited
@@ -51,6 +53,10 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "synch.h"
+#include "pool.h"
+#include "imagecache.h"
+#include "main.h"
 #include <vector>
 
 // Sectors containing the file headers for the bitmap of free sectors,
@@ -82,8 +88,12 @@
 FileSystem::FileSystem(bool format)
 { 
 	DEBUG(dbgFile, "Initializing the file system.");
+	fileLocks = new SectorLockTable("file lock");
+	directoryLocks = new SectorLockTable("directory lock");
+	freeMapLock = new Lock("free map lock");
+	openFileLock = new Lock("open file table lock");
+	freeMap = new PersistentBitmap(NumSectors);
 	if (format) {
-		PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
 		Directory *directory = new Directory(NumDirEntries);
 		FileHeader *mapHdr = new FileHeader;
 		FileHeader *dirHdr = new FileHeader;
@@ -136,7 +146,6 @@ FileSystem::FileSystem(bool format)
 		   for(i=0;i<SYS_MAX_OPEN_FILE_NUM;i++){
 		   sysOpenFileTable[i] = NULL;
 		   }*/
-		delete freeMap; 
 		delete directory; 
 		delete mapHdr; 
 		delete dirHdr;
@@ -156,6 +165,40 @@ FileSystem::~FileSystem()
 {
 	delete freeMapFile;
 	delete directoryFile;
+	delete freeMap;
+	delete openFileLock;
+	delete freeMapLock;
+	delete directoryLocks;
+	delete fileLocks;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::LockDirectory, FileSystem::UnlockDirectory
+// 	Lock the directory whose file header is at "sector", shared for
+//	looking names up or exclusive for changing it, and unlock it
+//	again.  See filesys.h for the order locks must be taken in.
+//----------------------------------------------------------------------
+
+RWLock *
+FileSystem::LockDirectory(int sector, bool writing)
+{
+	RWLock *dirLock = directoryLocks->Get(sector);
+
+	if (writing)
+		dirLock->AcquireWrite();
+	else
+		dirLock->AcquireRead();
+	return dirLock;
+}
+
+void
+FileSystem::UnlockDirectory(int sector, RWLock *dirLock, bool writing)
+{
+	if (writing)
+		dirLock->ReleaseWrite();
+	else
+		dirLock->ReleaseRead();
+	directoryLocks->Put(sector);
 }
 
 //----------------------------------------------------------------------
@@ -180,8 +223,9 @@ FileSystem::~FileSystem()
 //	 	no free entry for file in directory
 //	 	no free space for data blocks for the file 
 //
-// 	Note that this implementation assumes there is no concurrent access
-//	to the file system!
+// 	The directory is locked for writing from the time we check that
+//	the name is free until the new entry is on disk, and the free map
+//	while we take sectors from it.
 //
 //	"name" -- name of file to be created
 //	"initialSize" -- size of file to be created
@@ -191,22 +235,26 @@ FileSystem::~FileSystem()
 FileSystem::Create(char *name, int initialSize)
 {
 	Directory *directory;
-	PersistentBitmap *freeMap;
 	FileHeader *hdr;
-	int sector;
+	RWLock *dirLock;
+	int sector, dirSector;
 	bool success;
+	Arena arena;
 
 	DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
 
-	OpenFile * dirFile = GoDirectory(&name);
+	OpenFile * dirFile = GoDirectory(&name, &arena);
 
+	dirSector = dirFile->HeaderSector();
+	dirLock = LockDirectory(dirSector, TRUE);
 	directory = new Directory(NumDirEntries);
 	directory->FetchFrom(dirFile);
 
 	if (directory->Find(name) != -1)
 		success = FALSE;			// file is already in directory
 	else {	
-		freeMap = new PersistentBitmap(freeMapFile,NumSectors);
+		freeMapLock->Acquire();
+		freeMap->FetchFrom(freeMapFile);
 		sector = freeMap->FindAndSet();	// find a sector to hold the file header
 		if (sector == -1) 		
 			success = FALSE;		// no free block for file header 
@@ -229,15 +277,14 @@ FileSystem::Create(char *name, int initialSize)
 					delete newDir;
 					delete newDirFile;
 				}
-				if(dirFile != directoryFile) delete dirFile; //root dir file should keep opening
-
 				freeMap->WriteBack(freeMapFile);
 			}
 			delete hdr;
 		}
-		delete freeMap;
+		freeMapLock->Release();
 	}
-	delete [] name;
+	UnlockDirectory(dirSector, dirLock, TRUE);
+	if(dirFile != directoryFile) delete dirFile; //root dir file should keep opening
 	delete directory;
 	return success;
 }
@@ -259,22 +306,28 @@ FileSystem::Open(char *name)
 	OpenFile *openFile = NULL;
 	int sector;
 	int fd = -1;
+	Arena arena;
 	DEBUG(dbgFile, "Opening file" << name);
 
 
-	OpenFile* dirFile = GoDirectory(&name);
+	OpenFile* dirFile = GoDirectory(&name, &arena);
+	int dirSector = dirFile->HeaderSector();
+	RWLock *dirLock = LockDirectory(dirSector, FALSE);
 	directory->FetchFrom(dirFile);
 	if(dirFile != directoryFile) delete dirFile; //root dir file should keep opening
 
 	if(name==NULL || IsDir(name)) {
+		UnlockDirectory(dirSector, dirLock, FALSE);
 		std::cout<<"FileSystem::Open : Bad open path."<<std::endl;
-		if(name!=NULL) delete [] name;
+		delete directory;
 		return NULL;
 	}
 	sector = directory->Find(name); 
 	// TODO: allocate a new entry in system-wide table[done]
 	if (sector >= 0){		
 
+		// open the file before unlocking the directory, so that no one
+		// can remove it in between
 		openFile = new OpenFile(sector);	// name was found in directory 
 		if(GetSysFd(&fd)){
 			openFile->SetFd(fd);
@@ -285,7 +338,7 @@ FileSystem::Open(char *name)
 			openFile = NULL;
 		}
 	}
-	delete [] name;
+	UnlockDirectory(dirSector, dirLock, FALSE);
 	delete directory;
 	return openFile;				// return NULL if not found
 }
@@ -314,22 +367,38 @@ FileSystem::Remove(char *name){
 FileSystem::Remove(char *name,bool recurRemoveFlag)
 { 
 	Directory *directory;
-	PersistentBitmap *freeMap;
 	FileHeader *fileHdr;
-	int sector;
+	RWLock *dirLock, *fileLock, *subDirLock = NULL;
+	WriteBuffer *buffer;
+	int sector, dirSector;
 	bool success = TRUE;
+	Arena arena;
 
 	directory = new Directory(NumDirEntries);
-	OpenFile* dirFile = GoDirectory(&name);
+	OpenFile* dirFile = GoDirectory(&name, &arena);
+	dirSector = dirFile->HeaderSector();
+	dirLock = LockDirectory(dirSector, TRUE);
 	directory->FetchFrom(dirFile);
 
 	sector = directory->Find(name);
 	if (sector == -1) {
+		UnlockDirectory(dirSector, dirLock, TRUE);
+		if(dirFile != directoryFile) delete dirFile;
 		delete directory;
 		return FALSE;			 // file not found 
 	}
 
-	freeMap = new PersistentBitmap(freeMapFile,NumSectors);
+	// lock a directory we are emptying before its contents, and wait
+	// for anyone reading or writing the file to finish
+	if(recurRemoveFlag && IsDir(name))
+		subDirLock = LockDirectory(sector, TRUE);
+	fileLock = fileLocks->Get(sector);
+	buffer = fileLocks->Buffer(sector);
+	fileLock->AcquireWrite();
+	buffer->Discard();		// nothing more goes to its sectors
+
+	freeMapLock->Acquire();
+	freeMap->FetchFrom(freeMapFile);
 
 	if(recurRemoveFlag && IsDir(name)){
 		Directory *subDir = new Directory(NumDirEntries);
@@ -349,19 +418,56 @@ FileSystem::Remove(char *name,bool recurRemoveFlag)
 	fileHdr->Deallocate(freeMap);  		// remove data blocks
 	freeMap->Clear(sector);			// remove header block
 	directory->Remove(name);
+	if (kernel->imageCache != NULL) {
+		kernel->imageCache->Invalidate(sector);	// sector may be reused
+	}
 
 	freeMap->WriteBack(freeMapFile);		// flush to disk
+	freeMapLock->Release();
 	directory->WriteBack(dirFile);        // flush to disk
 
+	fileLock->ReleaseWrite();
+	fileLocks->Put(sector);
+	if(recurRemoveFlag && IsDir(name))
+		UnlockDirectory(sector, subDirLock, TRUE);
+	UnlockDirectory(dirSector, dirLock, TRUE);
 	if(dirFile != directoryFile) delete dirFile; //root dir file should keep opening
-	delete [] name;
 	delete fileHdr;
 	delete directory;
-	delete freeMap;
 
 	return success;
 } 
 
+//----------------------------------------------------------------------
+// FileSystem::Sync
+// 	Write the data buffered for every open file to disk.
+//----------------------------------------------------------------------
+
+void
+FileSystem::Sync()
+{
+    fileLocks->Sync();
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Sync
+// 	Write the data buffered for one open file to disk.
+//
+//	Returns 1, or -1 if "fd" isn't open.
+//----------------------------------------------------------------------
+
+int
+FileSystem::Sync(int fd)
+{
+    OpenFile *openFile = GetOpenFileTable(fd);
+
+    if (openFile == NULL) {
+	return -1;
+    }
+    openFile->Sync();
+    return 1;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::List
 // 	List all the files in the file system directory.
@@ -371,7 +477,10 @@ FileSystem::Remove(char *name,bool recurRemoveFlag)
 FileSystem::List()
 {
 	Directory *directory = new Directory(NumDirEntries);
+	RWLock *dirLock = LockDirectory(DirectorySector, FALSE);
+
 	directory->FetchFrom(directoryFile);
+	UnlockDirectory(DirectorySector, dirLock, FALSE);
 	directory->List();
 	delete directory;
 }
@@ -380,8 +489,9 @@ FileSystem::List()
 FileSystem::List(char* path,bool recursiveListFlag)
 {
 	Directory *directory = new Directory(NumDirEntries);
-	OpenFile * dirFile = GoDirectory(&path);
-	directory->FetchFrom(dirFile);
+	Arena arena;
+	OpenFile * dirFile = GoDirectory(&path, &arena);
+	FetchDirectory(directory, dirFile);
 	if(recursiveListFlag) directory->List(0);
 	else {
 		if(dirFile==directoryFile && !IsDir(path)){
@@ -393,7 +503,7 @@ FileSystem::List(char* path,bool recursiveListFlag)
 		char * name = path;
 		Directory * subDir = new Directory(NumDirEntries);
 		OpenFile * subDirFile = new OpenFile(directory->Find(name));
-		subDir->FetchFrom(subDirFile);
+		FetchDirectory(subDir, subDirFile);
 
 		subDir->List();
 		delete subDir;
@@ -417,7 +527,6 @@ FileSystem::Print()
 {
 	FileHeader *bitHdr = new FileHeader;
 	FileHeader *dirHdr = new FileHeader;
-	PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile,NumSectors);
 	Directory *directory = new Directory(NumDirEntries);
 
 	printf("Bit map file header:\n");
@@ -428,14 +537,16 @@ FileSystem::Print()
 	dirHdr->FetchFrom(DirectorySector);
 	dirHdr->Print();
 
+	freeMapLock->Acquire();
+	freeMap->FetchFrom(freeMapFile);
 	freeMap->Print();
+	freeMapLock->Release();
 
 	directory->FetchFrom(directoryFile);
 	directory->Print();
 
 	delete bitHdr;
 	delete dirHdr;
-	delete freeMap;
 	delete directory;
 } 
 
@@ -472,7 +583,9 @@ FileSystem::Close(int fd){
 	OpenFile *opFile = GetOpenFileTable(fd);
 
 	//SetOpenFileTable(fd,NULL);
+	openFileLock->Acquire();
 	sysOpFileTable.erase(fd);
+	openFileLock->Release();
 	delete opFile;
 	return 1;
 }
@@ -482,37 +595,47 @@ bool FileSystem::GetSysFd(int *fdout){
 	int i = 0;
 	int fd = fdPosition;
 	OpenFile *opFile = NULL;
+	openFileLock->Acquire();
 	while(i<SYS_MAX_OPEN_FILE_NUM){
 		fd = (fd+i)%SYS_MAX_OPEN_FILE_NUM;
 		opFile = sysOpFileTable[fd];
 		if(opFile==NULL){
 			*fdout = fd;
 			fdPosition = (fd+1);// assume next one is free
+			openFileLock->Release();
 			return TRUE;
 		}
 		i++;
 	}
+	openFileLock->Release();
 
 	return FALSE;
 }
 
 void FileSystem::SetOpenFileTable(int fd, OpenFile *openFile){
+	openFileLock->Acquire();
 	sysOpFileTable[fd] = openFile;
+	openFileLock->Release();
 }
 
 OpenFile* FileSystem::GetOpenFileTable(int fd){
+	OpenFile *opFile;
 
-	return sysOpFileTable[fd];
+	openFileLock->Acquire();
+	opFile = sysOpFileTable[fd];
+	openFileLock->Release();
+	return opFile;
 }
 
-std::vector<char*>& FileSystem::PreprocessPath(char* path, std::vector<char*>& pathQueue){
+std::vector<char*>& FileSystem::PreprocessPath(char* path, std::vector<char*>& pathQueue,
+					Arena *arena){
 	const int NAME_SIZE = 255;
 	char *name = NULL;
 
 
 	for(int i=0, pre_i = 0;i<strlen(path);i++){
 		if(i==pre_i) 
-			name = new char[NAME_SIZE];		//NOTICE: you should delete this yourself after used.
+			name = (char *) arena->Alloc(NAME_SIZE);	// freed with the arena
 
 
 		name[i-pre_i] = path[i];
@@ -529,16 +652,27 @@ bool FileSystem::IsDir(char* name){
 }
 
 void FileSystem::CleanQueue(std::vector<char*>& queue){
-	while(!queue.empty()){
-		char * toBeDelete = queue.front();
-		queue.erase(queue.begin());
-		delete [] toBeDelete;
-	}
+	queue.clear();		// the names belong to an arena
+}
+
+//----------------------------------------------------------------------
+// FileSystem::FetchDirectory
+// 	Read in a directory while it is locked for reading, so that we
+//	never see it half changed.  Walking down a path, we only hold
+//	one directory lock at a time.
+//----------------------------------------------------------------------
+
+void FileSystem::FetchDirectory(Directory *directory, OpenFile *dirFile){
+	int sector = dirFile->HeaderSector();
+	RWLock *dirLock = LockDirectory(sector, FALSE);
+
+	directory->FetchFrom(dirFile);
+	UnlockDirectory(sector, dirLock, FALSE);
 }
 
-OpenFile * FileSystem::GoDirectory(char** name){
+OpenFile * FileSystem::GoDirectory(char** name, Arena *arena){
 	std::vector<char*> pathQueue;
-	PreprocessPath(*name,pathQueue);
+	PreprocessPath(*name,pathQueue,arena);
 	//delete [] *name; //delete the input string (which is the absolute path)	
 	OpenFile * dirFile = NULL;
 	Directory* directory = new Directory(NumDirEntries);
@@ -548,8 +682,8 @@ OpenFile * FileSystem::GoDirectory(char** name){
 		pathQueue.erase(pathQueue.begin()); 	//pop_front
 
 		if(strcmp(*name,"/")==0){				//root dir
-			directory->FetchFrom(directoryFile);
 			dirFile = directoryFile;
+			FetchDirectory(directory, dirFile);
 		}else if(IsDir(*name)){		//sub dir
 			int subDirSector = directory->Find(*name);
 			if(subDirSector==-1) {
@@ -563,12 +697,11 @@ OpenFile * FileSystem::GoDirectory(char** name){
 			if(dirFile != directoryFile) delete dirFile;	// delete last dir file
 			// BUT! if last dir is root , do nothing.
 			dirFile = new OpenFile(subDirSector);
-			directory->FetchFrom(dirFile);
+			FetchDirectory(directory, dirFile);
 		}else{	//this is a file
 			ASSERT(pathQueue.empty());	// path should be the last file
 			break; // going to create a file
 		}
-		delete [] *name;
 	}
 	delete directory;
 
@@ -62,6 +62,8 @@ class FileSystem {
 
     bool Remove(char *name) { return Unlink(name) == 0; }
 
+    void Sync() {}			// nothing is buffered
+
 	OpenFile *fileDescriptorTable[20];
 	
 };
@@ -70,6 +72,12 @@ class FileSystem {
   
 #define SYS_MAX_OPEN_FILE_NUM 30
 
+class Directory;
+class Lock;
+class RWLock;
+class Arena;
+class PersistentBitmap;
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -89,6 +97,8 @@ class FileSystem {
     bool Remove(char *name);
     bool Remove(char *name,bool recurRemoveFlag);  		// Delete a file (UNIX unlink)
 
+    void Sync();			// Write buffered data to disk
+    int Sync(int fd);			// ... for one open file
     void List();			// List all the files in the file system
     void List(char* path,bool recursiveListFlag);
 
@@ -103,17 +113,40 @@ class FileSystem {
     OpenFile* GetOpenFileTable(int fd);
 
   private:
-	std::vector<char*>& PreprocessPath(char* path, std::vector<char*>& pathQueue);
+	RWLock *LockDirectory(int sector, bool writing);
+	void UnlockDirectory(int sector, RWLock *dirLock, bool writing);
+					// Lock/unlock the directory whose
+					// header is at "sector"
+	void FetchDirectory(Directory *directory, OpenFile *dirFile);
+					// Read a directory with it locked
+
+	std::vector<char*>& PreprocessPath(char* path, std::vector<char*>& pathQueue,
+					Arena *arena);
 	bool IsDir(char* name);
 
 	void CleanQueue(vector<char*>& queue);
 
-	OpenFile * GoDirectory(char** name);
+	OpenFile * GoDirectory(char** name, Arena *arena);
+					// The path names are allocated from
+					// "arena", and freed with it
 
    OpenFile* freeMapFile;		// Bit map of free disk blocks,
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a FILESYS
+   // Locks must be taken in this order, to avoid deadlock:
+   //   directory locks, a parent before its children;
+   //   the lock of a file being removed;
+   //   freeMapLock;
+   //   file locks taken inside OpenFile::ReadAt/WriteAt, which are
+   //     held for just that call.
+   // openFileLock is never held while taking another lock.
+   SectorLockTable *directoryLocks;	// Per-directory reader-writer locks
+   Lock *freeMapLock;			// Held while changing the bitmap
+   PersistentBitmap *freeMap;		// In-core copy of the bitmap, read
+					// in afresh by whoever holds
+					// freeMapLock
+   Lock *openFileLock;			// Protects the two fields below
    map<int, OpenFile*> sysOpFileTable;
    //OpenFile* sysOpenFileTable[SYS_MAX_OPEN_FILE_NUM];
    int fdPosition;
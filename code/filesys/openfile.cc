@@ -17,6 +17,252 @@
 #include "filehdr.h"
 #include "openfile.h"
 #include "synchdisk.h"
+#include "synch.h"
+#include "pool.h"
+#include "imagecache.h"
+
+SectorLockTable *fileLocks;
+
+//----------------------------------------------------------------------
+// WriteBuffer::Start
+// 	Start buffering writes to another sector of the file.  We have
+//	none of its bytes yet.
+//
+//	"fileSector" -- which sector of the file it is
+//	"where" -- the sector on disk it goes to
+//----------------------------------------------------------------------
+
+void
+WriteBuffer::Start(int fileSector, int where)
+{
+    ASSERT(!IsDirty());
+    sector = fileSector;
+    diskSector = where;
+    validFrom = validTo = 0;
+}
+
+//----------------------------------------------------------------------
+// WriteBuffer::Write
+// 	Put bytes written to the buffered sector in the buffer.  We only
+//	keep one run of bytes from it, so if these aren't next to the ones
+//	we have, we read in the rest of the sector first.
+//
+//	"from" -- the bytes to write
+//	"numBytes" -- how many there are
+//	"offset" -- where they go, from the start of the sector
+//----------------------------------------------------------------------
+
+void
+WriteBuffer::Write(char *from, int numBytes, int offset)
+{
+    ASSERT(IsDirty() && offset >= 0 && offset + numBytes <= SectorSize);
+
+    if (validFrom == validTo) {			// the first bytes
+	validFrom = validTo = offset;
+    } else if (offset > validTo || offset + numBytes < validFrom) {
+	Fill();					// there would be a gap
+    }
+    bcopy(from, &data[offset], numBytes);
+    validFrom = min(validFrom, offset);
+    validTo = max(validTo, offset + numBytes);
+}
+
+//----------------------------------------------------------------------
+// WriteBuffer::Read
+// 	Copy any buffered bytes that are part of a read of the file
+//	over what was read from disk.
+//
+//	"into" -- the data read
+//	"numBytes" -- how much of it there is
+//	"position" -- where in the file it came from
+//----------------------------------------------------------------------
+
+void
+WriteBuffer::Read(char *into, int numBytes, int position)
+{
+    int from, to;
+
+    if (!IsDirty()) {
+	return;
+    }
+    from = max(sector * SectorSize + validFrom, position);
+    to = min(sector * SectorSize + validTo, position + numBytes);
+    if (from < to) {
+	bcopy(&data[from - sector * SectorSize], &into[from - position],
+							to - from);
+    }
+}
+
+//----------------------------------------------------------------------
+// WriteBuffer::Fill
+// 	Read in the bytes of the sector we don't have, so we have all
+//	of it.
+//----------------------------------------------------------------------
+
+void
+WriteBuffer::Fill()
+{
+    char onDisk[SectorSize];
+
+    if (validFrom == 0 && validTo == SectorSize) {
+	return;
+    }
+    kernel->synchDisk->ReadSector(diskSector, onDisk);
+    bcopy(onDisk, data, validFrom);
+    bcopy(&onDisk[validTo], &data[validTo], SectorSize - validTo);
+    validFrom = 0;
+    validTo = SectorSize;
+}
+
+//----------------------------------------------------------------------
+// WriteBuffer::Flush
+// 	Write the buffered sector to disk, if it is dirty.  If we don't
+//	have all of it, we have to read in the rest first.
+//----------------------------------------------------------------------
+
+void
+WriteBuffer::Flush()
+{
+    if (!IsDirty()) {
+	return;
+    }
+    DEBUG(dbgFile, "Flushing write buffer for sector " << diskSector);
+    Fill();
+    kernel->synchDisk->WriteSector(diskSector, data);
+    sector = -1;
+}
+
+//----------------------------------------------------------------------
+// SectorLockTable::SectorLockTable
+// 	Initialize an empty table of per-sector locks.
+//----------------------------------------------------------------------
+
+SectorLockTable::SectorLockTable(char *debugName)
+{
+    name = debugName;
+    lock = new Lock(debugName);
+}
+
+//----------------------------------------------------------------------
+// SectorLockTable::~SectorLockTable
+// 	De-allocate the table, and any locks still in it.
+//----------------------------------------------------------------------
+
+SectorLockTable::~SectorLockTable()
+{
+    map<int, SectorLock>::iterator it;
+
+    for (it = locks.begin(); it != locks.end(); it++) {
+	delete it->second.rwLock;
+	delete it->second.buffer;
+    }
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// SectorLockTable::Get
+// 	Return the lock for the file whose header is at "sector", making
+//	one if no one is using that file yet.  Every Get must be matched
+//	by a Put.
+//----------------------------------------------------------------------
+
+RWLock *
+SectorLockTable::Get(int sector)
+{
+    SectorLock *entry;
+
+    lock->Acquire();
+    entry = &locks[sector];
+    if (entry->refs == 0) {
+	entry->rwLock = new RWLock(name);
+	entry->buffer = NULL;
+    }
+    entry->refs++;
+    lock->Release();
+    return entry->rwLock;
+}
+
+//----------------------------------------------------------------------
+// SectorLockTable::Put
+// 	Drop a reference to the lock for "sector", throwing the lock
+//	away if no one else is using it.
+//----------------------------------------------------------------------
+
+void
+SectorLockTable::Put(int sector)
+{
+    map<int, SectorLock>::iterator it;
+
+    lock->Acquire();
+    it = locks.find(sector);
+    ASSERT(it != locks.end() && it->second.refs > 0);
+    if (--it->second.refs == 0) {
+	ASSERT(it->second.buffer == NULL || !it->second.buffer->IsDirty());
+	delete it->second.rwLock;
+	delete it->second.buffer;
+	locks.erase(it);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SectorLockTable::Buffer
+// 	Return the write buffer for the file whose header is at
+//	"sector", making one if need be.  The caller must have done a
+//	Get for "sector", and not yet the Put.
+//----------------------------------------------------------------------
+
+WriteBuffer *
+SectorLockTable::Buffer(int sector)
+{
+    SectorLock *entry;
+
+    lock->Acquire();
+    entry = &locks[sector];
+    ASSERT(entry->refs > 0);
+    if (entry->buffer == NULL) {
+	entry->buffer = new WriteBuffer;
+    }
+    lock->Release();
+    return entry->buffer;
+}
+
+//----------------------------------------------------------------------
+// SectorLockTable::Sync
+// 	Write every dirty write buffer to disk.  We take a reference to
+//	each file that has one, so that it stays in the table while we
+//	wait for its lock -- which we can't do holding "lock", since
+//	someone holding a file's lock may be waiting for "lock".
+//----------------------------------------------------------------------
+
+void
+SectorLockTable::Sync()
+{
+    map<int, SectorLock>::iterator it;
+    List<int> dirty;
+    SectorLock *entry;
+    int sector;
+
+    lock->Acquire();
+    for (it = locks.begin(); it != locks.end(); it++) {
+	if (it->second.buffer != NULL && it->second.buffer->IsDirty()) {
+	    it->second.refs++;
+	    dirty.Append(it->first);
+	}
+    }
+    lock->Release();
+
+    while (!dirty.IsEmpty()) {
+	sector = dirty.RemoveFront();
+	lock->Acquire();
+	entry = &locks[sector];
+	lock->Release();
+	entry->rwLock->AcquireWrite();
+	entry->buffer->Flush();
+	entry->rwLock->ReleaseWrite();
+	Put(sector);
+    }
+}
 
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
@@ -30,16 +276,22 @@ OpenFile::OpenFile(int sector)
 { 
     hdr = new FileHeader;
     hdr->FetchFrom(sector);
+    hdrSector = sector;
     seekPosition = 0;
+    rwLock = fileLocks->Get(sector);
+    buffer = fileLocks->Buffer(sector);
 }
 
 //----------------------------------------------------------------------
 // OpenFile::~OpenFile
 // 	Close a Nachos file, de-allocating any in-memory data structures.
+//	Anything we wrote that is still buffered goes to disk now.
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile()
 {
+    Sync();
+    fileLocks->Put(hdrSector);
     delete hdr;
 }
 
@@ -57,13 +309,30 @@ OpenFile::Seek(int position)
     seekPosition = position;
 }	
 
+//----------------------------------------------------------------------
+// OpenFile::Sync
+// 	Write anything buffered for this file to disk.
+//----------------------------------------------------------------------
+
+void
+OpenFile::Sync()
+{
+    if (!buffer->IsDirty()) {
+	return;				// don't bother locking
+    }
+    rwLock->AcquireWrite();
+    buffer->Flush();
+    rwLock->ReleaseWrite();
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Read/Write
 // 	Read/write a portion of a file, starting from seekPosition.
 //	Return the number of bytes actually written or read, and as a
 //	side effect, increment the current position within the file.
 //
-//	Implemented using the more primitive ReadAt/WriteAt.
+//	Read is implemented using the more primitive ReadAt.  Write
+//	buffers writes of less than a sector; see DoBufferedWrite.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -81,13 +350,51 @@ OpenFile::Read(char *into, int numBytes)
 int
 OpenFile::Write(char *into, int numBytes)
 {
-   int result = WriteAt(into, numBytes, seekPosition);
+   int result;
+
+   rwLock->AcquireWrite();
+   result = DoBufferedWrite(into, numBytes, seekPosition);
+   if (kernel->imageCache != NULL) {
+	kernel->imageCache->Invalidate(hdrSector);	// may be a program
+   }
+   rwLock->ReleaseWrite();
    seekPosition += result;
    return result;
 }
 
 //----------------------------------------------------------------------
 // OpenFile::ReadAt/WriteAt
+// 	Lock the file -- shared for reading, exclusive for writing --
+//	and read/write a portion of it.
+//----------------------------------------------------------------------
+
+int
+OpenFile::ReadAt(char *into, int numBytes, int position)
+{
+    int result;
+
+    rwLock->AcquireRead();
+    result = DoReadAt(into, numBytes, position);
+    rwLock->ReleaseRead();
+    return result;
+}
+
+int
+OpenFile::WriteAt(char *from, int numBytes, int position)
+{
+    int result;
+
+    rwLock->AcquireWrite();
+    result = DoWriteAt(from, numBytes, position);
+    if (kernel->imageCache != NULL) {
+	kernel->imageCache->Invalidate(hdrSector);	// may be a program
+    }
+    rwLock->ReleaseWrite();
+    return result;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::DoReadAt/DoWriteAt
 // 	Read/write a portion of a file, starting at "position".
 //	Return the number of bytes actually written or read, but has
 //	no side effects (except that Write modifies the file, of course).
@@ -96,14 +403,17 @@ OpenFile::Write(char *into, int numBytes)
 //	boundary; however the disk only knows how to read/write a whole disk
 //	sector at a time.  Thus:
 //
-//	For ReadAt:
+//	For DoReadAt:
 //	   We read in all of the full or partial sectors that are part of the
 //	   request, but we only copy the part we are interested in.
-//	For WriteAt:
+//	For DoWriteAt:
 //	   We must first read in any sectors that will be partially written,
 //	   so that we don't overwrite the unmodified portion.  We then copy
 //	   in the data that will be modified, and write back all the full
 //	   or partial sectors that are part of the request.
+//	If the request covers whole sectors, we can skip the copy, and
+//	transfer straight to or from the caller's buffer.  Otherwise, the
+//	buffer comes from an Arena, and is freed when we return.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -113,11 +423,13 @@ OpenFile::Write(char *into, int numBytes)
 //----------------------------------------------------------------------
 
 int
-OpenFile::ReadAt(char *into, int numBytes, int position)
+OpenFile::DoReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
+    int *sectors;
     char *buf;
+    Arena arena;
 
     if ((numBytes <= 0) || (position >= fileLength))
     	return 0; 				// check request
@@ -129,25 +441,36 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
     numSectors = 1 + lastSector - firstSector;
 
-    // read in all the full and partial sectors that we need
-    buf = new char[numSectors * SectorSize];
+    // read in all the full and partial sectors that we need, all at
+    // once, so that a striped disk can work on them in parallel; if
+    // we want whole sectors, they can go straight where they belong
+    sectors = (int *) arena.Alloc(numSectors * sizeof(int));
     for (i = firstSector; i <= lastSector; i++)	
-        kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
+        sectors[i - firstSector] = hdr->ByteToSector(i * SectorSize);
+    if (position == firstSector * SectorSize
+		&& numBytes == numSectors * SectorSize) {
+	kernel->synchDisk->ReadSectors(sectors, numSectors, into);
+	buffer->Read(into, numBytes, position);
+	return numBytes;
+    }
+    buf = (char *) arena.Alloc(numSectors * SectorSize);
+    kernel->synchDisk->ReadSectors(sectors, numSectors, buf);
 
-    // copy the part we want
+    // copy the part we want, and anything newer in the write buffer
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
-    delete [] buf;
+    buffer->Read(into, numBytes, position);
     return numBytes;
 }
 
 int
-OpenFile::WriteAt(char *from, int numBytes, int position)
+OpenFile::DoWriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
+    int *sectors;
     bool firstAligned, lastAligned;
     char *buf;
+    Arena arena;
 
     if ((numBytes <= 0) || (position >= fileLength))
 	return 0;				// check request
@@ -159,29 +482,88 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
     numSectors = 1 + lastSector - firstSector;
 
-    buf = new char[numSectors * SectorSize];
+    firstAligned = (position == (firstSector * SectorSize));
+    lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
+
+    if (buffer->Holds(firstSector, lastSector)) {
+	buffer->Flush();		// so the disk has the latest
+    }
+
+    sectors = (int *) arena.Alloc(numSectors * sizeof(int));
+    for (i = firstSector; i <= lastSector; i++)	
+        sectors[i - firstSector] = hdr->ByteToSector(i * SectorSize);
+
+// whole sectors can be written straight from the caller's buffer
+    if (firstAligned && lastAligned) {
+	kernel->synchDisk->WriteSectors(sectors, numSectors, from);
+	return numBytes;
+    }
+
+    buf = (char *) arena.Alloc(numSectors * SectorSize);
 	
 	// Mp4 mod tag
 	memset(buf, 0, sizeof(char) * numSectors * SectorSize); // dummy operation to keep valgrind happy
 
-    firstAligned = (position == (firstSector * SectorSize));
-    lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
-
 // read in first and last sector, if they are to be partially modified
     if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);	
+        DoReadAt(buf, SectorSize, firstSector * SectorSize);	
     if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize], 
+        DoReadAt(&buf[(lastSector - firstSector) * SectorSize], 
 				SectorSize, lastSector * SectorSize);	
 
 // copy in the bytes we want to change 
     bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
 
 // write modified sectors back
-    for (i = firstSector; i <= lastSector; i++)	
-        kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
-    delete [] buf;
+    kernel->synchDisk->WriteSectors(sectors, numSectors, buf);
+    return numBytes;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::DoBufferedWrite
+// 	Write a portion of a file, starting at "position", with the file
+//	already locked.  Whole sectors are written straight to disk,
+//	but the pieces of sectors at either end go into the write
+//	buffer.  If it has another sector in it, that is written out
+//	first.
+//
+//	"from" -- the buffer containing the data to be written to disk
+//	"numBytes" -- the number of bytes to transfer
+//	"position" -- the offset within the file of the first byte to be
+//			written
+//----------------------------------------------------------------------
+
+int
+OpenFile::DoBufferedWrite(char *from, int numBytes, int position)
+{
+    int fileLength = hdr->FileLength();
+    int sector, offset, chunk;
+    int done = 0;
+
+    if ((numBytes <= 0) || (position >= fileLength))
+	return 0;				// check request
+    if ((position + numBytes) > fileLength)
+	numBytes = fileLength - position;
+
+    while (done < numBytes) {
+	sector = divRoundDown(position + done, SectorSize);
+	offset = (position + done) - sector * SectorSize;
+	if (offset == 0 && numBytes - done >= SectorSize) {
+	    chunk = divRoundDown(numBytes - done, SectorSize) * SectorSize;
+	    if (buffer->Holds(sector, sector + chunk / SectorSize - 1)) {
+		buffer->Discard();	// about to be overwritten
+	    }
+	    DoWriteAt(from + done, chunk, position + done);
+	} else {
+	    chunk = min(numBytes - done, SectorSize - offset);
+	    if (!buffer->Holds(sector, sector)) {
+		buffer->Flush();
+		buffer->Start(sector, hdr->ByteToSector(sector * SectorSize));
+	    }
+	    buffer->Write(from + done, chunk, offset);
+	}
+	done += chunk;
+    }
     return numBytes;
 }
 
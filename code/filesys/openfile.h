@@ -9,9 +9,15 @@
 //
 //	The other is the "real" implementation, that turns these
 //	operations into read and write disk sector requests. 
-//	In this baseline implementation of the file system, we don't 
-//	worry about concurrent accesses to the file system
-//	by different threads.
+//	Concurrent reads of a file can go on at once, but a write
+//	excludes everyone else using the same file.
+//
+//	Small writes through Write() are kept in a buffer of one
+//	sector per file, and written to disk when the writer moves on
+//	to another sector, closes the file or asks for a Sync().  So
+//	a program writing a byte at a time does about one disk write
+//	per sector, rather than a read and a write per byte.  WriteAt()
+//	still writes straight through.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -53,6 +59,7 @@ class OpenFile {
 		}
 
     int Length() { Lseek(file, 0, 2); return Tell(file); }
+    void Sync() {}			// nothing is buffered
     
   private:
     int file;
@@ -60,7 +67,74 @@ class OpenFile {
 };
 
 #else // FILESYS
+#include "disk.h"
+
 class FileHeader;
+class Lock;
+class RWLock;
+
+// The following class holds the part of a sector of a file that has
+// been written, but not yet written to disk.  It is shared by every
+// OpenFile of the file, and protected by the file's lock.
+
+class WriteBuffer {
+  public:
+    WriteBuffer() { sector = -1; }
+
+    bool IsDirty() { return sector >= 0; }
+    bool Holds(int first, int last) { return sector >= first && sector <= last; }
+    				// is a sector from "first" to "last"
+				// (of the file) buffered?
+    void Start(int fileSector, int diskSector);
+    				// buffer writes to another sector;
+				// must not be dirty
+    void Write(char *from, int numBytes, int offset);
+    				// buffer bytes of the current sector
+    void Read(char *into, int numBytes, int position);
+    				// copy in any buffered bytes of a read
+    void Flush();		// write the sector to disk
+    void Discard() { sector = -1; }	// throw it away
+
+  private:
+    int sector;			// which sector of the file, or -1
+    int diskSector;		// where it goes on disk
+    int validFrom, validTo;	// the bytes of it we have
+    char data[SectorSize];
+
+    void Fill();		// get the rest of the sector from disk
+};
+
+// The following class keeps a reader-writer lock for each file (or
+// directory) that someone is using, keyed by the sector holding its
+// file header.  Locks are made when first asked for, and thrown away
+// when the last user is done with them.
+
+class SectorLock {
+  public:
+    RWLock *rwLock;
+    WriteBuffer *buffer;		// made when first asked for
+    int refs;				// users of "rwLock"
+};
+
+class SectorLockTable {
+  public:
+    SectorLockTable(char *debugName);
+    ~SectorLockTable();
+
+    RWLock *Get(int sector);		// Find or make the lock for "sector"
+    void Put(int sector);		// Done with it; nobody may hold it
+    WriteBuffer *Buffer(int sector);	// The write buffer for "sector";
+					// it must be in use
+    void Sync();			// Flush every write buffer
+
+  private:
+    char *name;
+    Lock *lock;				// Protects "locks"
+    map<int, SectorLock> locks;
+};
+
+extern SectorLockTable *fileLocks;	// Locks on file contents, used
+					// by every OpenFile
 
 class OpenFile {
   public:
@@ -88,9 +162,26 @@ class OpenFile {
 					// end of file, tell, lseek back 
     int GetFd();
     int SetFd(int fd);
+    int HeaderSector() { return hdrSector; }
+					// Where the file header lives; this
+					// identifies the file on disk
+    void Sync();			// Write any buffered data to disk
+
   private:
+    int DoReadAt(char *into, int numBytes, int position);
+    int DoWriteAt(char *from, int numBytes, int position);
+					// ReadAt/WriteAt, with the file
+					// already locked
+    int DoBufferedWrite(char *from, int numBytes, int position);
+					// Write, likewise
+
     FileHeader *hdr;			// Header for this file 
+    int hdrSector;			// Disk sector holding "hdr"
     int seekPosition;			// Current position within the file
+    RWLock *rwLock;			// Many readers, or one writer, at a
+					// time, shared by every OpenFile of
+					// this file
+    WriteBuffer *buffer;		// Likewise
 };
 
 #endif // FILESYS
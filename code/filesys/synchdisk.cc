@@ -8,7 +8,8 @@
 //	Use a semaphore to synchronize the interrupt handlers with the
 //	pending requests.  And, because the physical disk can only
 //	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	exclusion.  When there are several disks, each has its own
+//	semaphore and lock.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,20 +17,79 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "diskmirror.h"
+#include "main.h"
 
 
+//----------------------------------------------------------------------
+// DiskUnit::DiskUnit
+// 	Initialize one of the disks of a volume.
+//
+//	"unit" -- the disk's number, or -1 if the machine has just one
+//----------------------------------------------------------------------
+
+DiskUnit::DiskUnit(int unit)
+{
+    semaphore = new Semaphore("synch disk", 0);
+    lock = new Lock("synch disk lock");
+    disk = new Disk(this, unit);
+    notify = NULL;
+    finished = FALSE;
+    requests = 0;
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::~DiskUnit
+// 	De-allocate one of the disks of a volume.
+//----------------------------------------------------------------------
+
+DiskUnit::~DiskUnit()
+{
+    delete disk;
+    delete lock;
+    delete semaphore;
+}
+
+//----------------------------------------------------------------------
+// DiskUnit::CallBack
+// 	Disk interrupt handler.  Wake up any thread waiting for the disk
+//	request to finish.
+//----------------------------------------------------------------------
+
+void
+DiskUnit::CallBack()
+{ 
+    if (notify != NULL) {		// a transfer over several disks
+	finished = TRUE;
+	notify->V();
+    } else {
+	semaphore->V();
+    }
+}
+
 //----------------------------------------------------------------------
 // SynchDisk::SynchDisk
 // 	Initialize the synchronous interface to the physical disk, in turn
 //	initializing the physical disk.
 //
+//	"n" -- how many disks to stripe the sectors across.  With just
+//		one, we use the machine's usual disk file.
+//	"unit" -- how many consecutive sectors go on each disk in turn
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk()
+SynchDisk::SynchDisk(int n, int unit)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
-    disk = new Disk(this);
+    ASSERT(n > 0 && n <= MaxDisks && unit > 0);
+    numDisks = n;
+    stripeUnit = unit;
+    if (numDisks == 1) {
+	units[0] = new DiskUnit(-1);
+    } else {
+	for (int i = 0; i < numDisks; i++) {
+	    units[i] = new DiskUnit(i);
+	}
+    }
+    mirror = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -40,9 +100,143 @@ SynchDisk::SynchDisk()
 
 SynchDisk::~SynchDisk()
 {
-    delete disk;
-    delete lock;
-    delete semaphore;
+    for (int i = 0; i < numDisks; i++) {
+	delete units[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::UnitOf, SynchDisk::PhysicalSector
+// 	Map a sector of the volume to the disk it is on, and to its
+//	sector number on that disk.
+//----------------------------------------------------------------------
+
+int
+SynchDisk::UnitOf(int sector)
+{
+    return (sector / stripeUnit) % numDisks;
+}
+
+int
+SynchDisk::PhysicalSector(int sector)
+{
+    return (sector / (stripeUnit * numDisks)) * stripeUnit
+		+ sector % stripeUnit;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Transfer
+// 	Read or write a list of sectors.  We start a request on every
+//	disk that has some to do, so the disks work in parallel; then,
+//	as each disk finishes, we start its next one.  The disks all
+//	signal one semaphore, so we don't keep a disk idle while we
+//	wait for a slower one.
+//
+//	We hold the locks of just the disks the sectors are on, for the
+//	whole transfer, so a transfer to other disks can go on at the
+//	same time.  The locks are always acquired in order of disk
+//	number, so this can't deadlock.
+//
+//	In untimed mode, each request is done when the disk returns,
+//	so there is no interrupt to wait for.
+//
+//	"sectors" -- the sectors of the volume to read/write
+//	"count" -- how many there are
+//	"data" -- "count" sectors worth of buffer
+//	"writing" -- TRUE to write, FALSE to read
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Transfer(int *sectors, int count, char *data, bool writing)
+{
+    int next[MaxDisks];			// next of "sectors" for each disk
+    bool used[MaxDisks];		// does the transfer touch this disk?
+    Semaphore anyDone("synch disk transfer", 0);
+    int i, u, done;
+    DiskUnit *d;
+
+    if (count == 1) {			// the common case: only one disk
+	d = units[UnitOf(sectors[0])];
+	d->lock->Acquire();		// only one disk I/O at a time
+	d->requests++;
+	if (writing) {
+	    d->disk->WriteRequest(PhysicalSector(sectors[0]), data);
+	} else {
+	    d->disk->ReadRequest(PhysicalSector(sectors[0]), data);
+	}
+	if (!kernel->untimed) {
+	    d->semaphore->P();		// wait for interrupt
+	}
+	d->lock->Release();
+	return;
+    }
+
+    for (u = 0; u < numDisks; u++) {
+	used[u] = FALSE;
+    }
+    for (i = 0; i < count; i++) {
+	used[UnitOf(sectors[i])] = TRUE;
+    }
+    for (u = 0; u < numDisks; u++) {
+	next[u] = -1;
+	if (used[u]) {
+	    units[u]->lock->Acquire();
+	    units[u]->notify = &anyDone;
+	    StartNext(sectors, count, data, writing, u, &next[u]);
+	}
+    }
+    for (done = 0; done < count; ) {
+	if (!kernel->untimed) {
+	    anyDone.P();		// wait for some disk's interrupt
+	}
+	for (u = 0; u < numDisks; u++) {
+	    d = units[u];
+	    if (used[u] && next[u] < count
+			&& (d->finished || kernel->untimed)) {
+		d->finished = FALSE;
+		done++;
+		StartNext(sectors, count, data, writing, u, &next[u]);
+	    }
+	}
+    }
+    for (u = numDisks - 1; u >= 0; u--) {
+	if (used[u]) {
+	    units[u]->notify = NULL;
+	    units[u]->lock->Release();
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartNext
+// 	Start the next request of a transfer that is on disk "u", if
+//	there is one.
+//
+//	"next" -- on entry, the last of "sectors" started on the disk
+//		(-1 at first); on return, the one just started, or
+//		"count" if the disk has no more to do
+//----------------------------------------------------------------------
+
+void
+SynchDisk::StartNext(int *sectors, int count, char *data, bool writing,
+						int u, int *next)
+{
+    DiskUnit *d = units[u];
+    int i;
+
+    for (i = *next + 1; i < count && UnitOf(sectors[i]) != u; i++)
+	;
+    *next = i;
+    if (i < count) {
+	d->requests++;
+	if (writing) {
+	    d->disk->WriteRequest(PhysicalSector(sectors[i]),
+					&data[i * SectorSize]);
+	} else {
+	    d->disk->ReadRequest(PhysicalSector(sectors[i]),
+					&data[i * SectorSize]);
+	}
+    }
 }
 
 //----------------------------------------------------------------------
@@ -57,10 +251,10 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-  semaphore->P();			// wait for interrupt
-    lock->Release();
+    if (mirror != NULL && mirror->Read(sectorNumber, data)) {
+	return;				// the replica had it
+    }
+    Transfer(&sectorNumber, 1, data, FALSE);
 }
 
 //----------------------------------------------------------------------
@@ -75,20 +269,69 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    Transfer(&sectorNumber, 1, data, TRUE);
+    if (mirror != NULL) {
+	mirror->Write(sectorNumber, data);
+    }
 }
 
 //----------------------------------------------------------------------
-// SynchDisk::CallBack
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// SynchDisk::ReadSectors
+// 	Read several sectors into a buffer, using all the disks at once.
+//	Return only after all the data has been read.
+//
+//	"sectors" -- the disk sectors to read
+//	"count" -- how many of them
+//	"data" -- the buffer to hold their contents, one after another
 //----------------------------------------------------------------------
 
 void
-SynchDisk::CallBack()
-{ 
-    semaphore->V();
+SynchDisk::ReadSectors(int *sectors, int count, char *data)
+{
+    if (mirror != NULL) {		// let the mirror take its share
+	for (int i = 0; i < count; i++) {
+	    ReadSector(sectors[i], &data[i * SectorSize]);
+	}
+    } else if (count > 0) {
+	Transfer(sectors, count, data, FALSE);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	Write several sectors from a buffer, using all the disks at once.
+//	Return only after all the data has been written.
+//
+//	"sectors" -- the disk sectors to write
+//	"count" -- how many of them
+//	"data" -- their new contents, one after another
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteSectors(int *sectors, int count, char *data)
+{
+    if (count > 0) {
+	Transfer(sectors, count, data, TRUE);
+    }
+    if (mirror != NULL) {
+	for (int i = 0; i < count; i++) {
+	    mirror->Write(sectors[i], &data[i * SectorSize]);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Print
+// 	Print how many requests went to each disk.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Print()
+{
+    cout << "Disk volume: " << numDisks << " disks, stripe unit "
+	<< stripeUnit << " sectors, requests:";
+    for (int i = 0; i < numDisks; i++) {
+	cout << " " << units[i]->requests;
+    }
+    cout << "\n";
 }
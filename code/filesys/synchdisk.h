@@ -15,6 +15,35 @@
 #include "synch.h"
 #include "callback.h"
 
+class DiskMirror;
+
+#define MaxDisks		8	// most disks one machine can have
+#define DefaultStripeUnit	8	// sectors per stripe unit
+
+// One of the physical disks behind a SynchDisk.  Each has its own
+// lock and semaphore, so that requests to different disks can be
+// outstanding at the same time.
+
+class DiskUnit : public CallBackObj {
+  public:
+    DiskUnit(int unit);			// unit < 0 for a machine's only disk
+    ~DiskUnit();
+
+    void CallBack();			// Called by the disk device interrupt
+					// handler, to signal that the
+					// current disk operation is complete.
+
+    Disk *disk;		  		// Raw disk device
+    Semaphore *semaphore; 		// To synchronize requesting thread 
+					// with the interrupt handler
+    Lock *lock;		  		// Only one read/write request
+					// can be sent to the disk at a time
+    Semaphore *notify;			// If not NULL, signal this instead,
+    bool finished;			// and set "finished", so a transfer
+					// can wait for any of its disks
+    int requests;			// Requests sent to this disk
+};
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -25,11 +54,21 @@
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
 // returning.
+//
+// A SynchDisk can also be a volume made of several disks, with the
+// sectors striped across them (RAID-0): the first "stripeUnit" sectors
+// are on disk 0, the next "stripeUnit" on disk 1, and so on.  The
+// volume has the same NumSectors sectors as a single disk, so the file
+// system can't tell the difference.  ReadSectors and WriteSectors keep
+// every disk that has part of the request busy at once, so large
+// transfers go faster with more disks; and requests that land on
+// different disks don't wait for each other.
 
-class SynchDisk : public CallBackObj {
+class SynchDisk {
   public:
-    SynchDisk();    		        // Initialize a synchronous disk,
-					// by initializing the raw Disk.
+    SynchDisk(int numDisks = 1, int stripeUnit = DefaultStripeUnit);
+					// Initialize a synchronous disk,
+					// by initializing the raw Disk(s).
     ~SynchDisk();			// De-allocate the synch disk data
     
     void ReadSector(int sectorNumber, char* data);
@@ -39,17 +78,33 @@ class SynchDisk : public CallBackObj {
     					// Disk::ReadRequest/WriteRequest and
 					// then wait until the request is done.
     void WriteSector(int sectorNumber, char* data);
-    
-    void CallBack();			// Called by the disk device interrupt
-					// handler, to signal that the
-					// current disk operation is complete.
+
+    void ReadSectors(int *sectors, int count, char *data);
+    void WriteSectors(int *sectors, int count, char *data);
+					// Read/write "count" sectors, to or
+					// from consecutive parts of "data"
+
+    void SetMirror(DiskMirror *m) { mirror = m; }
+					// Copy every write to "m" from now on,
+					// and let it serve some of the reads
+
+    void Print();			// Print requests sent to each disk
+    int NumDisks() { return numDisks; }	// How many disks in the volume
 
   private:
-    Disk *disk;		  		// Raw disk device
-    Semaphore *semaphore; 		// To synchronize requesting thread 
-					// with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-					// can be sent to the disk at a time
+    int UnitOf(int sector);		// Which disk "sector" is on
+    int PhysicalSector(int sector);	// Where on that disk
+    void Transfer(int *sectors, int count, char *data, bool writing);
+					// Do the requests, on all their
+					// disks at once
+    void StartNext(int *sectors, int count, char *data, bool writing,
+						int u, int *next);
+					// Start disk "u" on its next one
+
+    DiskUnit *units[MaxDisks];		// The disks in the volume
+    int numDisks;
+    int stripeUnit;			// Sectors per disk before moving on
+    DiskMirror *mirror;			// Replica of this disk, or NULL
 };
 
 #endif // SYNCHDISK_H
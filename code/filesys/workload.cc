@@ -0,0 +1,636 @@
+// workload.cc
+//	Routines to run a file system benchmark, and report how it did.
+//	See workload.h for how a workload is described.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILESYS_STUB
+
+#include "copyright.h"
+#include "workload.h"
+#include "main.h"
+#include "filesys.h"
+#include "openfile.h"
+#include "synch.h"
+#include "sysdep.h"
+#include <math.h>
+
+const int WorkloadDirSize = 256;	// room for a directory, as for -mkdir
+const int MaxWorkloadDirs = 9;		// the root directory holds 10 names
+
+// What a workload thread is started with
+
+class WorkloadStart {
+  public:
+    Workload *workload;
+    int id;
+    unsigned int seed;
+};
+
+//----------------------------------------------------------------------
+// WorkloadRandom::Next, Below, Fraction
+// 	Draw the next random number: any 32-bit number, one from 0 to
+//	n - 1, or one in [0, 1).
+//----------------------------------------------------------------------
+
+unsigned int
+WorkloadRandom::Next()
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+int
+WorkloadRandom::Below(int n)
+{
+    ASSERT(n > 0);
+    return Next() % n;
+}
+
+double
+WorkloadRandom::Fraction()
+{
+    return Next() / 4294967296.0;
+}
+
+//----------------------------------------------------------------------
+// CompareTicks
+// 	Ordering for qsort: latencies, shortest first.
+//----------------------------------------------------------------------
+
+static int
+CompareTicks(const void *a, const void *b)
+{
+    return *(int *) a - *(int *) b;
+}
+
+//----------------------------------------------------------------------
+// WorkloadThread
+// 	Where each thread of the workload starts.  C++ doesn't (easily)
+//	let us fork a member function.
+//----------------------------------------------------------------------
+
+static void
+WorkloadThread(void *arg)
+{
+    WorkloadStart *start = (WorkloadStart *) arg;
+
+    start->workload->Worker(start->id, start->seed);
+}
+
+//----------------------------------------------------------------------
+// Workload::Workload
+// 	Initialize the default workload: a few threads reading and
+//	writing a few dozen small files.
+//----------------------------------------------------------------------
+
+Workload::Workload()
+{
+    numThreads = 4;
+    opsPerThread = 100;
+    seed = 1;
+    numDirs = 4;
+    filesPerDir = 8;
+    prealloc = 50;
+    sizeDistribution = SizeFixed;
+    sizeA = 1024;
+    sizeB = 0;
+    mix[WorkloadRead] = 60;
+    mix[WorkloadWrite] = 20;
+    mix[WorkloadCreate] = 10;
+    mix[WorkloadDelete] = 10;
+    sequential = FALSE;
+    ioSize = 128;
+
+    files = NULL;
+    numFiles = 0;
+    numDirsMade = 0;
+    filesLock = NULL;
+    done = NULL;
+    for (int i = 0; i < NumWorkloadOps; i++) {
+	latencies[i] = NULL;
+	numLatencies[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// Workload::~Workload
+// 	De-allocate what was left from the last run.
+//----------------------------------------------------------------------
+
+Workload::~Workload()
+{
+    delete [] files;
+    delete filesLock;
+    delete done;
+    for (int i = 0; i < NumWorkloadOps; i++) {
+	delete [] latencies[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// Workload::Load
+// 	Read the settings from a spec file on the host.  See workload.h
+//	for what it looks like.
+//
+//	"specFile" -- the UNIX file name
+//----------------------------------------------------------------------
+
+bool
+Workload::Load(char *specFile)
+{
+    char *text, *line, *next, *comment;
+    char name[16];
+    int fd, length, used;
+    bool ok = TRUE;
+
+    if ((fd = OpenForReadWrite(specFile, FALSE)) < 0) {
+	cerr << "Workload: can't open " << specFile << "\n";
+	return FALSE;
+    }
+    Lseek(fd, 0, 2);
+    length = Tell(fd);
+    Lseek(fd, 0, 0);
+    text = new char[length + 1];
+    Read(fd, text, length);
+    text[length] = '\0';
+    Close(fd);
+
+    for (line = text; ok && line != NULL; line = next) {
+	next = strchr(line, '\n');
+	if (next != NULL) {
+	    *next++ = '\0';
+	}
+	if ((comment = strchr(line, '#')) != NULL) {
+	    *comment = '\0';
+	}
+	if (sscanf(line, "%15s %n", name, &used) == 1) {
+	    ok = Setting(name, line + used);
+	}
+    }
+    delete [] text;
+    return ok && Check();
+}
+
+//----------------------------------------------------------------------
+// Workload::Setting
+// 	Take one setting from the spec file.  Returns FALSE if we don't
+//	understand it.
+//
+//	"name" -- what to set
+//	"args" -- the rest of the line
+//----------------------------------------------------------------------
+
+bool
+Workload::Setting(char *name, char *args)
+{
+    char word[16];
+    int n = 1;
+
+    word[0] = '\0';			// in case there are no arguments
+    if (strcmp(name, "threads") == 0) {
+	n = sscanf(args, "%d", &numThreads);
+    } else if (strcmp(name, "ops") == 0) {
+	n = sscanf(args, "%d", &opsPerThread);
+    } else if (strcmp(name, "seed") == 0) {
+	n = sscanf(args, "%d", &seed);
+    } else if (strcmp(name, "dirs") == 0) {
+	n = sscanf(args, "%d", &numDirs);
+    } else if (strcmp(name, "files") == 0) {
+	n = sscanf(args, "%d", &filesPerDir);
+    } else if (strcmp(name, "prealloc") == 0) {
+	n = sscanf(args, "%d", &prealloc);
+    } else if (strcmp(name, "iosize") == 0) {
+	n = sscanf(args, "%d", &ioSize);
+    } else if (strcmp(name, "mix") == 0) {
+	n = (sscanf(args, "%d %d %d %d", &mix[WorkloadRead],
+		&mix[WorkloadWrite], &mix[WorkloadCreate],
+		&mix[WorkloadDelete]) == 4);
+    } else if (strcmp(name, "access") == 0) {
+	n = (sscanf(args, "%15s", word) == 1);
+	if (strcmp(word, "sequential") == 0) {
+	    sequential = TRUE;
+	} else if (strcmp(word, "random") == 0) {
+	    sequential = FALSE;
+	} else {
+	    n = 0;
+	}
+    } else if (strcmp(name, "size") == 0) {
+	n = sscanf(args, "%15s %d %d", word, &sizeA, &sizeB);
+	if (strcmp(word, "fixed") == 0 && n >= 2) {
+	    sizeDistribution = SizeFixed;
+	} else if (strcmp(word, "uniform") == 0 && n == 3) {
+	    sizeDistribution = SizeUniform;
+	} else if (strcmp(word, "exp") == 0 && n == 3) {
+	    sizeDistribution = SizeExponential;
+	} else {
+	    n = 0;
+	}
+    } else {
+	cerr << "Workload: unknown setting " << name << "\n";
+	return FALSE;
+    }
+    if (n < 1) {
+	cerr << "Workload: bad " << name << " setting: " << args << "\n";
+	return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Workload::Check
+// 	Make sure the settings make sense, and that the files will fit
+//	in the directories.
+//----------------------------------------------------------------------
+
+bool
+Workload::Check()
+{
+    int total = 0;
+
+    for (int i = 0; i < NumWorkloadOps; i++) {
+	if (mix[i] < 0) {
+	    total = -1;
+	    break;
+	}
+	total += mix[i];
+    }
+    if (numThreads < 1 || opsPerThread < 0 || total != 100
+	    || numDirs < 1 || numDirs > MaxWorkloadDirs
+	    || filesPerDir < 1 || filesPerDir > MaxWorkloadDirs + 1
+	    || prealloc < 0 || prealloc > 100 || ioSize < 1 || sizeA < 1
+	    || (sizeDistribution != SizeFixed && sizeB < sizeA)) {
+	cerr << "Workload: settings out of range (the mix must add up to "
+	     << "100, and there can be at most " << MaxWorkloadDirs
+	     << " dirs of " << MaxWorkloadDirs + 1 << " files)\n";
+	return FALSE;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Workload::DirName, Workload::FileName
+// 	The names of the workload's directories and files.  "name" must
+//	have room for 16 characters.
+//----------------------------------------------------------------------
+
+void
+Workload::DirName(int dir, char *name)
+{
+    sprintf(name, "/wl%d/", dir);
+}
+
+void
+Workload::FileName(int file, char *name)
+{
+    sprintf(name, "/wl%d/f%d", file / filesPerDir, file % filesPerDir);
+}
+
+//----------------------------------------------------------------------
+// Workload::PickSize
+// 	Choose how big a new file will be.
+//----------------------------------------------------------------------
+
+int
+Workload::PickSize(WorkloadRandom *random)
+{
+    int size;
+
+    switch (sizeDistribution) {
+      case SizeUniform:
+	return sizeA + random->Below(sizeB - sizeA + 1);
+      case SizeExponential:
+	size = (int) (-sizeA * log(1.0 - random->Fraction()));
+	return max(1, min(size, sizeB));
+      default:
+	return sizeA;
+    }
+}
+
+//----------------------------------------------------------------------
+// Workload::PickFile
+// 	Choose a file to work on: the first one, from a random place,
+//	that no one else is using, and that exists (or doesn't, for a
+//	create).  It is marked busy until the caller is done with it.
+//
+//	Returns -1 if there is no such file.
+//----------------------------------------------------------------------
+
+int
+Workload::PickFile(WorkloadRandom *random, bool existing)
+{
+    int first = random->Below(numFiles);
+    int file, found = -1;
+
+    filesLock->Acquire();
+    for (int i = 0; i < numFiles; i++) {
+	file = (first + i) % numFiles;
+	if (files[file].exists == existing && !files[file].busy) {
+	    files[file].busy = TRUE;
+	    found = file;
+	    break;
+	}
+    }
+    filesLock->Release();
+    return found;
+}
+
+//----------------------------------------------------------------------
+// Workload::CreateFile
+// 	Create a file, and write it all the way through.
+//
+//	"file" -- which one
+//	"size" -- how big
+//	"buffer" -- "ioSize" bytes to write
+//----------------------------------------------------------------------
+
+bool
+Workload::CreateFile(int file, int size, char *buffer)
+{
+    char name[16];
+    OpenFile *openFile;
+    int offset, n;
+    bool ok = TRUE;
+
+    FileName(file, name);
+    if (!kernel->fileSystem->Create(name, size)) {
+	return FALSE;
+    }
+    files[file].exists = TRUE;
+    files[file].size = size;
+    if ((openFile = kernel->fileSystem->Open(name)) == NULL) {
+	return FALSE;
+    }
+    for (offset = 0; offset < size; offset += ioSize) {
+	n = min(ioSize, size - offset);
+	if (openFile->WriteAt(buffer, n, offset) != n) {
+	    ok = FALSE;
+	    break;
+	}
+	bytesWritten += n;
+    }
+    delete openFile;
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// Workload::Transfer
+// 	Read or write an existing file: all of it, or "ioSize" bytes at
+//	a random place in it.
+//----------------------------------------------------------------------
+
+bool
+Workload::Transfer(WorkloadOp op, int file, char *buffer,
+			WorkloadRandom *random)
+{
+    char name[16];
+    OpenFile *openFile;
+    int size = files[file].size;
+    int offset, end, n, done;
+    bool ok = TRUE;
+
+    FileName(file, name);
+    if ((openFile = kernel->fileSystem->Open(name)) == NULL) {
+	return FALSE;
+    }
+    if (sequential) {
+	offset = 0;
+	end = size;
+    } else {
+	offset = random->Below(divRoundUp(size, ioSize)) * ioSize;
+	end = min(offset + ioSize, size);
+    }
+    for (; offset < end; offset += ioSize) {
+	n = min(ioSize, end - offset);
+	if (op == WorkloadRead) {
+	    done = openFile->ReadAt(buffer, n, offset);
+	    bytesRead += done;
+	} else {
+	    done = openFile->WriteAt(buffer, n, offset);
+	    bytesWritten += done;
+	}
+	if (done != n) {
+	    ok = FALSE;
+	    break;
+	}
+    }
+    delete openFile;
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// Workload::Worker
+// 	Do one thread's share of the workload, timing each operation.
+//
+//	"id" -- which thread this is
+//	"threadSeed" -- to seed its random number generator
+//----------------------------------------------------------------------
+
+void
+Workload::Worker(int id, unsigned int threadSeed)
+{
+    WorkloadRandom random(threadSeed);
+    char *buffer = new char[ioSize];
+    char name[16];
+    int i, file, choice, start;
+    WorkloadOp op;
+    bool ok;
+
+    memset(buffer, 'a' + id % 26, ioSize);
+    for (i = 0; i < opsPerThread; i++) {
+	choice = random.Below(100);
+	for (op = WorkloadRead; choice >= mix[op]; op = (WorkloadOp) (op + 1)) {
+	    choice -= mix[op];
+	}
+	file = PickFile(&random, op != WorkloadCreate);
+	if (file < 0) {
+	    numSkipped++;
+	    continue;
+	}
+
+	start = kernel->stats->totalTicks;
+	switch (op) {
+	  case WorkloadCreate:
+	    ok = CreateFile(file, PickSize(&random), buffer);
+	    break;
+	  case WorkloadDelete:
+	    FileName(file, name);
+	    ok = kernel->fileSystem->Remove(name);
+	    files[file].exists = !ok;
+	    break;
+	  default:
+	    ok = Transfer(op, file, buffer, &random);
+	    break;
+	}
+	latencies[op][numLatencies[op]++] = kernel->stats->totalTicks - start;
+	if (!ok) {
+	    numFailed++;
+	}
+	files[file].busy = FALSE;
+    }
+    delete [] buffer;
+    done->V();
+}
+
+//----------------------------------------------------------------------
+// Workload::RemoveAll
+// 	Remove the files and directories we created.  Returns FALSE if
+//	any of them couldn't be.
+//----------------------------------------------------------------------
+
+bool
+Workload::RemoveAll()
+{
+    char name[16];
+    bool ok = TRUE;
+
+    for (int i = 0; i < numFiles; i++) {
+	if (files[i].exists) {
+	    FileName(i, name);
+	    ok = kernel->fileSystem->Remove(name) && ok;
+	    files[i].exists = FALSE;
+	}
+    }
+    for (; numDirsMade > 0; numDirsMade--) {
+	DirName(numDirsMade - 1, name);
+	ok = kernel->fileSystem->Remove(name) && ok;
+    }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// Workload::PrintLatencies
+// 	Print how long one kind of operation took, in ticks: the mean,
+//	the 50th, 90th and 99th percentiles, and the longest.
+//----------------------------------------------------------------------
+
+void
+Workload::PrintLatencies(WorkloadOp op, char *name)
+{
+    int n = numLatencies[op];
+    int *ticks = latencies[op];
+    double total = 0;
+
+    cout << "\t" << name << "\t" << n;
+    if (n == 0) {
+	cout << "\n";
+	return;
+    }
+    qsort(ticks, n, sizeof(int), CompareTicks);
+    for (int i = 0; i < n; i++) {
+	total += ticks[i];
+    }
+    cout << "\t" << (int) (total / n) << "\t" << ticks[n * 50 / 100]
+	<< "\t" << ticks[n * 90 / 100] << "\t" << ticks[n * 99 / 100]
+	<< "\t" << ticks[n - 1] << "\n";
+}
+
+//----------------------------------------------------------------------
+// Workload::Run
+// 	Set up the files, run the threads, and wait for them all to
+//	finish; then print the results and clean up.  The set up isn't
+//	counted.
+//----------------------------------------------------------------------
+
+void
+Workload::Run()
+{
+    WorkloadStart *starts = new WorkloadStart[numThreads];
+    char name[16], *buffer;
+    int i, startTicks, elapsed, diskReads, diskWrites, totalOps;
+    bool ok = TRUE;
+
+    RandomInit(seed);
+    WorkloadRandom setup(RandomNumber());
+
+    numFiles = numDirs * filesPerDir;
+    files = new WorkloadFile[numFiles];
+    for (i = 0; i < numFiles; i++) {
+	files[i].exists = files[i].busy = FALSE;
+	files[i].size = 0;
+    }
+    filesLock = new Lock("workload files");
+    done = new Semaphore("workload done", 0);
+    for (i = 0; i < NumWorkloadOps; i++) {
+	latencies[i] = new int[numThreads * opsPerThread];
+	numLatencies[i] = 0;
+    }
+    bytesRead = bytesWritten = numSkipped = numFailed = 0;
+
+    buffer = new char[ioSize];
+    memset(buffer, 'z', ioSize);
+    for (i = 0; i < numDirs && ok; i++) {
+	DirName(i, name);
+	ok = kernel->fileSystem->Create(name, WorkloadDirSize);
+	if (ok) {
+	    numDirsMade++;
+	}
+    }
+    for (i = 0; i < numFiles && ok; i++) {
+	if (setup.Below(100) < prealloc) {
+	    FileName(i, name);		// to say which, if it fails
+	    ok = CreateFile(i, PickSize(&setup), buffer);
+	}
+    }
+    delete [] buffer;
+    if (!ok) {
+	cerr << "Workload: couldn't create " << name
+	     << " (is the disk formatted and empty?)\n";
+	RemoveAll();
+	delete [] starts;
+	return;
+    }
+    bytesWritten = 0;
+
+    startTicks = kernel->stats->totalTicks;
+    diskReads = kernel->stats->numDiskReads;
+    diskWrites = kernel->stats->numDiskWrites;
+    for (i = 0; i < numThreads; i++) {
+	starts[i].workload = this;
+	starts[i].id = i;
+	starts[i].seed = RandomNumber();
+	Thread *t = new Thread("workload", 1);
+	t->Fork(WorkloadThread, (void *) &starts[i]);
+    }
+    for (i = 0; i < numThreads; i++) {
+	done->P();
+    }
+    elapsed = kernel->stats->totalTicks - startTicks;
+    diskReads = kernel->stats->numDiskReads - diskReads;
+    diskWrites = kernel->stats->numDiskWrites - diskWrites;
+    delete [] starts;
+
+    totalOps = 0;
+    for (i = 0; i < NumWorkloadOps; i++) {
+	totalOps += numLatencies[i];
+    }
+    cout << "Workload: " << numThreads << " threads of " << opsPerThread
+	<< " operations, seed " << seed << ", " << numFiles << " files, "
+	<< (sequential ? "sequential" : "random") << " I/O of "
+	<< ioSize << " bytes\n";
+    cout << "\t" << totalOps << " operations in " << elapsed << " ticks ("
+	<< (elapsed > 0 ? 1000.0 * totalOps / elapsed : 0)
+	<< " per 1000 ticks), " << numSkipped << " skipped, "
+	<< numFailed << " failed\n";
+    cout << "\t" << bytesRead << " bytes read, " << bytesWritten
+	<< " written (" << (elapsed > 0 ?
+		(double) (bytesRead + bytesWritten) / elapsed : 0)
+	<< " bytes per tick)\n";
+    cout << "\tdisk requests: " << diskReads << " reads, " << diskWrites
+	<< " writes\n";
+    cout << "\tticks\tcount\tmean\t50%\t90%\t99%\tmax\n";
+    PrintLatencies(WorkloadRead, "read");
+    PrintLatencies(WorkloadWrite, "write");
+    PrintLatencies(WorkloadCreate, "create");
+    PrintLatencies(WorkloadDelete, "delete");
+
+    if (!RemoveAll()) {
+	cerr << "Workload: couldn't remove all the files afterwards\n";
+    }
+}
+
+#endif // FILESYS_STUB
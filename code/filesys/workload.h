@@ -0,0 +1,147 @@
+// workload.h
+//	Data structures for benchmarking the file system with a
+//	scripted workload, run by kernel threads, in the style of
+//	filebench or fio on UNIX.
+//
+//	The workload is described by a spec file on the host (-fsw),
+//	one setting per line; '#' starts a comment.  Anything not given
+//	keeps its default:
+//
+//	    threads 4		kernel threads doing operations
+//	    ops 100		operations each thread does
+//	    seed 1		for RandomInit
+//	    dirs 4		directories under the root (/wl0, /wl1, ...)
+//	    files 8		file names in each (a directory holds 10)
+//	    prealloc 50		percent of the files that exist before
+//				the run starts
+//	    size fixed 1024	how big a new file is: "fixed N",
+//				"uniform MIN MAX", or "exp MEAN MAX"
+//				(exponentially distributed, up to MAX)
+//	    mix 60 20 10 10	percent of reads, writes, creates and
+//				deletes
+//	    access random	"random": a read or write moves iosize
+//				bytes at a random place in the file;
+//				"sequential": the whole file, iosize
+//				bytes at a time
+//	    iosize 128		bytes per ReadAt or WriteAt
+//
+//	A create also writes the new file all the way through.
+//
+//	Each thread makes its choices with a random number generator of
+//	its own, seeded in turn from RandomInit's.  Since Nachos always
+//	interleaves the threads the same way, the same spec gives the
+//	same run, so the effect of a change to the file system can be
+//	measured fairly.  The files are removed afterwards, so each run
+//	starts from the same disk.
+//
+//	At the end we print the throughput, the latency of each kind of
+//	operation in ticks (mean, percentiles, worst), and how many
+//	disk requests there were.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Lock;
+class Semaphore;
+class OpenFile;
+
+// The kinds of operation, in the order "mix" gives them
+
+enum WorkloadOp { WorkloadRead, WorkloadWrite, WorkloadCreate,
+			WorkloadDelete, NumWorkloadOps };
+
+// How the sizes of new files are chosen
+
+enum SizeDistribution { SizeFixed, SizeUniform, SizeExponential };
+
+// A random number generator for one thread of the workload, so that
+// its choices don't depend on anyone else's (xorshift).
+
+class WorkloadRandom {
+  public:
+    WorkloadRandom(unsigned int seed) { state = (seed != 0) ? seed : 1; }
+
+    unsigned int Next();		// the next number
+    int Below(int n);			// one from 0 to n - 1
+    double Fraction();			// one in [0, 1)
+
+  private:
+    unsigned int state;
+};
+
+// One of the file names the workload uses
+
+class WorkloadFile {
+  public:
+    bool exists;			// has it been created?
+    bool busy;				// is a thread using it?
+    int size;				// how big, if it exists
+};
+
+// The following class defines a workload, and the results of
+// running it.
+
+class Workload {
+  public:
+    Workload();				// the default workload
+    ~Workload();
+
+    bool Load(char *specFile);		// read the settings; print what
+					// is wrong and return FALSE if
+					// they don't make sense
+    void Run();				// run it, and print the results
+
+    void Worker(int id, unsigned int seed);
+					// what each thread does
+
+  private:
+    // the settings
+    int numThreads;
+    int opsPerThread;
+    int seed;
+    int numDirs;
+    int filesPerDir;
+    int prealloc;
+    SizeDistribution sizeDistribution;
+    int sizeA, sizeB;			// the distribution's parameters
+    int mix[NumWorkloadOps];
+    bool sequential;
+    int ioSize;
+
+    // while it runs
+    WorkloadFile *files;		// numDirs * filesPerDir of them
+    int numFiles;
+    int numDirsMade;			// directories we have created
+    Lock *filesLock;			// protects their "busy" flags
+    Semaphore *done;			// signalled as each thread finishes
+    int *latencies[NumWorkloadOps];	// ticks each operation took
+    int numLatencies[NumWorkloadOps];
+    int bytesRead, bytesWritten;
+    int numSkipped;			// no file to do the operation on
+    int numFailed;
+
+    bool Setting(char *name, char *args);
+    					// take one line of the spec
+    bool Check();			// do the settings make sense?
+    void FileName(int file, char *name);
+    void DirName(int dir, char *name);
+    int PickSize(WorkloadRandom *random);
+    int PickFile(WorkloadRandom *random, bool existing);
+    					// find a file to work on, and
+					// mark it busy; -1 if none
+    bool CreateFile(int file, int size, char *buffer);
+    bool Transfer(WorkloadOp op, int file, char *buffer,
+			WorkloadRandom *random);
+    					// do a read or write
+    bool RemoveAll();			// remove what we created
+    void PrintLatencies(WorkloadOp op, char *name);
+};
+
+#endif // WORKLOAD_H
@@ -1,21 +1,34 @@
-// hash.cc 
+// hash.cc
 //     	Routines to manage a self-expanding hash table of arbitrary things.
 //	The hashing function is supplied by the objects being put into
-//	the table; we use chaining to resolve hash conflicts.
+//	the table; we use open addressing to resolve hash conflicts.
+//
+//	The hash table is implemented as an array of slots.  An item
+//	goes in the slot its key hashes to, or if that is taken, in
+//	the next free slot after it ("linear probing").  On the way,
+//	an item being inserted takes the slot of any item that is
+//	closer to its own home slot, and that item moves on instead
+//	("Robin Hood hashing").  This keeps the runs short, and lets
+//	Find stop as soon as it reaches an item closer to home than
+//	the one it is looking for would be.
+//
+//	We grow the table if it gets more than 3/4 full.  Rather than
+//	move everything at once, we keep the old array around and move
+//	a few items each time the table is changed.  Until the old array
+//	is empty, Find and Remove have to look in both.
 //
-//	The hash table is implemented as an array of sorted lists,
-//	and we expand the hash table if the number of elements in the table
-//	gets too big.
-// 
 //     	NOTE: Mutual exclusion must be provided by the caller.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
-// All rights reserved.  See copyright.h for copyright notice and limitation 
+// All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
 
-const int InitialBuckets = 4;	// how big a hash table do we start with
-const int ResizeRatio = 3;	// when do we grow the hash table?
-const int IncreaseSizeBy = 4;	// how much do we grow table when needed?
+const int InitialSlots = 8;	// how big a hash table do we start with
+				// (must be a power of 2)
+const int MaxLoadPercent = 75;	// when do we grow the hash table?
+const int MigrateSteps = 4;	// how many old slots to look at each
+				// time we change the table; must be enough
+				// to empty it before the new one fills up
 
 #include "copyright.h"
 
@@ -27,180 +40,288 @@ const int IncreaseSizeBy = 4;	// how much do we grow table when needed?
 
 template <class Key, class T>
 HashTable<Key,T>::HashTable(Key (*get)(T x), unsigned (*hFunc)(Key x))
-{ 
+{
     numItems = 0;
-    InitBuckets(InitialBuckets);
+    numSlots = InitialSlots;
+    shift = 32;
+    for (int n = 1; n < numSlots; n *= 2) {
+	shift--;
+    }
+    slots = InitSlots(numSlots);
+
+    oldSlots = NULL;
+    numOldSlots = 0;
+    oldShift = 0;
+    oldItems = 0;
+    migrateNext = 0;
+
     getKey = get;
     hash = hFunc;
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::InitBuckets
-//	Initialize the bucket array for a hash table.
-//	Called by the constructor and by ReHash().
+// HashTable<Key,T>::InitSlots
+//	Allocate an array of empty slots.
+//	Called by the constructor and by Grow().
 //----------------------------------------------------------------------
 
 template <class Key, class T>
-void
-HashTable<Key,T>::InitBuckets(int sz)
-{ 
-    numBuckets = sz;
-    buckets = new Bucket[numBuckets];
+HashSlot<T> *
+HashTable<Key,T>::InitSlots(int sz)
+{
+    Slot *table = new Slot[sz];
+
     for (int i = 0; i < sz; i++) {
-    	buckets[i] = new List<T>;
+	table[i].distance = -1;
     }
+    return table;
 }
 
 //----------------------------------------------------------------------
 // HashTable<T>::~HashTable
-//	Prepare a hash table for deallocation.  
+//	Prepare a hash table for deallocation.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
 HashTable<Key,T>::~HashTable()
-{ 
+{
     ASSERT(IsEmpty());		// make sure table is empty
-    DeleteBuckets(buckets, numBuckets);
+    delete [] slots;
+    if (oldSlots != NULL) {
+	delete [] oldSlots;
+    }
+}
+
+//----------------------------------------------------------------------
+// HashTable<Key,T>::HashValue
+//      Return the slot that an item with hash value "h" belongs in.
+//	We multiply by 2^32 divided by the golden ratio and take the
+//	top bits, so that even a poor hash function (like the identity)
+//	spreads the keys over the whole table.
+//
+//	"sh" -- 32 - log2 of the size of the array
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+int
+HashTable<Key, T>::HashValue(unsigned h, int sh) const
+{
+    return (int) ((unsigned) (h * 2654435769U) >> sh);
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::DeleteBuckets
-//	De-Initialize the bucket array for a hash table.
-//	Called by the destructor and by ReHash().
+// HashTable<Key,T>::InsertInSlots
+//      Put an item into an array of slots, Robin Hood style: if we
+//	come to an item that is closer to its home than we are to ours,
+//	we take its slot and carry on trying to find room for it.
+//
+//	There is always an empty slot, since the array is never full.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
 void
-HashTable<Key,T>::DeleteBuckets(List<T> **table, int sz)
-{ 
-    for (int i = 0; i < sz; i++) {
-    	delete table[i];
+HashTable<Key,T>::InsertInSlots(Slot *table, int sz, int sh,
+				T item, unsigned h)
+{
+    int i = HashValue(h, sh);
+    int distance = 0;
+    Slot *s;
+    T tmpItem;
+    unsigned tmpHash;
+    int tmpDistance;
+
+    for (;;) {
+	s = &table[i];
+	if (s->distance < 0) {			// found an empty slot
+	    s->item = item;
+	    s->hash = h;
+	    s->distance = distance;
+	    return;
+	}
+	if (s->distance < distance) {		// take from the rich
+	    tmpItem = s->item; tmpHash = s->hash; tmpDistance = s->distance;
+	    s->item = item; s->hash = h; s->distance = distance;
+	    item = tmpItem; h = tmpHash; distance = tmpDistance;
+	}
+	i = (i + 1) & (sz - 1);
+	distance++;
     }
-    delete [] table;
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::HashValue
-//      Return hash table bucket that would contain key.
+// HashTable<Key,T>::FindInSlots
+//      Find an item in an array of slots, from its key.  Because
+//	of the way items are inserted, we can stop looking as soon as
+//	we get to a slot that is closer to its home than the item we
+//	want would be (an empty slot counts as closest of all).
+//
+// Returns:
+//	The slot holding the item, or -1 if it isn't there.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
 int
-HashTable<Key, T>::HashValue(Key key) const 
+HashTable<Key,T>::FindInSlots(Slot *table, int sz, int sh,
+				Key key, unsigned h) const
 {
-    int result = (*hash)(key) % numBuckets;
-    ASSERT(result >= 0 && result < numBuckets);
-    return result;
+    int i = HashValue(h, sh);
+
+    for (int distance = 0; table[i].distance >= distance; distance++) {
+	if (table[i].hash == h && key == getKey(table[i].item)) { // found!
+	    return i;
+	}
+	i = (i + 1) & (sz - 1);
+    }
+    return -1;
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::Insert
-//      Put an item into the hashtable.
-//      
-//	Resize the table if the # of elements / # of buckets is too big.
-//	Then allocate a HashElement to keep track of the key, item pair,
-//	and add it to the right bucket.
-//
-//	"key" is the key we'll use to find this item.
-//	"item" is the thing to put in the table.
+// HashTable<Key,T>::RemoveFromSlots
+//      Take the item in slot "where" out of an array of slots.
+//	Any items after it in the same run move back one slot, so
+//	that FindInSlots still finds them.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
 void
-HashTable<Key,T>::Insert(T item)
+HashTable<Key,T>::RemoveFromSlots(Slot *table, int sz, int where)
 {
-    Key key = getKey(item);
+    int i = where;
+    int next = (i + 1) & (sz - 1);
+
+    while (table[next].distance > 0) {
+	table[i] = table[next];
+	table[i].distance--;
+	i = next;
+	next = (i + 1) & (sz - 1);
+    }
+    table[i].distance = -1;
+}
 
-    ASSERT(!IsInTable(key));
+//----------------------------------------------------------------------
+// HashTable<Key,T>::Grow
+//      Start moving the table into an array twice the size.  The
+//	items are moved over later, a few at a time, by Migrate().
+//----------------------------------------------------------------------
 
-    if ((numItems / numBuckets) >= ResizeRatio) {
-	ReHash();
-    }
+template <class Key, class T>
+void
+HashTable<Key,T>::Grow()
+{
+    ASSERT(oldSlots == NULL);
 
-    buckets[HashValue(key)]->Append(item);
-    numItems++;
+    oldSlots = slots;
+    numOldSlots = numSlots;
+    oldShift = shift;
+    oldItems = numItems;
+    migrateNext = 0;
 
-    ASSERT(IsInTable(key));
+    numSlots *= 2;
+    shift--;
+    slots = InitSlots(numSlots);
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::ReHash
-//      Increase the size of the hashtable, by 
-//	  (i) making a new table
-//	  (ii) moving all the elements into the new table
-//	  (iii) deleting the old table
+// HashTable<Key,T>::Migrate
+//      Move some of the items out of the old array, if there is one.
+//	We go through the old array in order.  Taking an item out may
+//	move the next one back into its slot, so we only move on once
+//	the slot is empty.  Thus the slots before "migrateNext" are
+//	always empty, and there is nothing to find there.
+//
+//	"steps" -- how many slots to look at (each one either moves an
+//		item, or moves us on to the next slot)
 //----------------------------------------------------------------------
 
 template <class Key, class T>
 void
-HashTable<Key,T>::ReHash()
+HashTable<Key,T>::Migrate(int steps)
 {
-    Bucket *oldTable = buckets;
-    int oldSize = numBuckets;
-    T item;
-
-    SanityCheck();
-    InitBuckets(numBuckets * IncreaseSizeBy);
+    Slot *s;
 
-    for (int i = 0; i < oldSize; i++) {
-	while (!oldTable[i]->IsEmpty()) {
-	    item = oldTable[i]->RemoveFront();
-	    buckets[HashValue(getKey(item))]->Append(item);
-        }
+    for (; oldSlots != NULL && steps > 0; steps--) {
+	if (oldItems == 0) {			// all done
+	    delete [] oldSlots;
+	    oldSlots = NULL;
+	    break;
+	}
+	ASSERT(migrateNext < numOldSlots);
+	s = &oldSlots[migrateNext];
+	if (s->distance < 0) {
+	    migrateNext++;
+	} else {
+	    InsertInSlots(slots, numSlots, shift, s->item, s->hash);
+	    RemoveFromSlots(oldSlots, numOldSlots, migrateNext);
+	    oldItems--;
+	}
     }
-    DeleteBuckets(oldTable, oldSize);
-    SanityCheck();
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::FindInBucket
-//      Find an item in a hash table bucket, from it's key
+// HashTable<Key,T>::Insert
+//      Put an item into the hashtable.
 //
-//	"bucket" -- the list storing the item, if it's in the table 
-//	"key" -- the key uniquely identifying the item
-// 
-// Returns:
-//	Whether item is found, and if found, the item.
+//	Move a few old items over first, if we are growing the table.
+//	Then, if the table is too full, start growing it.
+//
+//	"item" is the thing to put in the table.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
-bool
-HashTable<Key,T>::FindInBucket(int bucket, 
-				Key key, T *itemPtr) const
+void
+HashTable<Key,T>::Insert(T item)
 {
-    ListIterator<T> iterator(buckets[bucket]);
+    Key key = getKey(item);
 
-    for (; !iterator.IsDone(); iterator.Next()) {
-	if (key == getKey(iterator.Item())) { // found!
-	    *itemPtr = iterator.Item();
-	    return TRUE;
-        }
+    ASSERT(!IsInTable(key));
+
+    Migrate(MigrateSteps);
+    if ((numItems + 1) * 100 > numSlots * MaxLoadPercent) {
+	if (oldSlots != NULL) {		// shouldn't happen, but be safe
+	    Migrate(numOldSlots + oldItems + 1);
+	}
+	Grow();
     }
-    *itemPtr = NULL;
-    return FALSE;
+
+    InsertInSlots(slots, numSlots, shift, item, (*hash)(key));
+    numItems++;
+
+    ASSERT(IsInTable(key));
 }
 
 //----------------------------------------------------------------------
 // HashTable<Key,T>::Find
 //      Find an item from the hash table.
-// 
+//
 // Returns:
-//	The item or NULL if not found. 
+//	Whether item is found, and if found, the item.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
 bool
 HashTable<Key,T>::Find(Key key, T *itemPtr) const
 {
-    int bucket = HashValue(key);
-    
-    return FindInBucket(bucket, key, itemPtr); 
+    unsigned h = (*hash)(key);
+    int where = FindInSlots(slots, numSlots, shift, key, h);
+
+    if (where >= 0) {
+	*itemPtr = slots[where].item;
+	return TRUE;
+    }
+    if (oldSlots != NULL) {
+	where = FindInSlots(oldSlots, numOldSlots, oldShift, key, h);
+	if (where >= 0) {
+	    *itemPtr = oldSlots[where].item;
+	    return TRUE;
+	}
+    }
+    return FALSE;
 }
 
 //----------------------------------------------------------------------
 // HashTable<Key,T>::Remove
 //      Remove an item from the hash table. The item must be in the table.
-// 
+//
 // Returns:
 //	The removed item.
 //----------------------------------------------------------------------
@@ -209,20 +330,30 @@ template <class Key, class T>
 T
 HashTable<Key,T>::Remove(Key key)
 {
-    int bucket = HashValue(key);
+    unsigned h = (*hash)(key);
+    int where;
     T item;
-    bool found = FindInBucket(bucket, key, &item); 
-
-    ASSERT(found);	// item must be in table
 
-    buckets[bucket]->Remove(item);
+    Migrate(MigrateSteps);
+
+    where = FindInSlots(slots, numSlots, shift, key, h);
+    if (where >= 0) {
+	item = slots[where].item;
+	RemoveFromSlots(slots, numSlots, where);
+    } else {
+	ASSERT(oldSlots != NULL);	// item must be in table
+	where = FindInSlots(oldSlots, numOldSlots, oldShift, key, h);
+	ASSERT(where >= 0);
+	item = oldSlots[where].item;
+	RemoveFromSlots(oldSlots, numOldSlots, where);
+	oldItems--;
+    }
     numItems--;
 
     ASSERT(!IsInTable(key));
     return item;
 }
 
-
 //----------------------------------------------------------------------
 // HashTable<Key,T>::Apply
 //      Apply function to every item in the hash table.
@@ -234,57 +365,76 @@ template <class Key,class T>
 void
 HashTable<Key,T>::Apply(void (*func)(T)) const
 {
-    for (int bucket = 0; bucket < numBuckets; bucket++) {
-        buckets[bucket]->Apply(func);
+    int i;
+
+    if (oldSlots != NULL) {
+	for (i = migrateNext; i < numOldSlots; i++) {
+	    if (oldSlots[i].distance >= 0) {
+		(*func)(oldSlots[i].item);
+	    }
+	}
+    }
+    for (i = 0; i < numSlots; i++) {
+	if (slots[i].distance >= 0) {
+	    (*func)(slots[i].item);
+	}
     }
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::FindNextFullBucket
-//      Find the next bucket in the hash table that has any items in it.
+// HashTable<Key,T>::CheckSlots
+//      Test whether an array of slots is legal: each item is as far
+//	from home as it says, and no further than the item before it
+//	plus one (otherwise, FindInSlots would stop too soon).
 //
-//	"bucket" -- where to start looking for full buckets
+//	"numFound" -- incremented by the number of items in the array
 //----------------------------------------------------------------------
 
-template <class Key,class T>
-int
-HashTable<Key,T>::FindNextFullBucket(int bucket) const
-{ 
-    for (; bucket < numBuckets; bucket++) {
-	if (!buckets[bucket]->IsEmpty()) {
-	     break;
+template <class Key, class T>
+void
+HashTable<Key,T>::CheckSlots(Slot *table, int sz, int sh,
+				int *numFound) const
+{
+    for (int i = 0; i < sz; i++) {
+	if (table[i].distance < 0) {
+	    continue;
+	}
+	(*numFound)++;
+	ASSERT(table[i].hash == (*hash)(getKey(table[i].item)));
+	ASSERT(((i - HashValue(table[i].hash, sh)) & (sz - 1))
+						== table[i].distance);
+	if (table[i].distance > 0) {
+	    ASSERT(table[(i - 1) & (sz - 1)].distance
+						>= table[i].distance - 1);
 	}
     }
-    return bucket;
 }
 
 //----------------------------------------------------------------------
 // HashTable<Key,T>::SanityCheck
 //      Test whether this is still a legal hash table.
 //
-//	Tests: are all the buckets legal?
+//	Tests: are all the slot arrays legal?
 //	       does the table have the right # of elements?
-//	       do all the elements hash to where they are stored?
+//	       have the old slots we've moved past really been emptied?
 //----------------------------------------------------------------------
 
 template <class Key, class T>
-void 
+void
 HashTable<Key,T>::SanityCheck() const
 {
     int numFound = 0;
-    ListIterator<T> *iterator;
-
-    for (int i = 0; i < numBuckets; i++) {
-	buckets[i]->SanityCheck();
-	numFound += buckets[i]->NumInList();
-	iterator = new ListIterator<T>(buckets[i]);
-        for (; !iterator->IsDone(); iterator->Next()) {
-	    ASSERT(i == HashValue(getKey(iterator->Item())));
-        }
-        delete iterator;
+    int numOld = 0;
+
+    CheckSlots(slots, numSlots, shift, &numFound);
+    if (oldSlots != NULL) {
+	CheckSlots(oldSlots, numOldSlots, oldShift, &numOld);
+	ASSERT(numOld == oldItems);
+	for (int i = 0; i < migrateNext; i++) {
+	    ASSERT(oldSlots[i].distance < 0);
+	}
     }
-    ASSERT(numItems == numFound);
-
+    ASSERT(numItems == numFound + numOld);
 }
 
 //----------------------------------------------------------------------
@@ -293,12 +443,12 @@ HashTable<Key,T>::SanityCheck() const
 //----------------------------------------------------------------------
 
 template <class Key, class T>
-void 
+void
 HashTable<Key,T>::SelfTest(T *p, int numEntries)
 {
-    int i;
+    int i, count;
     HashIterator<Key, T> *iterator = new HashIterator<Key,T>(this);
-    
+
     SanityCheck();
     ASSERT(IsEmpty());	// check that table is empty in various ways
     for (; !iterator->IsDone(); iterator->Next()) {
@@ -310,11 +460,23 @@ HashTable<Key,T>::SelfTest(T *p, int numEntries)
         Insert(p[i]);
         ASSERT(IsInTable(getKey(p[i])));
         ASSERT(!IsEmpty());
+	SanityCheck();
+    }
+
+    // the iterator should see everything, whether or not it's been moved
+    count = 0;
+    iterator = new HashIterator<Key,T>(this);
+    for (; !iterator->IsDone(); iterator->Next()) {
+	ASSERT(IsInTable(getKey(iterator->Item())));
+	count++;
     }
-    
+    delete iterator;
+    ASSERT(count == numEntries);
+
     // should be able to get out everything we put in
-    for (i = 0; i < numEntries; i++) {  
+    for (i = 0; i < numEntries; i++) {
         ASSERT(Remove(getKey(p[i])) == p[i]);
+	SanityCheck();
     }
 
     ASSERT(IsEmpty());
@@ -325,18 +487,46 @@ HashTable<Key,T>::SelfTest(T *p, int numEntries)
 //----------------------------------------------------------------------
 // HashIterator<Key,T>::HashIterator
 //      Initialize a data structure to allow us to step through
-//	every entry in a has table.
+//	every entry in a has table.  We go through the old slot
+//	array first, if there is one.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
-HashIterator<Key,T>::HashIterator(HashTable<Key,T> *tbl) 
-{ 
+HashIterator<Key,T>::HashIterator(HashTable<Key,T> *tbl)
+{
     table = tbl;
-    bucket = table->FindNextFullBucket(0);
-    bucketIter = NULL;
-    if (bucket < table->numBuckets) {
-	bucketIter = new ListIterator<T>(table->buckets[bucket]);
+    inOld = (table->oldSlots != NULL);
+    slot = inOld ? table->migrateNext : 0;
+    FindNextFullSlot();
+}
+
+//----------------------------------------------------------------------
+// HashIterator<Key,T>::FindNextFullSlot
+//      Point the iterator at the first item at or after "slot",
+//	or set "current" to NULL if there are no more.
+//----------------------------------------------------------------------
+
+template <class Key,class T>
+void
+HashIterator<Key,T>::FindNextFullSlot()
+{
+    if (inOld) {
+	for (; slot < table->numOldSlots; slot++) {
+	    if (table->oldSlots[slot].distance >= 0) {
+		current = &table->oldSlots[slot];
+		return;
+	    }
+	}
+	inOld = FALSE;
+	slot = 0;
     }
+    for (; slot < table->numSlots; slot++) {
+	if (table->slots[slot].distance >= 0) {
+	    current = &table->slots[slot];
+	    return;
+	}
+    }
+    current = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -346,15 +536,9 @@ HashIterator<Key,T>::HashIterator(HashTable<Key,T> *tbl)
 
 template <class Key,class T>
 void
-HashIterator<Key,T>::Next() 
-{ 
-    bucketIter->Next();
-    if (bucketIter->IsDone()) {
-	delete bucketIter;
-	bucketIter = NULL;
-        bucket = table->FindNextFullBucket(++bucket);
-        if (bucket < table->numBuckets) {
-	    bucketIter = new ListIterator<T>(table->buckets[bucket]);
-        }
-    }
+HashIterator<Key,T>::Next()
+{
+    ASSERT(!IsDone());
+    slot++;
+    FindNextFullSlot();
 }
@@ -4,7 +4,7 @@
 //	for the value given the key.
 //
 //	I've only tested this implementation when both the key and the
-//	value are primitive types (ints or pointers).  There is no 
+//	value are primitive types (ints or pointers).  There is no
 //	guarantee that it will work in general.  In particular, it
 //	assumes that the "==" operator works for both keys and values.
 //
@@ -16,10 +16,18 @@
 //		Key GetKey(T x);
 //
 //	The hash table automatically resizes itself as items are
-//	put into the table.  The implementation uses chaining
-//	to resolve hash conflicts.
+//	put into the table.  The implementation uses open addressing:
+//	the items are stored directly in an array of slots, and
+//	conflicts are resolved by linear probing, with "Robin Hood"
+//	insertion to keep every item close to the slot it hashes to.
+//	So there is no allocation per item.
 //
-//	Allocation and deallocation of the items in the table are to 
+//	When the table grows, the items are not all moved at once:
+//	the old array is kept, and each later Insert or Remove moves
+//	a few more of its items over, until it is empty.  This keeps
+//	any single operation from taking too long.
+//
+//	Allocation and deallocation of the items in the table are to
 //	be done by the caller.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
@@ -30,7 +38,7 @@
 #define HASH_H
 
 #include "copyright.h"
-#include "list.h"
+#include "debug.h"
 
 // The following class defines a "hash table" -- allowing quick
 // lookup according to the hash function defined for the items
@@ -38,83 +46,109 @@
 
 template <class Key,class T> class HashIterator;
 
-template <class Key, class T> 
+// One entry in the table.  "distance" is how far the item is from
+// the slot it hashes to, or -1 if the slot is empty.
+
+template <class T>
+class HashSlot {
+  public:
+    T item;			// the item stored here
+    unsigned hash;		// its hash value, so we needn't recompute it
+    int distance;		// how far from home, or -1 if empty
+};
+
+template <class Key, class T>
 class HashTable {
   public:
-    HashTable(Key (*get)(T x), unsigned (*hFunc)(Key x));	
+    HashTable(Key (*get)(T x), unsigned (*hFunc)(Key x));
     				// initialize a hash table
     ~HashTable();		// deallocate a hash table
 
     void Insert(T item);	// Put item into hash table
     T Remove(Key key);		// Remove item from hash table.
 
-    bool Find(Key key, T *itemPtr) const; 
+    bool Find(Key key, T *itemPtr) const;
     				// Find an item from its key
-    bool IsInTable(Key key) { T dummy; return Find(key, &dummy); } 	
+    bool IsInTable(Key key) { T dummy; return Find(key, &dummy); }
 				// Is the item in the table?
 
-    bool IsEmpty() { return numItems == 0; }	
+    bool IsEmpty() { return numItems == 0; }
 				// does the table have anything in it
 
     void Apply(void (*f)(T)) const;
     				// apply function to all elements in table
 
     void SanityCheck() const;// is this still a legal hash table?
-    void SelfTest(T *p, int numItems);	
+    void SelfTest(T *p, int numItems);
     				// is the module working?
 
   private:
-typedef List<T> *Bucket;
+typedef HashSlot<T> Slot;
 
-    Bucket *buckets;		// the array of hash buckets
-    int numBuckets;		// the number of buckets
+    Slot *slots;		// where new items go
+    int numSlots;		// the size of "slots", a power of 2
+    int shift;			// 32 - log2(numSlots)
     int numItems;		// the number of items in the table
-    
+
+    Slot *oldSlots;		// the array we are growing out of, or NULL
+    int numOldSlots;		// its size
+    int oldShift;		// and its shift
+    int oldItems;		// how many items are still in it
+    int migrateNext;		// the next old slot to move over
+
     Key (*getKey)(T x);		// get Key from value
     unsigned (*hash)(Key x);	// the hash function
 
-    void InitBuckets(int size);// initialize bucket array
-    void DeleteBuckets(Bucket *table, int size);
-    				// deallocate bucket array
-				
-    int HashValue(Key key) const;
-    				// which bucket does the key hash to?
+    Slot *InitSlots(int size);	// allocate an empty slot array
+
+    int HashValue(unsigned h, int sh) const;
+    				// which slot does the hash value go to?
+
+    void Grow();		// start moving to a bigger array
+    void Migrate(int steps);	// move some items out of the old array
 
-    void ReHash();		// expand the hash table
-    
-    bool FindInBucket(int bucket, Key key, T *itemPtr) const; 
-    				// find item in bucket
-    int FindNextFullBucket(int start) const;
-    				// find next full bucket starting from this one
+    void InsertInSlots(Slot *table, int size, int sh, T item, unsigned h);
+    				// put an item in an array of slots
+    int FindInSlots(Slot *table, int size, int sh, Key key,
+    		unsigned h) const;
+    				// where is the item in an array of slots?
+    void RemoveFromSlots(Slot *table, int size, int where);
+    				// take out the item in a slot
+    void CheckSlots(Slot *table, int size, int sh, int *numFound) const;
+    				// sanity check an array of slots
 
     friend class HashIterator<Key,T>;
 };
 
 // The following class can be used to step through a hash table --
 // same interface as ListIterator.  Example code:
-//	HashIterator<Key, T> iter(table); 
+//	HashIterator<Key, T> iter(table);
 //
 //	for (; !iter->IsDone(); iter->Next()) {
 //	    Operation on iter->Item()
 //      }
+//
+// The table must not be changed while we step through it.
 
 template <class Key,class T>
 class HashIterator {
   public:
     HashIterator(HashTable<Key,T> *table); // initialize an iterator
-    ~HashIterator() { if (bucketIter != NULL) delete bucketIter;}; 
-				// destruct an iterator
+    ~HashIterator() {}; 	// destruct an iterator
 
-    bool IsDone() { return (bucket == table->numBuckets); };
-				// return TRUE if no more items in table 
-    T Item() { ASSERT(!IsDone()); return bucketIter->Item(); }; 
+    bool IsDone() { return (current == NULL); };
+				// return TRUE if no more items in table
+    T Item() { ASSERT(!IsDone()); return current->item; };
 				// return current item in table
     void Next(); 		// update iterator to point to next
 
-  private:   
+  private:
     HashTable<Key,T> *table;	// the hash table we're stepping through
-    int bucket;			// current bucket we are in
-    ListIterator<T> *bucketIter; // where we are in the bucket
+    bool inOld;			// are we still in the old array?
+    int slot;			// the slot we are at
+    HashSlot<T> *current;	// and what's in it, or NULL if done
+
+    void FindNextFullSlot();	// move to the next item, from "slot" on
 };
 
 #include "hash.cc"		// templates are really like macros
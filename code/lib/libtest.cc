@@ -1,6 +1,7 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, intrusive lists, and
+//	hash tables.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -11,6 +12,7 @@
 #include "bitmap.h"
 #include "list.h"
 #include "hash.h"
+#include "chainhash.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
@@ -50,18 +52,86 @@ HashKey(char *str) {
     return atoi(str);
 }
 
+//----------------------------------------------------------------------
+// IntPtrKey
+//	Retrieve the key of an item in the hash table benchmark.
+//----------------------------------------------------------------------
+
+static int
+IntPtrKey(int *item) {
+    return *item;
+}
+
 // Array of values to be inserted into a List or SortedList. 
 static int listTestVector[] = { 9, 5, 7 };
 
+// Something to put on an IntrusiveList
+class LinkedInt {
+  public:
+    int value;
+    ListLink<LinkedInt> link;
+};
+
 // Array of values to be inserted into the HashTable
-// There are enough here to force a ReHash().
+// There are enough here to force it to grow, twice.
 static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
 	 "7", "8", "9", "10", "11", "12", "13", "14"};
 
+// How many items to put in the hash tables we compare
+static const int HashBenchItems = 20000;
+
+//----------------------------------------------------------------------
+// HashBenchmark
+//	Time inserting, finding and removing "numItems" items in a
+//	hash table.  Since growing a table can make one insert much
+//	slower than the rest, we report the slowest as well.
+//
+//	"name" -- what to call the table in the report
+//	"table" -- an empty HashTable, or ChainedHashTable
+//	"items" -- the items to put in it
+//----------------------------------------------------------------------
+
+template <class Table>
+static void
+HashBenchmark(char *name, Table *table, int **items, int numItems)
+{
+    double start, before, worst, inserting, finding, removing;
+    int *item;
+    int i;
+
+    worst = 0;
+    start = HostSeconds();
+    for (i = 0; i < numItems; i++) {
+	before = HostSeconds();
+	table->Insert(items[i]);
+	worst = max(worst, HostSeconds() - before);
+    }
+    inserting = HostSeconds() - start;
+
+    start = HostSeconds();
+    for (i = 0; i < numItems; i++) {
+	ASSERT(table->Find(*items[i], &item) && item == items[i]);
+	ASSERT(!table->Find(numItems + i, &item));
+    }
+    finding = HostSeconds() - start;
+
+    start = HostSeconds();
+    for (i = 0; i < numItems; i++) {
+	ASSERT(table->Remove(*items[i]) == items[i]);
+    }
+    removing = HostSeconds() - start;
+
+    cout << name << ": " << numItems << " items, insert "
+	<< (int)(inserting * 1000000) << " usec (slowest "
+	<< (int)(worst * 1000000) << "), find "
+	<< (int)(finding * 1000000) << ", remove "
+	<< (int)(removing * 1000000) << "\n";
+}
+
 //----------------------------------------------------------------------
 // LibSelfTest
-//	Run self tests on bitmaps, lists, sorted lists, and 
-//	hash tables.
+//	Run self tests on bitmaps, lists, sorted lists, intrusive
+//	lists, and hash tables.
 //----------------------------------------------------------------------
 
 void
@@ -71,15 +141,37 @@ LibSelfTest () {
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
     HashTable<int, char *> *hashTable = 
 	new HashTable<int, char *>(HashKey, HashInt);
+    IntrusiveList<LinkedInt> *intrusiveList = new IntrusiveList<LinkedInt>;
+    LinkedInt linked[5];
+    int *values = new int[HashBenchItems];
+    int **items = new int *[HashBenchItems];
+    HashTable<int, int *> *benchTable =
+	new HashTable<int, int *>(IntPtrKey, HashInt);
+    ChainedHashTable<int, int *> *chainedTable =
+	new ChainedHashTable<int, int *>(IntPtrKey, HashInt);
+    int i;
 	
 		
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    intrusiveList->SelfTest(linked, 5);
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector)/sizeof(char *));
 
+    for (i = 0; i < HashBenchItems; i++) {	// scatter the keys a bit
+	values[i] = (i * 7919) % HashBenchItems;
+	items[i] = &values[i];
+    }
+    HashBenchmark("HashTable", benchTable, items, HashBenchItems);
+    HashBenchmark("ChainedHashTable", chainedTable, items, HashBenchItems);
+
     delete map;
     delete list;
     delete sortList;
+    delete intrusiveList;
     delete hashTable;
+    delete benchTable;
+    delete chainedTable;
+    delete [] items;
+    delete [] values;
 }
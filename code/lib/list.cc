@@ -4,9 +4,10 @@
 //	anything on the list in a type-safe manner.
 //
 // 	A "ListElement" is allocated for each item to be put on the
-//	list; it is de-allocated when the item is removed. This means
-//      we don't need to keep a "next" pointer in every object we
-//      want to put on a list.
+//	list; when the item is removed, the element goes on a free list
+//	to be used again. This means we don't need to keep a "next"
+//	pointer in every object we want to put on a list.  Objects that
+//	do keep one can go on an IntrusiveList instead (see below).
 // 
 //     	NOTE: Mutual exclusion must be provided by the caller.
 //  	If you want a synchronized list, you must use the routines 
@@ -30,8 +31,12 @@ ListElement<T>::ListElement(T itm)
 {
      item = itm;
      next = NULL;	// always initialize to something!
+     prev = NULL;
 }
 
+template <class T>
+ListElement<T> *List<T>::freeElements = NULL;
+
 
 //----------------------------------------------------------------------
 // List<T>::List
@@ -59,11 +64,63 @@ List<T>::~List()
 { 
 }
 
+//----------------------------------------------------------------------
+// List<T>::NewElement, List<T>::FreeElement
+//      Get a ListElement for "item", re-using one from the free list
+//	if we can; and put one that is no longer needed on the free list.
+//----------------------------------------------------------------------
+
+template <class T>
+ListElement<T> *
+List<T>::NewElement(T item)
+{
+    ListElement<T> *element = freeElements;
+
+    if (element == NULL) {
+	return new ListElement<T>(item);
+    }
+    freeElements = element->next;
+    element->item = item;
+    element->next = element->prev = NULL;
+    return element;
+}
+
+template <class T>
+void
+List<T>::FreeElement(ListElement<T> *element)
+{
+    element->next = freeElements;
+    freeElements = element;
+}
+
+//----------------------------------------------------------------------
+// List<T>::Unlink
+//      Take an element out of the list, and free it.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+List<T>::Unlink(ListElement<T> *element)
+{
+    if (element->prev == NULL) {
+	first = element->next;
+    } else {
+	element->prev->next = element->next;
+    }
+    if (element->next == NULL) {
+	last = element->prev;
+    } else {
+	element->next->prev = element->prev;
+    }
+    numInList--;
+    FreeElement(element);
+}
+
 //----------------------------------------------------------------------
 // List<T>::Append
 //      Append an "item" to the end of the list.
 //      
-//	Allocate a ListElement to keep track of the item.
+//	Get a ListElement to keep track of the item.
 //      If the list is empty, then this will be the only element.
 //	Otherwise, put it at the end.
 //
@@ -74,13 +131,14 @@ template <class T>
 void
 List<T>::Append(T item)
 {
-    ListElement<T> *element = new ListElement<T>(item);
+    ListElement<T> *element = NewElement(item);
 
     ASSERT(!IsInList(item));
     if (IsEmpty()) {		// list is empty
 	first = element;
 	last = element;
     } else {			// else put it after last
+	element->prev = last;
 	last->next = element;
 	last = element;
     }
@@ -97,7 +155,7 @@ template <class T>
 void
 List<T>::Prepend(T item)
 {
-    ListElement<T> *element = new ListElement<T>(item);
+    ListElement<T> *element = NewElement(item);
 
     ASSERT(!IsInList(item));
     if (IsEmpty()) {		// list is empty
@@ -105,6 +163,7 @@ List<T>::Prepend(T item)
 	last = element;
     } else {			// else put it before first
 	element->next = first;
+	first->prev = element;
 	first = element;
     }
     numInList++;
@@ -124,20 +183,12 @@ template <class T>
 T
 List<T>::RemoveFront()
 {
-    ListElement<T> *element = first;
     T thing;
 
     ASSERT(!IsEmpty());
 
     thing = first->item;
-    if (first == last) {	// list had one item, now has none 
-        first = NULL;
-		last = NULL;
-    } else {
-        first = element->next;
-    }
-    numInList--;
-    delete element;
+    Unlink(first);
     return thing;
 }
 
@@ -150,31 +201,18 @@ template <class T>
 void
 List<T>::Remove(T item)
 {
-    ListElement<T> *prev, *ptr;
-    T removed;
+    ListElement<T> *ptr;
 
     ASSERT(IsInList(item));
 
-    // if first item on list is match, then remove from front
-    if (item == first->item) {	
-        removed = RemoveFront();
-        ASSERT(item == removed);
-    } else {
-	prev = first;
-        for (ptr = first->next; ptr != NULL; prev = ptr, ptr = ptr->next) {
-            if (item == ptr->item) {
-		prev->next = ptr->next;
-		if (prev->next == NULL) {
-		    last = prev;
-		}
-		delete ptr;
-		numInList--;
-		break;
-	    }
-        }
-	ASSERT(ptr != NULL);	// should always find item!
+    for (ptr = first; ptr != NULL; ptr = ptr->next) {
+        if (item == ptr->item) {
+	    Unlink(ptr);
+	    break;
+	}
     }
-   ASSERT(!IsInList(item));
+    ASSERT(ptr != NULL);	// should always find item!
+    ASSERT(!IsInList(item));
 }
 
 //----------------------------------------------------------------------
@@ -221,7 +259,7 @@ List<T>::Apply(void (*func)(T)) const
 //      Insert an "item" into a list, so that the list elements are
 //	sorted in increasing order.
 //      
-//	Allocate a ListElement to keep track of the item.
+//	Get a ListElement to keep track of the item.
 //      If the list is empty, then this will be the only element.
 //	Otherwise, walk through the list, one element at a time,
 //	to find where the new item should be placed.
@@ -233,7 +271,7 @@ template <class T>
 void
 SortedList<T>::Insert(T item)
 {
-    ListElement<T> *element = new ListElement<T>(item);
+    ListElement<T> *element = this->NewElement(item);
     ListElement<T> *ptr;		// keep track
 
     ASSERT(!IsInList(item));
@@ -242,16 +280,20 @@ SortedList<T>::Insert(T item)
         this->last = element;
     } else if (compare(item, this->first->item) < 0) {  // item goes at front 
 	element->next = this->first;
+	this->first->prev = element;
 	this->first = element;
     } else {		// look for first elt in list bigger than item
         for (ptr = this->first; ptr->next != NULL; ptr = ptr->next) {
             if (compare(item, ptr->next->item) < 0) {
 		element->next = ptr->next;
+		element->prev = ptr;
+		ptr->next->prev = element;
 	        ptr->next = element;
 		this->numInList++;
 		return;
 	    }
 	}
+	element->prev = this->last;
 	this->last->next = element;		// item goes at end of list
 	this->last = element;
     }
@@ -277,11 +319,14 @@ List<T>::SanityCheck() const
     if (first == NULL) {
 	ASSERT((numInList == 0) && (last == NULL));
     } else if (first == last) {
-	ASSERT((numInList == 1) && (last->next == NULL));
+	ASSERT((numInList == 1) && (last->next == NULL)
+				&& (first->prev == NULL));
     } else {
+        ASSERT(first->prev == NULL);
         for (numFound = 1, ptr = first; ptr != last; ptr = ptr->next) {
 	    numFound++;
             ASSERT(numFound <= numInList);	// prevent infinite loop
+            ASSERT(ptr->next->prev == ptr);
         }
         ASSERT(numFound == numInList);
         ASSERT(last->next == NULL);
@@ -381,3 +426,223 @@ SortedList<T>::SelfTest(T *p, int numEntries)
 
      delete q;
 }
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::IntrusiveList
+//	Initialize an intrusive list, empty to start with.
+//----------------------------------------------------------------------
+
+template <class T>
+IntrusiveList<T>::IntrusiveList()
+{ 
+    first = last = NULL; 
+    numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::~IntrusiveList
+//	Prepare a list for deallocation.  The items on it are not
+//	freed, and are still marked as being on the list.
+//      Normally, the list should be empty when this is called.
+//----------------------------------------------------------------------
+
+template <class T>
+IntrusiveList<T>::~IntrusiveList()
+{ 
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::InsertAfter
+//	Link "item" into the list after "where", or at the front if
+//	"where" is NULL.  The item must not be on any list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::InsertAfter(T *item, T *where)
+{
+    ASSERT(item->link.list == NULL);
+    item->link.list = this;
+    item->link.prev = where;
+    if (where == NULL) {
+	item->link.next = first;
+	first = item;
+    } else {
+	item->link.next = where->link.next;
+	where->link.next = item;
+    }
+    if (item->link.next == NULL) {
+	last = item;
+    } else {
+	item->link.next->link.prev = item;
+    }
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Append, IntrusiveList<T>::Prepend
+//      Put an item at the end/front of the list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Append(T *item)
+{
+    InsertAfter(item, last);
+}
+
+template <class T>
+void
+IntrusiveList<T>::Prepend(T *item)
+{
+    InsertAfter(item, NULL);
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Remove
+//      Take an item off the list, wherever it is.  Must be in the list!
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Remove(T *item)
+{
+    ASSERT(IsInList(item));
+    if (item->link.prev == NULL) {
+	first = item->link.next;
+    } else {
+	item->link.prev->link.next = item->link.next;
+    }
+    if (item->link.next == NULL) {
+	last = item->link.prev;
+    } else {
+	item->link.next->link.prev = item->link.prev;
+    }
+    item->link.next = item->link.prev = NULL;
+    item->link.list = NULL;
+    numInList--;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::RemoveFront
+//      Remove the first item from the front of the list, and return it.
+//	List must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T *
+IntrusiveList<T>::RemoveFront()
+{
+    T *item = first;
+
+    ASSERT(!IsEmpty());
+    Remove(item);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Apply
+//      Apply function to every item on a list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Apply(void (*func)(T *)) const
+{ 
+    T *ptr;
+
+    for (ptr = first; ptr != NULL; ptr = ptr->link.next) {
+        (*func)(ptr);
+    }
+}
+
+//----------------------------------------------------------------------
+// SortedIntrusiveList<T>::Insert
+//      Insert an item into the list, after every item that is not
+//	bigger than it.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SortedIntrusiveList<T>::Insert(T *item)
+{
+    T *ptr;
+
+    for (ptr = this->last; ptr != NULL; ptr = ptr->link.prev) {
+	if (compare(ptr, item) <= 0) {
+	    break;
+	}
+    }
+    this->InsertAfter(item, ptr);
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::SanityCheck
+//      Test whether this is still a legal list: are the links
+//	consistent in both directions, and is the count right?
+//----------------------------------------------------------------------
+
+template <class T>
+void 
+IntrusiveList<T>::SanityCheck() const
+{
+    T *ptr, *prev = NULL;
+    int numFound = 0;
+
+    for (ptr = first; ptr != NULL; prev = ptr, ptr = ptr->link.next) {
+	numFound++;
+	ASSERT(numFound <= numInList);		// prevent infinite loop
+	ASSERT(ptr->link.prev == prev && ptr->link.list == this);
+    }
+    ASSERT(numFound == numInList && last == prev);
+}
+
+//----------------------------------------------------------------------
+// SortedIntrusiveList::SanityCheck
+//      Test whether this is still a legal sorted list.
+//----------------------------------------------------------------------
+
+template <class T>
+void 
+SortedIntrusiveList<T>::SanityCheck() const
+{
+    T *ptr;
+
+    IntrusiveList<T>::SanityCheck();
+    for (ptr = this->first; ptr != NULL && ptr->link.next != NULL;
+						ptr = ptr->link.next) {
+	ASSERT(compare(ptr, ptr->link.next) <= 0);
+    }
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList::SelfTest
+//      Test whether this module is working: put the items on the
+//	list, take them off from the middle, the back and the front.
+//----------------------------------------------------------------------
+
+template <class T>
+void 
+IntrusiveList<T>::SelfTest(T *p, int numEntries)
+{
+    int i;
+
+    ASSERT(IsEmpty());
+    SanityCheck();
+    for (i = 0; i < numEntries; i++) {
+	Append(&p[i]);
+	ASSERT(IsInList(&p[i]));
+    }
+    SanityCheck();
+
+    for (i = 1; i < numEntries; i += 2) {	// every other one
+	Remove(&p[i]);
+	ASSERT(!IsInList(&p[i]));
+    }
+    SanityCheck();
+    for (i = 0; i < numEntries; i += 2) {	// the rest, in order
+	ASSERT(RemoveFront() == &p[i]);
+    }
+    ASSERT(IsEmpty());
+    SanityCheck();
+}
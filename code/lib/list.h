@@ -6,6 +6,12 @@
 //	pending interrupts, etc.  Allocation and deallocation of the
 //	items on the list are to be done by the caller.
 //
+//	There is also an "intrusive" list, for objects that are put on
+//	lists all the time (threads, pending interrupts): the links are
+//	kept in the objects themselves, so nothing is allocated to put
+//	an object on the list, and an object can be taken off the list
+//	without searching for it.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -29,11 +35,15 @@ class ListElement {
   public:
     ListElement(T itm); 	// initialize a list element
     ListElement *next;	     	// next element on list, NULL if this is last
+    ListElement *prev;		// previous element, NULL if this is first
     T item; 	   	     	// item on the list
 };
 
-// The following class defines a "list" -- a singly linked list of
+// The following class defines a "list" -- a doubly linked list of
 // list elements, each of which points to a single item on the list.
+// List elements that are no longer needed are kept on a free list,
+// shared by all lists of the same type, rather than deleted, so that
+// a list that is used steadily stops allocating memory.
 // The class has been tested only for primitive types (ints, pointers);
 // no guarantees it will work in general.  For instance, all types
 // to be inserted into a list must have a "==" operator defined.
@@ -75,10 +85,21 @@ class List {
     ListElement<T> *last;	// Last element of list
     int numInList;		// number of elements in list
 
+    ListElement<T> *NewElement(T item);
+				// get an element, from the free list
+				// if there is one
+    void FreeElement(ListElement<T> *element);
+				// put an element on the free list
+    void Unlink(ListElement<T> *element);
+				// take an element out of the list
+
+    static ListElement<T> *freeElements;
+				// elements not on any list
+
     friend class ListIterator<T>;
 };
 
-// The following class defines a "sorted list" -- a singly linked list of
+// The following class defines a "sorted list" -- a doubly linked list of
 // list elements, arranged so that "Remove" always returns the smallest 
 // element. 
 // All types to be inserted onto a sorted list must have a "Compare"
@@ -136,6 +157,88 @@ class ListIterator {
     ListElement<T> *current;	// where we are in the list
 };
 
+// The following class defines the link an object needs in order to
+// be put on an intrusive list.  An object with a "ListLink<T> link"
+// member can be on one intrusive list at a time.
+
+template <class T>
+class ListLink {
+  public:
+    ListLink() { next = prev = NULL; list = NULL; }
+
+    T *next;			// next object on the list
+    T *prev;			// previous object on the list
+    void *list;			// list the object is on, NULL if none
+};
+
+// The following class defines an "intrusive list" -- a doubly linked
+// list threaded through the "link" member of the objects on it.
+// Since an object knows where it is in the list, Remove and IsInList
+// take constant time, and nothing is allocated or freed.
+
+template <class T>
+class IntrusiveList {
+  public:
+    IntrusiveList();		// initialize the list
+    ~IntrusiveList();		// de-allocate the list
+
+    void Prepend(T *item);	// Put item at the beginning of the list
+    void Append(T *item);	// Put item at the end of the list
+
+    T *Front() { return first; }
+				// Return first item on list
+				// without removing it
+    T *RemoveFront();		// Take item off the front of the list
+    void Remove(T *item);	// Remove specific item from list
+
+    bool IsInList(T *item) const { return item->link.list == this; }
+				// is the item in the list?
+
+    unsigned int NumInList() { return numInList; }
+				// how many items in the list?
+    bool IsEmpty() { return (first == NULL); }
+				// is the list empty? 
+
+    void Apply(void (*f)(T *)) const;
+				// apply function to all elements in list
+
+    void SanityCheck() const;	// has this list been corrupted?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  protected:
+    void InsertAfter(T *item, T *where);
+				// put item after "where", or at the
+				// front if "where" is NULL
+
+    T *first;			// Head of the list, NULL if list is empty
+    T *last;			// Last item on the list
+    int numInList;		// number of items in list
+};
+
+// The following class defines a sorted intrusive list.  As with
+// SortedList, "compare" orders the items, and items that compare
+// equal stay in the order they were inserted.  New items are usually
+// later than everything on the list (e.g., future interrupts), so
+// Insert searches from the back.
+
+template <class T>
+class SortedIntrusiveList : public IntrusiveList<T> {
+  public:
+    SortedIntrusiveList(int (*comp)(T *x, T *y)) : IntrusiveList<T>()
+				{ compare = comp; }
+
+    void Insert(T *item); 	// insert an item onto the list in sorted order
+
+    void SanityCheck() const;	// has this list been corrupted?
+
+  private:
+    int (*compare)(T *x, T *y);	// function for sorting list elements
+
+    void Prepend(T *item) { Insert(item); }
+    void Append(T *item) { Insert(item); }
+};
+
 #include "list.cc"		// templates are really like macros
 				// so needs to be included in every
 				// file that uses the template
@@ -0,0 +1,193 @@
+// pool.cc
+//	Routines to manage pools of fixed size blocks, and arenas of
+//	temporary memory.
+//
+//	Every block handed out is aligned on an 8 byte boundary, so
+//	that anything can be stored in it.  The first 8 bytes of a
+//	free block, a slab, or an arena chunk are used to link it onto
+//	a list.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pool.h"
+#include "debug.h"
+
+const int PoolAlign = 8;	// alignment of every block we hand out
+
+// where the link in a free block, slab or chunk is kept
+#define NextOf(p) (*(void **) (p))
+
+Pool *Arena::chunkPool = NULL;
+
+//----------------------------------------------------------------------
+// Pool::Pool
+// 	Initialize an empty pool.  No memory is taken from the host
+//	until the first block is asked for.
+//
+//	"debugName" -- a name, for debugging
+//	"size" -- how big each block must be
+//	"perSlab" -- how many blocks to get from the host at a time
+//----------------------------------------------------------------------
+
+Pool::Pool(char *debugName, int size, int perSlab)
+{
+    ASSERT(size > 0 && perSlab > 0);
+    name = debugName;
+    blockSize = divRoundUp(size, PoolAlign) * PoolAlign;
+    blocksPerSlab = perSlab;
+    freeList = NULL;
+    slabs = NULL;
+    numSlabs = 0;
+    numInUse = 0;
+}
+
+//----------------------------------------------------------------------
+// Pool::~Pool
+// 	Give all the slabs back to the host.
+//----------------------------------------------------------------------
+
+Pool::~Pool()
+{
+    void *slab;
+
+    while (slabs != NULL) {
+	slab = slabs;
+	slabs = NextOf(slab);
+	delete [] (char *) slab;
+    }
+}
+
+//----------------------------------------------------------------------
+// Pool::Get
+// 	Allocate a block.  If there are no free blocks, get another
+//	slab from the host and carve it up.
+//----------------------------------------------------------------------
+
+void *
+Pool::Get()
+{
+    void *block;
+    char *slab;
+
+    if (freeList == NULL) {
+	DEBUG(dbgPool, "Pool " << name << " adding a slab of "
+			<< blocksPerSlab << " blocks");
+	slab = new char[PoolAlign + blocksPerSlab * blockSize];
+	NextOf(slab) = slabs;
+	slabs = slab;
+	numSlabs++;
+	for (int i = blocksPerSlab - 1; i >= 0; i--) {
+	    block = &slab[PoolAlign + i * blockSize];
+	    NextOf(block) = freeList;
+	    freeList = block;
+	}
+    }
+    block = freeList;
+    freeList = NextOf(block);
+    numInUse++;
+    return block;
+}
+
+//----------------------------------------------------------------------
+// Pool::Put
+// 	Free a block, so it can be handed out again.  It isn't given
+//	back to the host until the pool is deleted.
+//
+//	"block" -- a block returned by Get()
+//----------------------------------------------------------------------
+
+void
+Pool::Put(void *block)
+{
+    ASSERT(numInUse > 0);
+    NextOf(block) = freeList;
+    freeList = block;
+    numInUse--;
+}
+
+//----------------------------------------------------------------------
+// Pool::Print
+// 	Print how much memory the pool has taken from the host, and
+//	how much of it is in use.
+//----------------------------------------------------------------------
+
+void
+Pool::Print()
+{
+    cout << "Pool " << name << ": " << blockSize << " byte blocks, "
+	<< numInUse << " in use, " << numSlabs << " slabs of "
+	<< blocksPerSlab << "\n";
+}
+
+//----------------------------------------------------------------------
+// Arena::Arena
+// 	Initialize an empty arena.  It takes no memory until the
+//	first Alloc().
+//----------------------------------------------------------------------
+
+Arena::Arena()
+{
+    chunks = NULL;
+    bigBlocks = NULL;
+    used = ArenaChunkSize;		// so the first Alloc gets a chunk
+    if (chunkPool == NULL) {
+	chunkPool = new Pool("arena chunks", ArenaChunkSize, 4);
+    }
+}
+
+//----------------------------------------------------------------------
+// Arena::~Arena
+// 	Free everything allocated from the arena: the chunks go back
+//	to the pool, and the oversize blocks back to the host.
+//----------------------------------------------------------------------
+
+Arena::~Arena()
+{
+    void *p;
+
+    while (chunks != NULL) {
+	p = chunks;
+	chunks = NextOf(p);
+	chunkPool->Put(p);
+    }
+    while (bigBlocks != NULL) {
+	p = bigBlocks;
+	bigBlocks = NextOf(p);
+	delete [] (char *) p;
+    }
+}
+
+//----------------------------------------------------------------------
+// Arena::Alloc
+// 	Allocate "size" bytes, which are freed when the arena is.
+//	Usually this just moves along the current chunk; if there
+//	isn't room, we start a new one.  A block too big for a chunk
+//	gets memory of its own from the host.
+//----------------------------------------------------------------------
+
+void *
+Arena::Alloc(int size)
+{
+    char *p;
+
+    ASSERT(size >= 0);
+    size = divRoundUp(size, PoolAlign) * PoolAlign;
+    if (size > ArenaChunkSize - PoolAlign) {
+	p = new char[PoolAlign + size];
+	NextOf(p) = bigBlocks;
+	bigBlocks = p;
+	return p + PoolAlign;
+    }
+    if (used + size > ArenaChunkSize) {
+	p = (char *) chunkPool->Get();
+	NextOf(p) = chunks;
+	chunks = p;
+	used = PoolAlign;
+    }
+    p = (char *) chunks + used;
+    used += size;
+    return p;
+}
@@ -0,0 +1,80 @@
+// pool.h
+//	Data structures for handing out memory without going to the
+//	host's allocator every time.
+//
+//	A Pool hands out blocks that are all the same size.  It gets
+//	them from the host a "slab" at a time, and keeps the blocks
+//	given back to it on a free list, to hand out again.  So once
+//	the program has warmed up, a Pool doesn't call "new" at all.
+//
+//	An Arena hands out blocks of any size, by moving a pointer
+//	along a chunk of memory.  The blocks can't be given back one
+//	at a time; they are all freed at once when the Arena is
+//	deleted.  This suits the temporary buffers of a single
+//	operation: declare the Arena as a local variable, and
+//	everything allocated from it goes away when the operation
+//	returns.  The chunks come from a Pool, so the next Arena
+//	reuses them.
+//
+//	Neither ever waits, so in the kernel (where we only switch
+//	threads when interrupts are re-enabled) they need no locking.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "copyright.h"
+
+// The following class defines a pool of fixed size blocks.
+
+class Pool {
+  public:
+    Pool(char *debugName, int size, int perSlab = 16);
+    				// initialize a pool of "size" byte blocks
+    ~Pool();			// give the slabs back to the host; the
+				// blocks must not be used after this
+
+    void *Get();		// allocate a block
+    void Put(void *block);	// free a block
+
+    void Print();		// print how much is allocated
+
+  private:
+    char *name;			// useful for debugging
+    int blockSize;		// how big each block is, rounded up
+    int blocksPerSlab;		// how many blocks to get from the host
+				// at a time
+    void *freeList;		// free blocks, each holding a pointer
+				// to the next
+    void *slabs;		// slabs we got from the host, likewise
+    int numSlabs;		// how many there are
+    int numInUse;		// how many blocks are handed out
+};
+
+// Size of the chunks an Arena gets from its Pool.  Anything bigger
+// comes straight from the host.
+const int ArenaChunkSize = 4096;
+
+// The following class defines an arena, that frees everything
+// allocated from it at once.
+
+class Arena {
+  public:
+    Arena();			// initialize an empty arena
+    ~Arena();			// free everything allocated from it
+
+    void *Alloc(int size);	// allocate "size" bytes
+
+  private:
+    void *chunks;		// chunks in use, the newest first, each
+				// holding a pointer to the next
+    void *bigBlocks;		// oversize blocks from the host, likewise
+    int used;			// bytes used in the newest chunk
+
+    static Pool *chunkPool;	// where all arenas get their chunks
+};
+
+#endif // POOL_H
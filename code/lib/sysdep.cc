@@ -149,6 +149,21 @@ UDelay(unsigned int useconds)
 
 }
 
+//----------------------------------------------------------------------
+// HostSeconds
+// 	Return the host's wall clock time, in seconds, for measuring
+//	how fast the simulation itself runs.
+//----------------------------------------------------------------------
+
+double
+HostSeconds()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // Abort
 // 	Quit and drop core.
@@ -502,6 +517,31 @@ PollSocket(int sockID)
     return PollFile(sockID);	// on UNIX, socket ID's are just file ID's
 }
 
+//----------------------------------------------------------------------
+// WaitForSocket
+// 	Block the Nachos process until a message arrives on the IPC port.
+//	Used when the simulated machine has nothing else to do, so that
+//	an idle Nachos doesn't spin polling its network.
+//
+//	Returns TRUE if a message is waiting, FALSE if the wait was
+//	cut short by a signal.
+//----------------------------------------------------------------------
+bool
+WaitForSocket(int sockID)
+{
+    fd_set rfd;
+    int retVal;
+
+    FD_ZERO(&rfd);
+    FD_SET(sockID, &rfd);
+
+    // no timeout -- wait as long as it takes
+    retVal = select(sockID + 1, &rfd, NULL, NULL, NULL);
+
+    ASSERT((retVal == 1) || (retVal < 0 && errno == EINTR));
+    return (retVal == 1);
+}
+
 //----------------------------------------------------------------------
 // ReadFromSocket
 // 	Read a fixed size packet off the IPC port.  Abort on error.
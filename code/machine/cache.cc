@@ -0,0 +1,109 @@
+// cache.cc
+//	Routines to simulate the memory caches.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cache.h"
+#include "debug.h"
+
+// The tag of an empty way; no line of memory has this number.
+const unsigned int NoLine = 0xffffffff;
+
+//----------------------------------------------------------------------
+// Cache::Cache
+// 	Initialize an empty cache.
+//
+//	"debugName" -- a name, for printing
+//	"config" -- its geometry; the size, line size and number of sets
+//		must be powers of two
+//	"nextLevel" -- where misses go, or NULL for main memory
+//----------------------------------------------------------------------
+
+Cache::Cache(char *debugName, CacheConfig *config, Cache *nextLevel)
+{
+    name = debugName;
+    ways = config->ways;
+    missPenalty = config->missPenalty;
+    next = nextLevel;
+    ASSERT(config->size > 0 && config->lineSize >= 4 && ways > 0);
+    ASSERT(config->size % (config->lineSize * ways) == 0);
+    numSets = config->size / (config->lineSize * ways);
+    ASSERT((numSets & (numSets - 1)) == 0);
+    ASSERT((config->lineSize & (config->lineSize - 1)) == 0);
+    for (lineShift = 0; (1 << lineShift) < config->lineSize; lineShift++)
+	;
+    tags = new unsigned int[numSets * ways];
+    for (int i = 0; i < numSets * ways; i++) {
+	tags[i] = NoLine;
+    }
+    numAccesses = numMisses = 0;
+}
+
+//----------------------------------------------------------------------
+// Cache::~Cache
+// 	De-allocate the cache.
+//----------------------------------------------------------------------
+
+Cache::~Cache()
+{
+    delete [] tags;
+}
+
+//----------------------------------------------------------------------
+// Cache::Access
+// 	Look for the line holding "physAddr".  On a hit, it becomes the
+//	most recently used line of its set.  On a miss, it is fetched
+//	from the next level, and replaces the least recently used line.
+//
+//	Returns the ticks the access cost: 0 on a hit.
+//----------------------------------------------------------------------
+
+int
+Cache::Access(unsigned int physAddr)
+{
+    unsigned int line = physAddr >> lineShift;
+    unsigned int *set = &tags[(line & (numSets - 1)) * ways];
+    bool hit;
+    int i;
+
+    numAccesses++;
+    if (set[0] == line) {		// the usual case
+	return 0;
+    }
+    for (i = 1; i < ways && set[i] != line; i++)
+	;
+    hit = (i < ways);
+    if (!hit) {				// drop the LRU line
+	numMisses++;
+	i = ways - 1;
+    }
+    for (; i > 0; i--) {		// and move this one to the front
+	set[i] = set[i - 1];
+    }
+    set[0] = line;
+    if (hit) {
+	return 0;
+    }
+    if (next == NULL) {
+	return missPenalty;
+    }
+    return missPenalty + next->Access(physAddr);
+}
+
+//----------------------------------------------------------------------
+// Cache::Print
+// 	Print how often we missed.
+//----------------------------------------------------------------------
+
+void
+Cache::Print()
+{
+    cout << name << ": accesses " << numAccesses << ", misses " << numMisses;
+    if (numAccesses > 0) {
+	cout << " (" << (numMisses * 100.0) / numAccesses << "%)";
+    }
+    cout << "\n";
+}
@@ -0,0 +1,67 @@
+// cache.h
+//	Data structures to simulate the memory caches of the simulated
+//	machine, so that how a user program uses memory shows up in
+//	how long it takes.
+//
+//	Each level of cache is set associative, with LRU replacement.
+//	It only keeps the tags of the lines it holds -- the data always
+//	comes from "mainMemory" -- and they are packed into one array,
+//	with each set in most recently used order, so that a hit on the
+//	most recently used line takes a single comparison.
+//
+//	A miss costs the level's miss penalty, plus whatever the access
+//	costs at the next level down.  Writes are treated like reads
+//	(write-allocate), and writing back dirty lines is not charged.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "copyright.h"
+
+// The following class describes one level of cache.  "size" is 0
+// if there is no such level.
+
+class CacheConfig {
+  public:
+    CacheConfig() { size = 0; lineSize = 32; ways = 1; missPenalty = 10; }
+
+    int size;			// bytes of data it holds
+    int lineSize;		// bytes in each line
+    int ways;			// lines in each set
+    int missPenalty;		// ticks a miss costs
+};
+
+// The following class defines one level of cache.
+
+class Cache {
+  public:
+    Cache(char *debugName, CacheConfig *config, Cache *nextLevel);
+    				// Initialize an empty cache
+    ~Cache();			// De-allocate it
+
+    int Access(unsigned int physAddr);
+    				// Reference a byte of memory; returns
+				// how many ticks it cost, beyond the
+				// instruction itself
+
+    void Print();		// Print the miss rate
+
+  private:
+    char *name;			// for printing
+    unsigned int *tags;		// the line in each way of each set,
+				// most recently used first
+    int numSets;
+    int ways;
+    int lineShift;		// log2 of the line size
+    int missPenalty;
+    Cache *next;		// the next level down, or NULL for memory
+
+    int numAccesses;
+    int numMisses;
+};
+
+#endif // CACHE_H
@@ -39,6 +39,7 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
 
     // start polling for incoming keystrokes
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+    polling = true;
 }
 
 //----------------------------------------------------------------------
@@ -69,8 +70,10 @@ ConsoleInput::CallBack()
   int readCount;
 
     ASSERT(incoming == EOF);
+    polling = false;
 	// 2015.11.25
 	// do not schedule any more interrupts if console is disabled
+	// (until Enable)
 	if (disabled) {
 		return;
 	}
@@ -78,6 +81,7 @@ ConsoleInput::CallBack()
     if (!PollFile(readFileNo)) { // nothing to be read
         // schedule the next time to poll for a packet
         kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+        polling = true;
     } else { 
     	// otherwise, try to read a character
     	readCount = ReadPartial(readFileNo, &c, sizeof(char));
@@ -112,11 +116,30 @@ ConsoleInput::GetChar()
 
    if (incoming != EOF) {	// schedule when next char will arrive
        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+       polling = true;
    }
    incoming = EOF;
    return ch;
 }
 
+//----------------------------------------------------------------------
+// ConsoleInput::Enable()
+// 	Undo Disable: someone wants to read the keyboard after all.  If
+//	polling has stopped, start it again -- unless a character is
+//	already waiting to be got.  At the end of a file, this polls it
+//	again, so each read there gets EOF.
+//----------------------------------------------------------------------
+
+void
+ConsoleInput::Enable()
+{
+    disabled = false;
+    if (!polling && incoming == EOF) {
+	kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+	polling = true;
+    }
+}
+
 
 
 //----------------------------------------------------------------------
@@ -167,7 +190,8 @@ ConsoleOutput::CallBack()
 //----------------------------------------------------------------------
 // ConsoleOutput::PutChar()
 // 	Write a character to the simulated display, schedule an interrupt 
-//	to occur in the future, and return.
+//	to occur in the future, and return.  In untimed mode, the
+//	display is ready for the next one right away: no interrupt.
 //----------------------------------------------------------------------
 
 void
@@ -175,6 +199,10 @@ ConsoleOutput::PutChar(char ch)
 {
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
+    if (kernel->untimed) {
+	kernel->stats->numConsoleCharsWritten++;
+	return;
+    }
     putBusy = TRUE;
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
 }
@@ -59,6 +59,7 @@ class ConsoleInput : public CallBackObj {
 				// from the keyboard.
 				
 	void Disable() { disabled = true; } // 2015.11.25
+	void Enable();		// start polling again after Disable
 
   private:
     int readFileNo;			// UNIX file emulating the keyboard 
@@ -69,6 +70,7 @@ class ConsoleInput : public CallBackObj {
 					// Otherwise contains EOF.
 	//2015.11.25
 	bool disabled;
+	bool polling;		// is the next poll scheduled?
 };
 
 class ConsoleOutput : public CallBackObj {
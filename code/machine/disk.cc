@@ -15,6 +15,7 @@
 
 #include "copyright.h"
 #include "disk.h"
+#include "disktrace.h"
 #include "debug.h"
 #include "sysdep.h"
 #include "main.h"
@@ -35,19 +36,25 @@ const int DiskSize = (MagicSize + (NumSectors * SectorSize));
 // 	ok to treat it as Nachos disk storage.
 //
 //	"toCall" -- object to call when disk read/write request completes
+//	"diskUnit" -- which of this machine's disks, or -1 if it only has one
 //----------------------------------------------------------------------
 
-Disk::Disk(CallBackObj *toCall)
+Disk::Disk(CallBackObj *toCall, int diskUnit)
 {
     int magicNum;
     int tmp = 0;
 
     DEBUG(dbgDisk, "Initializing the disk.");
     callWhenDone = toCall;
+    unit = max(diskUnit, 0);
     lastSector = 0;
     bufferInit = 0;
     
-    sprintf(diskname,"DISK_%d",kernel->hostName);
+    if (diskUnit < 0) {
+	sprintf(diskname,"DISK_%d",kernel->hostName);
+    } else {
+	sprintf(diskname,"DISK_%d_%d",kernel->hostName,diskUnit);
+    }
     fileno = OpenForReadWrite(diskname, FALSE);
     if (fileno >= 0) {		 	// file exists, check magic number 
 	Read(fileno, (char *) &magicNum, MagicSize);
@@ -102,6 +109,8 @@ PrintSector (bool writing, int sector, char *data)
 //	   Set up an interrupt handler to be called later,
 //	      that will notify the caller when the simulator says
 //	      the operation has completed.
+//	In untimed mode (-untimed) the request is complete when we
+//	return, and there is no interrupt.
 //
 //	Note that a disk only allows an entire sector to be read/written,
 //	not part of a sector.
@@ -113,8 +122,6 @@ PrintSector (bool writing, int sector, char *data)
 void
 Disk::ReadRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
-
     ASSERT(!active);				// only one request at a time
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
     
@@ -123,18 +130,13 @@ Disk::ReadRequest(int sectorNumber, char* data)
     Read(fileno, data, SectorSize);
     if (debug->IsEnabled('d'))
 	PrintSector(FALSE, sectorNumber, data);
-    
-    active = TRUE;
-    UpdateLast(sectorNumber);
     kernel->stats->numDiskReads++;
-    kernel->interrupt->Schedule(this, ticks, DiskInt);
+    ScheduleDone(sectorNumber, FALSE);
 }
 
 void
 Disk::WriteRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
-
     DEBUG(dbgDisk, "Writing to sector " << sectorNumber);
     ASSERT(!active);
     ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
@@ -143,11 +145,35 @@ Disk::WriteRequest(int sectorNumber, char* data)
     WriteFile(fileno, data, SectorSize);
     if (debug->IsEnabled('d'))
 	PrintSector(TRUE, sectorNumber, data);
-    
-    active = TRUE;
-    UpdateLast(sectorNumber);
     kernel->stats->numDiskWrites++;
-    kernel->interrupt->Schedule(this, ticks, DiskInt);
+    ScheduleDone(sectorNumber, TRUE);
+}
+
+//----------------------------------------------------------------------
+// Disk::ScheduleDone
+// 	Arrange for the interrupt that says a request is done, when the
+//	simulated disk would have got to it -- unless we are untimed,
+//	in which case it is done already (see SynchDisk).  If we are
+//	tracing requests (-dtrace), record this one.
+//
+//	"sectorNumber" -- the sector being read or written
+//	"writing" -- TRUE for a write
+//----------------------------------------------------------------------
+
+void
+Disk::ScheduleDone(int sectorNumber, bool writing)
+{
+    int ticks = 0;
+
+    if (!kernel->untimed) {
+	ticks = ComputeLatency(sectorNumber, writing);
+	active = TRUE;
+	UpdateLast(sectorNumber);
+	kernel->interrupt->Schedule(this, ticks, DiskInt);
+    }
+    if (kernel->diskTrace != NULL) {
+	kernel->diskTrace->Record(unit, sectorNumber, writing, ticks);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -57,9 +57,12 @@ const int NumSectors = (SectorsPerTrack * TracksPerPlate * NumPlate);
 
 class Disk : public CallBackObj {
   public:
-    Disk(CallBackObj *toCall);          // Create a simulated disk.  
+    Disk(CallBackObj *toCall, int unit = -1);
+					// Create a simulated disk.  
 					// Invoke toCall->CallBack() 
 					// when each request completes.
+					// "unit" numbers the disks of a
+					// machine that has more than one.
     ~Disk();				// Deallocate the disk.
     
     void ReadRequest(int sectorNumber, char* data);
@@ -79,6 +82,7 @@ class Disk : public CallBackObj {
 
   private:
     int fileno;				// UNIX file number for simulated disk 
+    int unit;				// which of the machine's disks
     char diskname[32];			// name of simulated disk's file
     CallBackObj *callWhenDone;		// Invoke when any disk request finishes
     bool active;     			// Is a disk operation in progress?
@@ -89,6 +93,8 @@ class Disk : public CallBackObj {
     int TimeToSeek(int newSector, int *rotate); // time to get to the new track
     int ModuloDiff(int to, int from);        // # sectors between to and from
     void UpdateLast(int newSector);
+    void ScheduleDone(int sectorNumber, bool writing);
+    					// finish starting a request
 };
 
 #endif // DISK_H
@@ -0,0 +1,93 @@
+// disktrace.cc
+//	Routines to record a trace of the requests made to the
+//	simulated disks.  See disktrace.h for the format.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "disktrace.h"
+#include "disk.h"
+#include "stats.h"
+#include "debug.h"
+#include "sysdep.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// DiskTrace::DiskTrace
+// 	Create the trace file, and write its header.
+//
+//	"fileName" -- the UNIX file to write the trace to
+//	"numDisks" -- how many disks requests can go to
+//----------------------------------------------------------------------
+
+DiskTrace::DiskTrace(char *fileName, int numDisks)
+{
+    DiskTraceHeader header;
+
+    fileno = OpenForWrite(fileName);
+    header.magic = DISKTRACEMAGIC;
+    header.sectorSize = SectorSize;
+    header.sectorsPerTrack = SectorsPerTrack;
+    header.numSectors = NumSectors;
+    header.rotationTime = RotationTime;
+    header.seekTime = SeekTime;
+    header.numDisks = numDisks;
+    WriteFile(fileno, (char *) &header, sizeof(DiskTraceHeader));
+    numBuffered = 0;
+    numRecords = 0;
+    DEBUG(dbgDisk, "Tracing disk requests to " << fileName);
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::~DiskTrace
+// 	Write out the records still buffered, and close the trace.
+//----------------------------------------------------------------------
+
+DiskTrace::~DiskTrace()
+{
+    Flush();
+    Close(fileno);
+    DEBUG(dbgDisk, "Traced " << numRecords << " disk requests");
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::Record
+// 	Add a request to the trace.  Called by the disk as each request
+//	is made.
+//
+//	"unit" -- which disk (0 if there is only one)
+//	"sector" -- the sector on that disk
+//	"writing" -- TRUE for a write, FALSE for a read
+//	"latency" -- how long the disk will take over it
+//----------------------------------------------------------------------
+
+void
+DiskTrace::Record(int unit, int sector, bool writing, int latency)
+{
+    DiskTraceRecord *record = &buffer[numBuffered];
+
+    record->tick = kernel->stats->totalTicks;
+    record->request = DiskTraceRequest(sector, unit, writing);
+    record->latency = latency;
+    numRecords++;
+    if (++numBuffered == DiskTraceBufferSize) {
+	Flush();
+    }
+}
+
+//----------------------------------------------------------------------
+// DiskTrace::Flush
+// 	Write the buffered records to the trace file.
+//----------------------------------------------------------------------
+
+void
+DiskTrace::Flush()
+{
+    if (numBuffered > 0) {
+	WriteFile(fileno, (char *) buffer,
+			numBuffered * sizeof(DiskTraceRecord));
+	numBuffered = 0;
+    }
+}
@@ -0,0 +1,81 @@
+// disktrace.h
+//	Data structures to record every request made to the simulated
+//	disks (-dtrace), so that it can be replayed later without Nachos.
+//
+//	A trace file is a DiskTraceHeader, followed by one
+//	DiskTraceRecord per request, in the order they were made.  The
+//	header gives the disk geometry and timing the trace was made
+//	with.  Everything is in the host's byte order; the magic number
+//	tells a reader if that isn't its own.
+//
+//	The replay tool (disktrace/replay.cc, next to coff2noff) reads
+//	this file too, so it uses nothing else from Nachos.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DISKTRACE_H
+#define DISKTRACE_H
+
+#include "copyright.h"
+
+#define DISKTRACEMAGIC	0x44747231	// "Dtr1"
+
+// The start of a trace file
+
+class DiskTraceHeader {
+  public:
+    int magic;			// DISKTRACEMAGIC
+    int sectorSize;		// bytes in a sector
+    int sectorsPerTrack;
+    int numSectors;		// on each disk
+    int rotationTime;		// ticks for one sector to pass the head
+    int seekTime;		// ticks to move the head one track
+    int numDisks;		// how many disks the requests went to
+};
+
+// One request, in 12 bytes.  The sector, the disk and whether it
+// was a write are packed into one word.
+
+class DiskTraceRecord {
+  public:
+    int tick;			// when it was made
+    int request;		// see DiskTraceRequest
+    int latency;		// ticks it took; 0 if -untimed
+};
+
+#define DiskTraceRequest(sector, unit, writing) \
+			(((sector) << 4) | ((unit) << 1) | ((writing) ? 1 : 0))
+#define DiskTraceSector(request)	((request) >> 4)
+#define DiskTraceUnit(request)		(((request) >> 1) & 7)
+#define DiskTraceWriting(request)	((request) & 1)
+
+#ifndef DISKTRACE_REPLAY
+
+// The following class records a trace while Nachos runs.  Records
+// are buffered, and written to the host a block at a time.
+
+#define DiskTraceBufferSize	512	// records written at once
+
+class DiskTrace {
+  public:
+    DiskTrace(char *fileName, int numDisks);
+    				// start a trace, in the UNIX file "fileName"
+    ~DiskTrace();		// write out the rest, and close it
+
+    void Record(int unit, int sector, bool writing, int latency);
+    				// a request has been sent to a disk
+
+  private:
+    int fileno;			// UNIX file number of the trace
+    DiskTraceRecord buffer[DiskTraceBufferSize];
+    int numBuffered;
+    int numRecords;		// how many there have been in all
+
+    void Flush();		// write the buffered records out
+};
+
+#endif // DISKTRACE_REPLAY
+
+#endif // DISKTRACE_H
@@ -22,6 +22,7 @@
 
 #include "copyright.h"
 #include "interrupt.h"
+#include "network.h"
 #include "main.h"
 
 // String definitions for debugging messages
@@ -29,7 +30,7 @@
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
 			"console read", "network send", 
-			"network recv"};
+			"network recv", "network timer"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -72,7 +73,9 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new SortedIntrusiveList<PendingInterrupt>(PendingCompare);
+    freePending = new IntrusiveList<PendingInterrupt>;
+    network = NULL;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -89,6 +92,10 @@ Interrupt::~Interrupt()
 	delete pending->RemoveFront();
     }
     delete pending;
+    while (!freePending->IsEmpty()) {
+	delete freePending->RemoveFront();
+    }
+    delete freePending;
 }
 
 //----------------------------------------------------------------------
@@ -202,13 +209,17 @@ Interrupt::YieldOnReturn()
 //	simulated time until the next scheduled hardware interrupt.
 //
 //	If there are no pending interrupts, stop.  There's nothing
-//	more for us to do.
+//	more for us to do -- unless the network is running, in which
+//	case we wait (in real time) for the next packet to arrive.
 //----------------------------------------------------------------------
 void
 Interrupt::Idle()
 {
     DEBUG(dbgInt, "Machine idling; checking for interrupts.");
     status = IdleMode;
+    if (network != NULL) {
+	network->CheckArrival(pending->IsEmpty());
+    }
     if (CheckIfDue(TRUE)) {	// check for any pending interrupts
 		status = SystemMode;
 		return;			// return in case there's now
@@ -287,6 +298,11 @@ int Interrupt::SeekFile(int position,int fd)
     return kernel->SeekFile(position,fd);
 }
 
+int Interrupt::SyncFile(int fd)
+{
+    return kernel->SyncFile(fd);
+}
+
 int Interrupt::RemoveFile(char *filename)
 {
     return kernel->RemoveFile(filename);
@@ -298,7 +314,9 @@ int Interrupt::RemoveFile(char *filename)
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: just put it on a sorted list.  The list is
+//	linked through the PendingInterrupts, and those that have gone
+//	off are re-used, so this doesn't normally allocate anything.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -312,7 +330,16 @@ void
 Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
 {
     int when = kernel->stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type);
+    PendingInterrupt *toOccur;
+
+    if (freePending->IsEmpty()) {
+	toOccur = new PendingInterrupt(toCall, when, type);
+    } else {
+	toOccur = freePending->RemoveFront();
+	toOccur->callOnInterrupt = toCall;
+	toOccur->when = when;
+	toOccur->type = type;
+    }
 
     DEBUG(dbgInt, "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << when);
     ASSERT(fromNow > 0);
@@ -320,6 +347,29 @@ Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
     pending->Insert(toOccur);
 }
 
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Take an interrupt off the pending list, if it is still there,
+//	as if it had never been scheduled.  Used by devices that can be
+//	turned off, like the timer.
+//
+//	"toCall" and "type" are what the interrupt was scheduled with
+//----------------------------------------------------------------------
+void
+Interrupt::Cancel(CallBackObj *toCall, IntType type)
+{
+    PendingInterrupt *p;
+
+    for (p = pending->Front(); p != NULL; p = p->link.next) {
+	if (p->callOnInterrupt == toCall && p->type == type) {
+	    DEBUG(dbgInt, "Cancelling interrupt handler the " << intTypeNames[type] << " at time = " << p->when);
+	    pending->Remove(p);
+	    freePending->Prepend(p);
+	    return;
+	}
+    }
+}
+
 //----------------------------------------------------------------------
 // Interrupt::CheckIfDue
 // 	Check if any interrupts are scheduled to occur, and if so, 
@@ -365,12 +415,15 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (kernel->machine != NULL) {
     	kernel->machine->DelayedLoad(0, 0);
     }
+    if (network != NULL) {		// piggyback a check for packets
+	network->CheckArrival(FALSE);	// on every interrupt we take
+    }
 
     inHandler = TRUE;
     do {
         next = pending->RemoveFront();    // pull interrupt off list
         next->callOnInterrupt->CallBack();// call the interrupt handler
-	delete next;
+	freePending->Prepend(next);
     } while (!pending->IsEmpty() 
     		&& (pending->Front()->when <= stats->totalTicks));
     inHandler = FALSE;
@@ -37,6 +37,8 @@
 #include "list.h"
 #include "callback.h"
 
+class NetworkInput;
+
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
 
@@ -47,9 +49,11 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network.  NetworkTimerInt is not a
+// device: it is the retransmit timer of the reliable transport, kept
+// apart from the hardware timer.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-			NetworkSendInt, NetworkRecvInt};
+			NetworkSendInt, NetworkRecvInt, NetworkTimerInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -66,6 +70,9 @@ class PendingInterrupt {
     
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+
+    ListLink<PendingInterrupt> link;
+				// On the pending list, or the free list
 };
 
 // The following class defines the data structures for the simulation
@@ -106,6 +113,7 @@ class Interrupt {
     int WriteFile(char *buf, int size, int fd);
     int CloseFile(int fd);
     int SeekFile(int position,int fd);
+    int SyncFile(int fd);
     int RemoveFile(char *filename);
     #endif 
 
@@ -117,6 +125,11 @@ class Interrupt {
         			// idle, kernel, user
 
     void DumpState();		// Print interrupt state
+
+    void WatchNetwork(NetworkInput *input) { network = input; }
+				// Check this network device for 
+				// arriving packets whenever time is
+				// about to advance (NULL to stop)
     
 
     // NOTE: the following are internal to the hardware simulation code.
@@ -128,15 +141,22 @@ class Interrupt {
     				// Schedule an interrupt to occur
 				// at time "when".  This is called
     				// by the hardware device simulators.
+    void Cancel(CallBackObj *callTo, IntType type);
+				// Take back an interrupt that was
+				// scheduled, if it hasn't happened yet
     
     void OneTick();       	// Advance simulated time
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;		
+    SortedIntrusiveList<PendingInterrupt> *pending;		
     				// the list of interrupts scheduled
 				// to occur in the future
+    IntrusiveList<PendingInterrupt> *freePending;
+				// ones that have gone off, kept for
+				// the next Schedule
     //int writeFileNo;            //UNIX file emulating the display
+    NetworkInput *network;	// device to check for arriving packets
     bool inHandler;		// TRUE if we are running an interrupt handler
     //bool putBusy;               // Is a PrintInt operation in progress
                                   //If so, you cannoot do another one
@@ -50,26 +50,45 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"physPages", "pageBytes" -- how many pages of physical memory
+//		there are, and how big they are
+//	"tlbEntries", "tlbWays", "tlbPolicy" -- the TLB's geometry; if
+//		"tlbEntries" is 0 there is none, unless USE_TLB is defined
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, int physPages, int pageBytes, int tlbEntries,
+		int tlbWays, TlbPolicy tlbPolicy)
 {
     int i;
 
+    ASSERT(physPages > 0 && pageBytes >= 4);
+    ASSERT((pageBytes & (pageBytes - 1)) == 0);	// a power of 2
+    ASSERT(physPages <= 0x7fffffff / pageBytes);	// and all addressable
+    pageSize = pageBytes;
+    for (pageShift = 0; (1 << pageShift) < pageSize; pageShift++)
+	;
+    numPhysPages = physPages;
+    memorySize = numPhysPages * pageSize;
+
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
-    mainMemory = new char[MemorySize];
-    for (i = 0; i < MemorySize; i++)
-      	mainMemory[i] = 0;
+    mainMemory = new char[memorySize];
+    bzero(mainMemory, memorySize);
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// use linear page table
-    tlb = NULL;
-    pageTable = NULL;
+    if (tlbEntries == 0) {
+	tlbEntries = tlbWays = TLBSize;		// fully associative
+    }
 #endif
+    if (tlbEntries > 0) {
+	tlb = new Tlb(tlbEntries, (tlbWays > 0) ? tlbWays : tlbEntries,
+				tlbPolicy);
+    } else {			// use linear page table
+	tlb = NULL;
+    }
+    pageTable = NULL;
+    asid = 0;
+    icache = dcache = l2cache = NULL;
+    fetchPath = dataPath = NULL;		// memory is free
 
     singleStep = debug;
     CheckEndian();
@@ -84,7 +103,71 @@ Machine::~Machine()
 {
     delete [] mainMemory;
     if (tlb != NULL)
-        delete [] tlb;
+        delete tlb;
+    delete icache;
+    delete dcache;
+    delete l2cache;
+}
+
+//----------------------------------------------------------------------
+// Machine::SetUpCaches
+// 	Put caches between the CPU and memory.  Instruction fetches go
+//	to the L1 instruction cache, loads and stores to the L1 data
+//	cache, and both to the L2 cache on a miss.  A level with size
+//	0 is left out.
+//----------------------------------------------------------------------
+
+void
+Machine::SetUpCaches(CacheConfig *l1i, CacheConfig *l1d, CacheConfig *l2)
+{
+    if (l2->size > 0) {
+	l2cache = new Cache("L2 cache", l2, NULL);
+    }
+    if (l1i->size > 0) {
+	icache = new Cache("L1 instruction cache", l1i, l2cache);
+    }
+    if (l1d->size > 0) {
+	dcache = new Cache("L1 data cache", l1d, l2cache);
+    }
+    fetchPath = (icache != NULL) ? icache : l2cache;
+    dataPath = (dcache != NULL) ? dcache : l2cache;
+}
+
+//----------------------------------------------------------------------
+// Machine::CacheAccess
+// 	Send a memory reference through the caches, and charge the
+//	user program for the time the misses take.
+//----------------------------------------------------------------------
+
+void
+Machine::CacheAccess(Cache *first, int physAddr)
+{
+    int stall = first->Access(physAddr);
+
+    if (stall > 0) {
+	kernel->stats->totalTicks += stall;
+	kernel->stats->userTicks += stall;
+	kernel->stats->memoryStallTicks += stall;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::PrintCaches
+// 	Print the miss rate of each level of cache.
+//----------------------------------------------------------------------
+
+void
+Machine::PrintCaches()
+{
+    if (icache != NULL) {
+	icache->Print();
+    }
+    if (dcache != NULL) {
+	dcache->Print();
+    }
+    if (l2cache != NULL) {
+	l2cache->Print();
+    }
 }
 
 //----------------------------------------------------------------------
@@ -24,21 +24,20 @@
 #include "copyright.h"
 #include "utility.h"
 #include "translate.h"
+#include "cache.h"
 
-// Definitions related to the size, and format of user memory
+// Definitions related to the size, and format of user memory.
+// These are only the defaults: the kernel can give the machine
+// a different amount of memory, or page size, when it starts up
+// (see Machine::pageSize and friends).
 
-const int PageSize = 128; 		// set the page size equal to
+const int DefaultPageSize = 128; 	// set the page size equal to
 					// the disk sector size, for simplicity
 
-//
-// You are allowed to change this value.
-// Doing so will change the number of pages of physical memory
-// available on the simulated machine.
-//
-const int NumPhysPages = 128;
+const int DefaultNumPhysPages = 128;	// pages of physical memory
 
-const int MemorySize = (NumPhysPages * PageSize);
-const int TLBSize = 4;			// if there is a TLB, make it small
+const int TLBSize = 4;			// if there is a TLB, make it small,
+					// unless told otherwise
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -93,8 +92,12 @@ class Interrupt;
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, int physPages = DefaultNumPhysPages,
+    		int pageBytes = DefaultPageSize, int tlbEntries = 0,
+		int tlbWays = 0, TlbPolicy tlbPolicy = TlbLRU);
+				// Initialize the simulation of the hardware
+				// for running user programs, with a TLB
+				// if "tlbEntries" > 0
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -113,6 +116,10 @@ class Machine {
 
     char *mainMemory;		// physical memory to store user program,
 				// code and data, while executing
+    int pageSize;		// bytes in a page, a power of 2
+    int pageShift;		// log2(pageSize)
+    int numPhysPages;		// pages of physical memory
+    int memorySize;		// bytes of it: numPhysPages * pageSize
 
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
@@ -132,17 +139,25 @@ class Machine {
 // Thus the TLB pointer should be considered as *read-only*, although 
 // the contents of the TLB are free to be modified by the kernel software.
 
-    TranslationEntry *tlb;		// this pointer should be considered 
+    Tlb *tlb;				// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int asid;				// the address space whose TLB
+					// entries are used
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
 
-    bool ReadMem(int addr, int size, int* value);
+    bool ReadMem(int addr, int size, int* value, bool fetch = FALSE);
     bool WriteMem(int addr, int size, int value);
     				// Read or write 1, 2, or 4 bytes of virtual 
 				// memory (at addr).  Return FALSE if a 
 				// correct translation couldn't be found.
+				// "fetch" is TRUE for instruction fetches.
+
+    void SetUpCaches(CacheConfig *l1i, CacheConfig *l1d, CacheConfig *l2);
+				// Simulate the given caches, charging
+				// for the misses in them
+    void PrintCaches();		// Print the caches' miss rates
   private:
 
 // Routines internal to the machine simulation -- DO NOT call these directly
@@ -165,6 +180,10 @@ class Machine {
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
 
+    void CacheAccess(Cache *first, int physAddr);
+				// Charge for a memory reference going
+				// through the caches, from "first" on
+
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
@@ -178,6 +197,12 @@ class Machine {
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
 
+    Cache *icache;		// the simulated caches, or NULL if
+    Cache *dcache;		// there is no such level
+    Cache *l2cache;
+    Cache *fetchPath;		// where instruction fetches start
+    Cache *dataPath;		// and loads and stores
+
     friend class Interrupt;		// calls DelayedLoad()    
 };
 
@@ -203,4 +228,8 @@ unsigned short ShortToHost(unsigned short shortword);
 unsigned int WordToMachine(unsigned int word);
 unsigned short ShortToMachine(unsigned short shortword);
 
+// The mnemonic for one of the simulator's opcodes (see mipssim.h).
+
+char *OpcodeName(int opCode);
+
 #endif // MACHINE_H
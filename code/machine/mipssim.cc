@@ -21,6 +21,7 @@
 #include "machine.h"
 #include "mipssim.h"
 #include "main.h"
+#include "profile.h"
 
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 
@@ -130,7 +131,7 @@ Machine::OneInstruction(Instruction *instr)
 				// in the future
 
     // Fetch instruction 
-    if (!ReadMem(registers[PCReg], 4, &raw))
+    if (!ReadMem(registers[PCReg], 4, &raw, TRUE))
 	return;			// exception occurred
     instr->value = raw;
     instr->Decode();
@@ -693,6 +694,10 @@ Machine::OneInstruction(Instruction *instr)
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
     
+    if (kernel->profiler != NULL) {
+	kernel->profiler->Count(instr->opCode, registers[PCReg]);
+    }
+
     // Advance program counters.
     registers[PrevPCReg] = registers[PCReg];	// for debugging, in case we
 						// are jumping into lala-land
@@ -717,6 +722,27 @@ Machine::DelayedLoad(int nextReg, int nextValue)
     registers[0] = 0; 	// and always make sure R0 stays zero.
 }
 
+//----------------------------------------------------------------------
+// OpcodeName
+// 	Return the mnemonic for an opcode: the first word of the
+//	format we print the instruction with.
+//----------------------------------------------------------------------
+
+char *
+OpcodeName(int opCode)
+{
+    static char name[16];
+    char *format = opStrings[opCode].format;
+    int i;
+
+    ASSERT(opCode >= 0 && opCode <= MaxOpcode);
+    for (i = 0; format[i] != '\0' && format[i] != ' ' && i < 15; i++) {
+	name[i] = format[i];
+    }
+    name[i] = '\0';
+    return name;
+}
+
 //----------------------------------------------------------------------
 // Instruction::Decode
 // 	Decode a MIPS instruction 
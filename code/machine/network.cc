@@ -31,8 +31,10 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
     AssignNameToSocket(sockName, sock);		 // Bind socket to a filename 
 						 // in the current directory.
 
-    // start polling for incoming packets
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    // rather than polling for incoming packets on a timer, ask the
+    // interrupt simulation to check the socket whenever it is about to
+    // move time forward (see CheckArrival)
+    kernel->interrupt->WatchNetwork(this);
 }
 
 //-----------------------------------------------------------------------
@@ -43,40 +45,55 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
 
 NetworkInput::~NetworkInput()
 {
+    kernel->interrupt->WatchNetwork(NULL);
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
 }
 
 //-----------------------------------------------------------------------
-// NetworkInput::CallBack
-//	Simulator calls this when a packet may be available to
-//	be read in from the simulated network.
+// NetworkInput::CheckArrival
+//	Simulator calls this whenever the machine goes idle, or is about
+//	to take some other interrupt.  If a packet is waiting on the host
+//	socket, and we have room to pull it in, raise a receive interrupt
+//	on the next tick.
 //
-//      First check to make sure packet is available & there's space to
-//	pull it in.  Then invoke the "callBack" registered by whoever 
-//	wants the packet.
+//	"wait" -- if TRUE, there are no other pending interrupts, so
+//		block the whole simulation until a packet arrives
+//		instead of halting
 //-----------------------------------------------------------------------
 
 void
-NetworkInput::CallBack()
+NetworkInput::CheckArrival(bool wait)
 {
-    // schedule the next time to poll for a packet
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    if (packetAvail || inHdr.length != 0)	// do nothing if packet is
+	return;					// already buffered
+    if (!PollSocket(sock)) {
+	if (!wait || !WaitForSocket(sock))
+	    return;			// do nothing if no packet to be read
+    }
+    packetAvail = TRUE;
+    kernel->interrupt->Schedule(this, 1, NetworkRecvInt);
+}
 
-    if (inHdr.length != 0) 	// do nothing if packet is already buffered
-	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
+//-----------------------------------------------------------------------
+// NetworkInput::CallBack
+//	Simulator calls this when a packet has been seen on the host
+//	socket and is to be read in from the simulated network.
+//
+//      The packet is read straight into our receive buffer, which is
+//	allocated once with the device.  Then invoke the "callBack"
+//	registered by whoever wants the packet.
+//-----------------------------------------------------------------------
 
-    // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+void
+NetworkInput::CallBack()
+{
+    ASSERT(packetAvail && inHdr.length == 0);
+    packetAvail = FALSE;
 
-    // divide packet into header and data
-    inHdr = *(PacketHeader *)buffer;
+    ReadFromSocket(sock, inWire, MaxWireSize);
+    inHdr = *(PacketHeader *)inWire;
     ASSERT((inHdr.to == kernel->hostName) && (inHdr.length <= MaxPacketSize));
-    bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
-    delete [] buffer ;
 
     DEBUG(dbgNet, "Network received packet from " << inHdr.from << ", length " << inHdr.length);
     kernel->stats->numPacketsRecvd++;
@@ -97,7 +114,7 @@ NetworkInput::Receive(char* data)
 
     inHdr.length = 0;
     if (hdr.length != 0) {
-    	bcopy(inbox, data, hdr.length);
+    	bcopy(inWire + sizeof(PacketHeader), data, hdr.length);
     }
     return hdr;
 }
@@ -149,7 +166,8 @@ NetworkOutput::CallBack()
 // NetworkOutput::Send
 // 	Send a packet into the simulated network, to the destination in hdr.
 // 	Concatenate hdr and data, and schedule an interrupt to tell the user 
-// 	when the next packet can be sent 
+// 	when the next packet can be sent (unless we are untimed, in which
+//	case it can be sent as soon as we return)
 //
 // 	Note we always pad out a packet to MaxWireSize before putting it into
 // 	the socket, because it's simpler at the receive end.
@@ -166,17 +184,19 @@ NetworkOutput::Send(PacketHeader hdr, char* data)
 	(hdr.length <= MaxPacketSize) && (hdr.from == kernel->hostName));
     DEBUG(dbgNet, "Sending to addr " << hdr.to << ", length " << hdr.length);
 
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkSendInt);
+    if (kernel->untimed) {		// ready to send again right away
+	kernel->stats->numPacketsSent++;
+    } else {
+	kernel->interrupt->Schedule(this, NetworkTime, NetworkSendInt);
+    }
 
     if (RandomNumber() % 100 >= chanceToWork * 100) { // emulate a lost packet
 	DEBUG(dbgNet, "oops, lost it!");
 	return;
     }
 
-    // concatenate hdr and data into a single buffer, and send it out
-    char *buffer = new char[MaxWireSize];
-    *(PacketHeader *)buffer = hdr;
-    bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
-    SendToSocket(sock, buffer, MaxWireSize, toName);
-    delete [] buffer;
+    // concatenate hdr and data into the send buffer, and send it out
+    *(PacketHeader *)outWire = hdr;
+    bcopy(data, outWire + sizeof(PacketHeader), hdr.length);
+    SendToSocket(sock, outWire, MaxWireSize, toName);
 }
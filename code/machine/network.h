@@ -66,7 +66,15 @@ class NetworkInput : public CallBackObj{
 				// If no packet is waiting, return a header 
 				// with length 0.
 
-    void CallBack();		// A packet may have arrived.
+    void CheckArrival(bool wait);
+				// Called by the interrupt simulation
+				// when it is about to advance time; 
+				// if a packet is waiting on the host 
+				// socket, raise an interrupt for it.
+				// If "wait" is TRUE, nothing else can
+				// happen, so block until one arrives.
+
+    void CallBack();		// A packet has arrived.
 
   private:
     int sock;                   // UNIX socket number for incoming packets
@@ -74,10 +82,11 @@ class NetworkInput : public CallBackObj{
 
     CallBackObj *callWhenAvail; // Interrupt handler, signalling packet has 
 				// 	arrived.
-    bool packetAvail;		// Packet has arrived, can be pulled off of
-				//   network
+    bool packetAvail;		// Interrupt has been raised for a packet
+				//   still on the host socket
     PacketHeader inHdr;		// Information about arrived packet
-    char inbox[MaxPacketSize];  // Data for arrived packet
+    char inWire[MaxWireSize];	// The arrived packet, header and data,
+				//   exactly as it came off the wire
 };
 
 class NetworkOutput : public CallBackObj {
@@ -105,6 +114,7 @@ class NetworkOutput : public CallBackObj {
     CallBackObj *callWhenDone;  // Interrupt handler, signalling next packet 
 				//      can be sent.  
     bool sendBusy;		// Packet is being sent.
+    char outWire[MaxWireSize];	// The packet being sent, header and data
 };
 
 #endif // NETWORK_H
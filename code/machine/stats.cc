@@ -22,6 +22,10 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numProgramLoads = numImageCacheHits = programLoadTicks = 0;
+    numTlbHits = numTlbMisses = numTlbFlushes = numTlbExitFlushes = 0;
+    memoryStallTicks = 0;
+    numContextSwitches = numRegisterLoads = numAddrSpaceLoads = 0;
 }
 
 //----------------------------------------------------------------------
@@ -42,4 +46,13 @@ Statistics::Print()
     cout << "Paging: faults " << numPageFaults << "\n";
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
+    cout << "Program loads: " << numProgramLoads << ", image cache hits "
+		<< numImageCacheHits << ", ticks " << programLoadTicks << "\n";
+    cout << "TLB: hits " << numTlbHits << ", misses " << numTlbMisses
+		<< ", flushes " << numTlbFlushes
+		<< ", flushes at exit " << numTlbExitFlushes << "\n";
+    cout << "Memory stalls: ticks " << memoryStallTicks << "\n";
+    cout << "Context switches: " << numContextSwitches
+		<< ", user register loads " << numRegisterLoads
+		<< ", address space loads " << numAddrSpaceLoads << "\n";
 }
@@ -35,6 +35,18 @@ class Statistics {
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numProgramLoads;	// number of user programs loaded
+    int numImageCacheHits;	// how many of them were already in memory
+    int programLoadTicks;	// time spent loading them
+    int numTlbHits;		// translations found in the TLB
+    int numTlbMisses;		// and not found, so loaded by the kernel
+    int numTlbFlushes;		// times address spaces were flushed from it
+				// to share an id
+    int numTlbExitFlushes;	// ... and because they went away
+    int memoryStallTicks;	// user time spent waiting for cache misses
+    int numContextSwitches;	// times the CPU went to another thread
+    int numRegisterLoads;	// times user registers had to be reloaded
+    int numAddrSpaceLoads;	// and address spaces
 
     Statistics(); 		// initialize everything to zero
 
@@ -40,6 +40,8 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
     randomize = doRandom;
     callPeriodically = toCall;
     disable = FALSE;
+    stopped = FALSE;
+    running = FALSE;
     SetInterrupt();
 }
 
@@ -52,11 +54,72 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
 void 
 Timer::CallBack() 
 {
+    running = FALSE;
+
     // invoke the Nachos interrupt handler for this device
     callPeriodically->CallBack();
     
-    SetInterrupt();	// do last, to let software interrupt handler
+    if (!running) {	// unless the handler stopped and restarted us
+	SetInterrupt();	// do last, to let software interrupt handler
     			// decide if it wants to disable future interrupts
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Start
+//      Start generating interrupts again after Stop().  If we are
+//	already running, leave the next interrupt where it is.
+//----------------------------------------------------------------------
+
+void
+Timer::Start()
+{
+    stopped = FALSE;
+    if (!running) {
+	SetInterrupt();
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Stop
+//      Stop generating interrupts until Start() is called, and take
+//	back the one already scheduled.
+//----------------------------------------------------------------------
+
+void
+Timer::Stop()
+{
+    stopped = TRUE;
+    if (running) {
+	kernel->interrupt->Cancel(this, TimerInt);
+	running = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Reprogram
+//      Move the next interrupt to "delay" ticks from now, starting the
+//	timer if it was stopped.  After that interrupt, the timer goes
+//	back to its usual interval.
+//----------------------------------------------------------------------
+
+void
+Timer::Reprogram(int delay)
+{
+    ASSERT(delay > 0);
+    if (disable) {
+	return;
+    }
+    stopped = FALSE;
+    if (running) {
+	if (due == kernel->stats->totalTicks + delay) {
+	    return;			// nothing to change
+	}
+	kernel->interrupt->Cancel(this, TimerInt);
+    }
+    kernel->interrupt->Schedule(this, delay, TimerInt);
+    due = kernel->stats->totalTicks + delay;
+    running = TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -69,7 +132,7 @@ Timer::CallBack()
 void
 Timer::SetInterrupt() 
 {
-    if (!disable) {
+    if (!disable && !stopped) {
        int delay = TimerTicks;
     
        if (randomize) {
@@ -77,5 +140,7 @@ Timer::SetInterrupt()
         }
        // schedule the next timer device interrupt
        kernel->interrupt->Schedule(this, delay, TimerInt);
+       due = kernel->stats->totalTicks + delay;
+       running = TRUE;
     }
 }
@@ -11,6 +11,9 @@
 //	In order to introduce some randomness into time-slicing, if "doRandom"
 //	is set, then the interrupt comes after a random number of ticks.
 //
+//	The timer can be stopped and started again, so that it needn't
+//	interrupt when there is nothing for it to do.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
@@ -35,12 +38,22 @@ class Timer : public CallBackObj {
     void Disable() { disable = TRUE; }
     				// Turn timer device off, so it doesn't
 				// generate any more interrupts.
+    void Start();		// Start interrupting, if we've stopped
+    void Stop();		// Stop interrupting for now
+    void Reprogram(int delay);	// Make the next interrupt come "delay"
+				// ticks from now, then carry on as usual
+    bool IsRunning() { return running; }
+    int NextInterrupt() { return due; }
+				// When is the next interrupt, if running?
 
   private:
     bool randomize;		// set if we need to use a random timeout delay
     CallBackObj *callPeriodically; // call this every TimerTicks time units 
     bool disable;		// turn off the timer device after next
     				// interrupt.
+    bool stopped;		// set by Stop(), cleared by Start()
+    bool running;		// is an interrupt scheduled?
+    int due;			// if so, when it will happen
     
     void CallBack();		// called internally when the hardware
 				// timer generates an interrupt
@@ -22,6 +22,8 @@
 //
 //	Note that the contents of the TLB are specific to an address space.
 //	If the address space changes, so does the contents of the TLB!
+//	Each entry is tagged with an address space id, and only matches
+//	while that address space is running.
 //
 // DO NOT CHANGE -- part of the machine emulation
 //
@@ -80,10 +82,11 @@ ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 //	"addr" -- the virtual address to read from
 //	"size" -- the number of bytes to read (1, 2, or 4)
 //	"value" -- the place to write the result
+//	"fetch" -- TRUE if this is an instruction fetch, for the caches
 //----------------------------------------------------------------------
 
 bool
-Machine::ReadMem(int addr, int size, int *value)
+Machine::ReadMem(int addr, int size, int *value, bool fetch)
 {
     int data;
     ExceptionType exception;
@@ -96,6 +99,9 @@ Machine::ReadMem(int addr, int size, int *value)
 	RaiseException(exception, addr);
 	return FALSE;
     }
+    if (fetch ? (fetchPath != NULL) : (dataPath != NULL)) {
+	CacheAccess(fetch ? fetchPath : dataPath, physicalAddress);
+    }
     switch (size) {
       case 1:
 	data = mainMemory[physicalAddress];
@@ -145,6 +151,9 @@ Machine::WriteMem(int addr, int size, int value)
 	RaiseException(exception, addr);
 	return FALSE;
     }
+    if (dataPath != NULL) {
+	CacheAccess(dataPath, physicalAddress);
+    }
     switch (size) {
       case 1:
 	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
@@ -184,7 +193,6 @@ Machine::WriteMem(int addr, int size, int value)
 ExceptionType
 Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 {
-    int i;
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
@@ -202,8 +210,8 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
 // calculate the virtual page number, and offset within the page,
 // from the virtual address
-    vpn = (unsigned) virtAddr / PageSize;
-    offset = (unsigned) virtAddr % PageSize;
+    vpn = (unsigned) virtAddr >> pageShift;
+    offset = (unsigned) virtAddr & (pageSize - 1);
     
     if (tlb == NULL) {		// => page table => vpn is index into table
 	if (vpn >= pageTableSize) {
@@ -215,11 +223,7 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	}
 	entry = &pageTable[vpn];
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))) {
-		entry = &tlb[i];			// FOUND!
-		break;
-	    }
+	entry = tlb->Lookup(vpn, asid);
 	if (entry == NULL) {				// not found
     	    DEBUG(dbgAddr, "Invalid TLB entry for this virtual page!");
     	    return PageFaultException;		// really, this is a TLB fault,
@@ -236,15 +240,166 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
     // if the pageFrame is too big, there is something really wrong! 
     // An invalid translation was loaded into the page table or TLB. 
-    if (pageFrame >= NumPhysPages) { 
+    if (pageFrame >= (unsigned) numPhysPages) { 
 	DEBUG(dbgAddr, "Illegal pageframe " << pageFrame);
 	return BusErrorException;
     }
     entry->use = TRUE;		// set the use, dirty bits
     if (writing)
 	entry->dirty = TRUE;
-    *physAddr = pageFrame * PageSize + offset;
-    ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
+    *physAddr = (pageFrame << pageShift) + offset;
+    ASSERT((*physAddr >= 0) && ((*physAddr + size) <= memorySize));
     DEBUG(dbgAddr, "phys addr = " << *physAddr);
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// Tlb::Tlb
+// 	Initialize an empty TLB.
+//
+//	"numEntries" -- how many translations it can hold
+//	"ways" -- how many entries in each set; "numEntries" makes it
+//		fully associative, 1 direct mapped
+//	"policy" -- which entry of a full set to replace
+//----------------------------------------------------------------------
+
+Tlb::Tlb(int tlbEntries, int tlbWays, TlbPolicy replacement)
+{
+    ASSERT(tlbEntries > 0 && tlbWays > 0 && tlbEntries % tlbWays == 0);
+    numEntries = tlbEntries;
+    ways = tlbWays;
+    numSets = numEntries / ways;
+    policy = replacement;
+    clock = 0;
+    entries = new TlbEntry[numEntries];
+    for (int i = 0; i < numEntries; i++) {
+	entries[i].entry.valid = FALSE;
+	entries[i].pte = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// Tlb::~Tlb
+// 	De-allocate the TLB.
+//----------------------------------------------------------------------
+
+Tlb::~Tlb()
+{
+    delete [] entries;
+}
+
+//----------------------------------------------------------------------
+// Tlb::Lookup
+// 	Search the set for "vpn" for a translation belonging to
+//	address space "asid".  Counts hits and misses.
+//
+//	Returns the translation, or NULL if it isn't in the TLB.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+Tlb::Lookup(int vpn, int asid)
+{
+    TlbEntry *set = &entries[(vpn % numSets) * ways];
+
+    for (int i = 0; i < ways; i++) {
+	if (set[i].entry.valid && set[i].entry.virtualPage == vpn
+				&& set[i].asid == asid) {
+	    if (policy == TlbLRU) {
+		set[i].stamp = ++clock;
+	    }
+	    kernel->stats->numTlbHits++;
+	    return &set[i].entry;
+	}
+    }
+    kernel->stats->numTlbMisses++;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Tlb::Load
+// 	Cache a translation from a page table.  An empty entry in the
+//	set is used if there is one; otherwise one is chosen by the
+//	replacement policy.
+//
+//	"pte" -- the page table entry to load
+//	"asid" -- the address space it belongs to
+//----------------------------------------------------------------------
+
+void
+Tlb::Load(TranslationEntry *pte, int asid)
+{
+    TlbEntry *set = &entries[(pte->virtualPage % numSets) * ways];
+    TlbEntry *victim = NULL;
+    int i;
+
+    for (i = 0; i < ways && victim == NULL; i++) {
+	if (!set[i].entry.valid) {
+	    victim = &set[i];
+	}
+    }
+    if (victim == NULL) {
+	if (policy == TlbRandom) {
+	    victim = &set[RandomNumber() % ways];
+	} else {		// oldest stamp, for both LRU and FIFO
+	    victim = &set[0];
+	    for (i = 1; i < ways; i++) {
+		if (set[i].stamp < victim->stamp) {
+		    victim = &set[i];
+		}
+	    }
+	}
+	Evict(victim);
+    }
+    DEBUG(dbgAddr, "TLB load, virtual page " << pte->virtualPage
+				<< ", address space " << asid);
+    victim->entry = *pte;
+    victim->entry.use = FALSE;
+    victim->entry.dirty = FALSE;
+    victim->asid = asid;
+    victim->pte = pte;
+    victim->stamp = ++clock;
+}
+
+//----------------------------------------------------------------------
+// Tlb::Evict
+// 	Copy the use and dirty bits of an entry back to the page table
+//	it came from, and free it.
+//----------------------------------------------------------------------
+
+void
+Tlb::Evict(TlbEntry *e)
+{
+    if (e->entry.use) {
+	e->pte->use = TRUE;
+    }
+    if (e->entry.dirty) {
+	e->pte->dirty = TRUE;
+    }
+    e->entry.valid = FALSE;
+    e->pte = NULL;
+}
+
+//----------------------------------------------------------------------
+// Tlb::Flush
+// 	Throw out the entries of address space "asid"; it is going
+//	away, or its id is being given to another one.  Only the second
+//	kind costs the running program anything, so the first is
+//	counted apart.
+//
+//	"exiting" -- is the address space going away?
+//----------------------------------------------------------------------
+
+void
+Tlb::Flush(int asid, bool exiting)
+{
+    if (exiting) {
+	kernel->stats->numTlbExitFlushes++;
+    } else {
+	kernel->stats->numTlbFlushes++;
+    }
+    for (int i = 0; i < numEntries; i++) {
+	if (entries[i].entry.valid && entries[i].asid == asid) {
+	    Evict(&entries[i]);
+	}
+    }
+}
@@ -9,6 +9,13 @@
 //	Either way, each entry is of the form:
 //	<virtual page #, physical page #>.
 //
+//	The TLB itself can be set up with any number of entries, and
+//	any associativity: the entries are divided into sets, and a
+//	virtual page can only be cached in the set its page # selects.
+//	Each entry is tagged with an address space id (ASID), so the
+//	entries of several address spaces can be in the TLB at once,
+//	and it needn't be flushed on a context switch.
+//
 // DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -42,4 +49,53 @@ class TranslationEntry {
 			// page is modified.
 };
 
+// How many address space ids the TLB can tell apart
+const int NumAsids = 64;
+
+// Which entry of a set to replace, when it is full
+enum TlbPolicy { TlbLRU, TlbFIFO, TlbRandom };
+
+// The following class defines an entry in the TLB: a translation,
+// tagged with the address space it belongs to.
+
+class TlbEntry {
+  public:
+    TranslationEntry entry;	// the translation; not in use if !valid
+    int asid;			// the address space it belongs to
+    TranslationEntry *pte;	// where it was loaded from, so the use
+				// and dirty bits can be written back
+    int stamp;			// when it was last used (LRU), or
+				// loaded (FIFO)
+};
+
+// The following class defines a software-loaded TLB.
+
+class Tlb {
+  public:
+    Tlb(int numEntries, int ways, TlbPolicy policy);
+				// Initialize an empty TLB, with "ways"
+				// entries in each set
+    ~Tlb();			// De-allocate it
+
+    TranslationEntry *Lookup(int vpn, int asid);
+				// Find the translation for a page, or
+				// NULL if it isn't cached
+    void Load(TranslationEntry *pte, int asid);
+				// Cache a page table entry, replacing
+				// another if need be
+    void Flush(int asid, bool exiting = FALSE);
+				// Throw out one address space's entries;
+				// "exiting" if the space is going away
+
+  private:
+    TlbEntry *entries;		// set "s" is entries[s * ways ...]
+    int numEntries;
+    int ways;			// entries in each set
+    int numSets;
+    TlbPolicy policy;
+    int clock;			// bumped on every use, for "stamp"
+
+    void Evict(TlbEntry *e);	// Write back an entry, and free it
+};
+
 #endif
@@ -0,0 +1,520 @@
+// diskmirror.cc
+//	Routines to mirror the sectors written to this machine's disk
+//	onto a replica disk on another Nachos machine.
+//
+//	On the primary, writers only ever add sectors to the batch being
+//	filled.  Full batches (or partial ones whose flush timer has gone
+//	off) are handed to a sender thread, so that a writer never waits
+//	for the network unless it asked for synchronous mirroring, or too
+//	many batches are already in flight.  A receiver thread collects
+//	acknowledgements and the replies to read and checksum requests.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "diskmirror.h"
+#include "synchdisk.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// SectorChecksum
+//	Compute a checksum of the contents of one sector.
+//----------------------------------------------------------------------
+
+unsigned int
+SectorChecksum(char *data)
+{
+    unsigned int sum = 0;
+
+    for (int i = 0; i < SectorSize; i++) {
+	sum = ((sum << 5) | (sum >> 27)) ^ (unsigned char)data[i];
+    }
+    return sum;
+}
+
+//----------------------------------------------------------------------
+// RegionChecksum
+//	Compute a checksum over a range of sectors of the local disk.
+//----------------------------------------------------------------------
+
+unsigned int
+RegionChecksum(int firstSector, int numSectors)
+{
+    char data[SectorSize];
+    unsigned int sum = 0;
+
+    for (int i = 0; i < numSectors; i++) {
+	kernel->synchDisk->ReadSector(firstSector + i, data);
+	sum = sum * 31 + SectorChecksum(data);
+    }
+    return sum;
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::DiskMirror
+//	Set up the primary's end of the mirror, and start the threads that
+//	send batches and receive acks.
+//
+//	"replica" -- machine to mirror onto; it must be serving us
+//	"synchronous" -- if TRUE, Write waits for the replica's ack
+//	"balanceReads" -- if TRUE, alternate reads between the disks
+//----------------------------------------------------------------------
+
+DiskMirror::DiskMirror(PostOfficeInput *postIn, PostOfficeOutput *postOut,
+		NetworkAddress replica, bool sync, bool balance)
+{
+    connection = new ReliableTransport(postIn, postOut, DiskMirrorBox,
+				replica, DiskMirrorBox, DefaultWindow);
+    synchronous = sync;
+    balanceReads = balance;
+
+    lock = new Lock("disk mirror lock");
+    batchAcked = new Condition("disk mirror batch acked");
+    replyArrived = new Condition("disk mirror reply arrived");
+    batchReady = new Semaphore("disk mirror batch ready", 0);
+    callLock = new Lock("disk mirror call lock");
+    outgoing = new List<char *>;
+
+    batchCount = 0;
+    nextSeq = ackedSeq = 0;
+    timerPending = flushDue = FALSE;
+    readToggle = FALSE;
+    reply = NULL;
+    replySize = 0;
+    replyReady = FALSE;
+
+    batchesSent = sectorsSent = remoteReads = sectorsResynced = 0;
+
+    Thread *t = new Thread("disk mirror sender", 1);
+    t->Fork(DiskMirror::SendWorker, this);
+    t = new Thread("disk mirror receiver", 1);
+    t->Fork(DiskMirror::ReceiveWorker, this);
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::~DiskMirror
+//	The worker threads wait forever, so we leave what they use alone.
+//----------------------------------------------------------------------
+
+DiskMirror::~DiskMirror()
+{
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::SendBatch
+//	Hand the batch being filled to the sender thread, and start a new
+//	one.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+DiskMirror::SendBatch()
+{
+    MirrorHeader *hdr = (MirrorHeader *)batch;
+    int length = sizeof(MirrorHeader) + batchCount * sizeof(MirrorRecord);
+    char *message = new char[length];
+
+    ASSERT(lock->IsHeldByCurrentThread() && batchCount > 0);
+    hdr->op = MirrorWrite;
+    hdr->seq = nextSeq++;
+    hdr->first = 0;
+    hdr->count = batchCount;
+    bcopy(batch, message, length);
+    outgoing->Append(message);
+
+    batchesSent++;
+    sectorsSent += batchCount;
+    batchCount = 0;
+    batchReady->V();
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::Write
+//	A sector has just been written to the local disk; add it to the
+//	current batch for the replica.  Waits if too many batches are
+//	already waiting to be acknowledged, and in synchronous mode, until
+//	this write has been acknowledged.
+//
+//	"sector" -- the sector written
+//	"data" -- its new contents
+//----------------------------------------------------------------------
+
+void
+DiskMirror::Write(int sector, char *data)
+{
+    MirrorRecord *record;
+    int seq;
+
+    lock->Acquire();
+    while (nextSeq - ackedSeq >= MirrorMaxBatches) {
+	batchAcked->Wait(lock);
+    }
+    record = (MirrorRecord *)(batch + sizeof(MirrorHeader)) + batchCount;
+    record->sector = sector;
+    bcopy(data, record->data, SectorSize);
+    batchCount++;
+    seq = nextSeq;
+    unacked[sector] = seq;
+
+    if (synchronous || batchCount == MirrorBatchSectors) {
+	SendBatch();
+    } else if (!timerPending) {		// make sure it goes out soon
+	timerPending = TRUE;
+	kernel->interrupt->Schedule(this, MirrorFlushDelay, NetworkTimerInt);
+    }
+    if (synchronous) {
+	while (ackedSeq <= seq) {
+	    batchAcked->Wait(lock);
+	}
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::CallBack
+//	Interrupt handler for the flush timer.  We can't take the lock
+//	here, so just tell the sender thread to send any partial batch.
+//----------------------------------------------------------------------
+
+void
+DiskMirror::CallBack()
+{
+    timerPending = FALSE;
+    flushDue = TRUE;
+    batchReady->V();
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::SendWorker
+//	Put batches on the wire, one at a time, as they become ready.
+//----------------------------------------------------------------------
+
+void
+DiskMirror::SendWorker(void *data)
+{
+    DiskMirror *_this = (DiskMirror *)data;
+    char *message;
+
+    for (;;) {
+	_this->batchReady->P();
+
+	_this->lock->Acquire();
+	if (_this->flushDue) {
+	    _this->flushDue = FALSE;
+	    if (_this->batchCount > 0) {
+		_this->SendBatch();
+	    }
+	}
+	message = NULL;
+	if (!_this->outgoing->IsEmpty()) {
+	    message = _this->outgoing->RemoveFront();
+	}
+	_this->lock->Release();
+
+	if (message != NULL) {
+	    MirrorHeader *hdr = (MirrorHeader *)message;
+
+	    DEBUG(dbgNet, "Mirroring batch " << hdr->seq << ", "
+				<< hdr->count << " sectors");
+	    _this->connection->Send(message, sizeof(MirrorHeader) +
+					hdr->count * sizeof(MirrorRecord));
+	    delete [] message;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::ReceiveWorker
+//	Handle messages from the replica: acks move "ackedSeq" forward
+//	(they are cumulative, since batches are written in order), and
+//	anything else is the reply to the outstanding request.
+//----------------------------------------------------------------------
+
+void
+DiskMirror::ReceiveWorker(void *data)
+{
+    DiskMirror *_this = (DiskMirror *)data;
+    char message[MaxMirrorMessage];
+    MirrorHeader *hdr = (MirrorHeader *)message;
+    map<int, int>::iterator it;
+    int length;
+
+    for (;;) {
+	length = _this->connection->Receive(message, MaxMirrorMessage);
+	ASSERT(length >= (int)sizeof(MirrorHeader));
+
+	_this->lock->Acquire();
+	if (hdr->op == MirrorAck) {
+	    _this->ackedSeq = max(_this->ackedSeq, hdr->seq + 1);
+	    for (it = _this->unacked.begin(); it != _this->unacked.end(); ) {
+		if (it->second <= hdr->seq) {
+		    _this->unacked.erase(it++);
+		} else {
+		    it++;
+		}
+	    }
+	    _this->batchAcked->Broadcast(_this->lock);
+	} else {
+	    ASSERT(_this->reply != NULL && !_this->replyReady);
+	    bcopy(message + sizeof(MirrorHeader), _this->reply,
+		min(length - (int)sizeof(MirrorHeader), _this->replySize));
+	    _this->replyReady = TRUE;
+	    _this->replyArrived->Signal(_this->lock);
+	}
+	_this->lock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::Call
+//	Send a request to the replica, and wait for the reply.
+//
+//	"request" -- the request; it has no body
+//	"replyData", "size" -- where to put the body of the reply
+//----------------------------------------------------------------------
+
+void
+DiskMirror::Call(MirrorHeader *request, char *replyData, int size)
+{
+    callLock->Acquire();		// one outstanding request at a time
+
+    lock->Acquire();
+    reply = replyData;
+    replySize = size;
+    replyReady = FALSE;
+    lock->Release();
+
+    connection->Send((char *)request, sizeof(MirrorHeader));
+
+    lock->Acquire();
+    while (!replyReady) {
+	replyArrived->Wait(lock);
+    }
+    reply = NULL;
+    lock->Release();
+
+    callLock->Release();
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::Read
+//	If we are balancing reads, every other read is sent to the
+//	replica -- unless the replica might not have the latest copy of
+//	the sector yet.
+//
+//	Returns TRUE if the replica supplied the data, FALSE if the
+//	caller should read the local disk.
+//----------------------------------------------------------------------
+
+bool
+DiskMirror::Read(int sector, char *data)
+{
+    MirrorHeader request;
+    bool remote;
+
+    if (!balanceReads) {
+	return FALSE;
+    }
+    lock->Acquire();
+    readToggle = !readToggle;
+    remote = readToggle && (unacked.find(sector) == unacked.end());
+    lock->Release();
+    if (!remote) {
+	return FALSE;
+    }
+
+    request.op = MirrorRead;
+    request.seq = 0;
+    request.first = sector;
+    request.count = 1;
+    Call(&request, data, SectorSize);
+    remoteReads++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::Flush
+//	Send any partial batch, and wait until the replica has
+//	acknowledged every write so far.
+//----------------------------------------------------------------------
+
+void
+DiskMirror::Flush()
+{
+    lock->Acquire();
+    if (batchCount > 0) {
+	SendBatch();
+    }
+    while (ackedSeq < nextSeq) {
+	batchAcked->Wait(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::Resync
+//	Make the replica's copy of the first "numSectors" sectors match
+//	ours.  Ask the replica for checksums of a group of regions at a
+//	time; for each region whose checksum doesn't match ours, ask for
+//	the checksum of each of its sectors, and resend the sectors that
+//	don't match.
+//----------------------------------------------------------------------
+
+void
+DiskMirror::Resync(int numSectors)
+{
+    MirrorHeader request;
+    unsigned int regionSums[MirrorRegionsPerRequest];
+    unsigned int sectorSums[MirrorRegionSectors];
+    char data[SectorSize];
+    int numRegions = divRoundUp(numSectors, MirrorRegionSectors);
+    int r, i, j, first, count;
+    bool balance = balanceReads;
+
+    ASSERT(numSectors > 0 && numSectors <= NumSectors);
+    balanceReads = FALSE;		// our checksums must be of our disk
+    request.seq = 0;
+
+    for (r = 0; r < numRegions; r += MirrorRegionsPerRequest) {
+	request.op = MirrorRegionSums;
+	request.first = r;
+	request.numSectors = numSectors;
+	request.count = min(MirrorRegionsPerRequest, numRegions - r);
+	Call(&request, (char *)regionSums, sizeof(regionSums));
+
+	for (i = 0; i < request.count; i++) {
+	    first = (r + i) * MirrorRegionSectors;
+	    count = min(MirrorRegionSectors, numSectors - first);
+	    if (RegionChecksum(first, count) == regionSums[i]) {
+		continue;
+	    }
+	    DEBUG(dbgNet, "Mirror region at sector " << first << " differs");
+
+	    MirrorHeader sectorRequest;
+	    sectorRequest.op = MirrorSectorSums;
+	    sectorRequest.seq = 0;
+	    sectorRequest.first = first;
+	    sectorRequest.count = count;
+	    Call(&sectorRequest, (char *)sectorSums, sizeof(sectorSums));
+
+	    for (j = 0; j < count; j++) {
+		kernel->synchDisk->ReadSector(first + j, data);
+		if (SectorChecksum(data) != sectorSums[j]) {
+		    Write(first + j, data);
+		    sectorsResynced++;
+		}
+	    }
+	}
+    }
+    Flush();
+    balanceReads = balance;
+}
+
+//----------------------------------------------------------------------
+// DiskMirror::Print
+//	Print the mirroring statistics.
+//----------------------------------------------------------------------
+
+void
+DiskMirror::Print()
+{
+    cout << "Disk mirror: " << batchesSent << " batches, " << sectorsSent
+	<< " sectors sent, " << remoteReads << " reads from replica, "
+	<< sectorsResynced << " sectors resynced\n";
+}
+
+//----------------------------------------------------------------------
+// DiskMirrorServer::DiskMirrorServer
+//	Serve as the replica for the disk of machine "primary".
+//----------------------------------------------------------------------
+
+DiskMirrorServer::DiskMirrorServer(PostOfficeInput *postIn,
+			PostOfficeOutput *postOut, NetworkAddress primary)
+{
+    connection = new ReliableTransport(postIn, postOut, DiskMirrorBox,
+				primary, DiskMirrorBox, DefaultWindow);
+
+    Thread *t = new Thread("disk mirror server", 1);
+    t->Fork(DiskMirrorServer::Serve, this);
+}
+
+//----------------------------------------------------------------------
+// DiskMirrorServer::~DiskMirrorServer
+//	The server thread waits forever, so its connection is left alone.
+//----------------------------------------------------------------------
+
+DiskMirrorServer::~DiskMirrorServer()
+{
+}
+
+//----------------------------------------------------------------------
+// DiskMirrorServer::Serve
+//	Carry out the primary's requests against the local disk.
+//----------------------------------------------------------------------
+
+void
+DiskMirrorServer::Serve(void *data)
+{
+    DiskMirrorServer *_this = (DiskMirrorServer *)data;
+    char message[MaxMirrorMessage];
+    char replyMessage[sizeof(MirrorHeader) +
+		MirrorRegionSectors * sizeof(unsigned int) + SectorSize];
+    MirrorHeader *hdr = (MirrorHeader *)message;
+    MirrorHeader *replyHdr = (MirrorHeader *)replyMessage;
+    char *body = replyMessage + sizeof(MirrorHeader);
+    unsigned int *sums = (unsigned int *)body;
+    MirrorRecord *record;
+    char sector[SectorSize];		// not "message": hdr points into it
+    int i, length;
+
+    for (;;) {
+	length = _this->connection->Receive(message, MaxMirrorMessage);
+	ASSERT(length >= (int)sizeof(MirrorHeader));
+
+	*replyHdr = *hdr;
+	length = sizeof(MirrorHeader);
+	switch (hdr->op) {
+	  case MirrorWrite:
+	    record = (MirrorRecord *)(message + sizeof(MirrorHeader));
+	    for (i = 0; i < hdr->count; i++, record++) {
+		kernel->synchDisk->WriteSector(record->sector, record->data);
+	    }
+	    replyHdr->op = MirrorAck;
+	    break;
+
+	  case MirrorRead:
+	    kernel->synchDisk->ReadSector(hdr->first, body);
+	    replyHdr->op = MirrorReadReply;
+	    length += SectorSize;
+	    break;
+
+	  case MirrorRegionSums:
+	    ASSERT(hdr->count <= MirrorRegionsPerRequest);
+	    ASSERT(hdr->numSectors > 0 && hdr->numSectors <= NumSectors);
+	    for (i = 0; i < hdr->count; i++) {
+		int first = (hdr->first + i) * MirrorRegionSectors;
+
+		sums[i] = RegionChecksum(first,
+			min(MirrorRegionSectors, hdr->numSectors - first));
+	    }
+	    replyHdr->op = MirrorSumsReply;
+	    length += hdr->count * sizeof(unsigned int);
+	    break;
+
+	  case MirrorSectorSums:
+	    ASSERT(hdr->count <= MirrorRegionSectors);
+	    for (i = 0; i < hdr->count; i++) {
+		kernel->synchDisk->ReadSector(hdr->first + i, sector);
+		sums[i] = SectorChecksum(sector);
+	    }
+	    replyHdr->op = MirrorSumsReply;
+	    length += hdr->count * sizeof(unsigned int);
+	    break;
+
+	  default:
+	    ASSERTNOTREACHED();
+	}
+	_this->connection->Send(replyMessage, length);
+    }
+}
@@ -0,0 +1,166 @@
+// diskmirror.h
+//	Data structures for mirroring one machine's disk onto another
+//	Nachos machine, sector by sector, over the network.
+//
+//	The primary's synchronous disk hands every sector it writes to a
+//	DiskMirror, which gathers them into batches and sends each batch
+//	to the replica when it fills up, or shortly after its first write
+//	if it doesn't.  The replica (a DiskMirrorServer) writes the batch
+//	to its own disk and acknowledges it.
+//
+//	In asynchronous mode, a write returns as soon as the local disk
+//	has it.  In synchronous mode, it also waits until the replica has
+//	acknowledged it.  Either way, a sector with an unacknowledged
+//	write is always read locally; other reads can optionally alternate
+//	between the two disks.
+//
+//	Resync brings a replica that missed writes (e.g., because it was
+//	down) up to date: we compare checksums of regions of the disk,
+//	then of the sectors within each region that differs, and send
+//	only the sectors that differ.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DISKMIRROR_H
+#define DISKMIRROR_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "callback.h"
+#include "disk.h"
+#include "synch.h"
+#include "list.h"
+#include "transport.h"
+#include <map>
+
+#define DiskMirrorBox		16	// mailbox used on both ends
+#define MirrorBatchSectors	8	// sectors sent in one batch
+#define MirrorFlushDelay	(10 * NetworkTime)
+					// longest a write waits for its
+					// batch to fill up
+#define MirrorMaxBatches	4	// batches in flight before writers wait
+#define MirrorRegionSectors	64	// sectors per checksum region
+#define MirrorRegionsPerRequest	32	// region checksums per request
+
+// The messages sent between primary and replica.  Each starts with
+// a MirrorHeader; what follows depends on the operation.
+enum MirrorOp {
+    MirrorWrite,		// primary: "count" MirrorRecords
+    MirrorAck,			// replica: batch "seq" is on disk
+    MirrorRead,			// primary: send me sector "first"
+    MirrorReadReply,		// replica: SectorSize bytes of data
+    MirrorRegionSums,		// primary: checksums of "count" regions
+				//   starting at region "first", of a
+				//   disk "numSectors" long
+    MirrorSectorSums,		// primary: checksums of "count" sectors
+				//   starting at sector "first"
+    MirrorSumsReply		// replica: "count" checksums
+};
+
+class MirrorHeader {
+  public:
+    int op;			// A MirrorOp
+    int seq;			// Batch number, for writes and acks
+    int first;			// First sector or region
+    int count;			// How many records, sectors or regions
+    int numSectors;		// Sectors being resynced, so both ends
+				//   see the same last region
+};
+
+// One sector's worth of a write batch
+
+class MirrorRecord {
+  public:
+    int sector;
+    char data[SectorSize];
+};
+
+#define MaxMirrorMessage	(sizeof(MirrorHeader) + \
+				MirrorBatchSectors * sizeof(MirrorRecord))
+
+// The following class defines the primary's end of the mirror.
+
+class DiskMirror : public CallBackObj {
+  public:
+    DiskMirror(PostOfficeInput *postIn, PostOfficeOutput *postOut,
+		NetworkAddress replica, bool synchronous, bool balanceReads);
+    ~DiskMirror();
+
+    void Write(int sector, char *data);
+				// Called after "sector" has been written
+				// locally; queue it for the replica
+    bool Read(int sector, char *data);
+				// If it's the replica's turn, and the
+				// replica has the latest "sector", read
+				// it from there and return TRUE
+    void Flush();		// Wait until everything is acknowledged
+    void Resync(int numSectors);
+				// Bring the replica up to date for the
+				// first "numSectors" sectors
+
+    void CallBack();		// The flush timer has gone off
+
+    void Print();		// Print mirroring statistics
+
+    int batchesSent;		// Write batches sent to the replica
+    int sectorsSent;		// Sectors in those batches
+    int remoteReads;		// Reads served by the replica
+    int sectorsResynced;	// Sectors found to differ by Resync
+
+  private:
+    static void SendWorker(void *data);
+				// Send batches as they become ready
+    static void ReceiveWorker(void *data);
+				// Handle acks and replies
+    void Call(MirrorHeader *request, char *reply, int replySize);
+				// Send a request and wait for its reply
+    void SendBatch();		// Send the current batch (lock held)
+
+    ReliableTransport *connection;
+    bool synchronous;		// Wait for acks before returning?
+    bool balanceReads;		// Send every other read to the replica?
+
+    Lock *lock;			// Protects everything below
+    Condition *batchAcked;	// Signalled when an ack arrives
+    Condition *replyArrived;	// Signalled when a reply arrives
+    Semaphore *batchReady;	// V'ed when a batch should be sent
+    Lock *callLock;		// One request/reply at a time
+    List<char *> *outgoing;	// Batches waiting for the sender thread
+
+    char batch[MaxMirrorMessage];
+				// The batch being filled
+    int batchCount;		// Sectors in it
+    int nextSeq;		// Sequence number of that batch
+    int ackedSeq;		// All batches before this are on the replica
+    map<int, int> unacked;	// Sector -> last batch that wrote it
+    bool timerPending;		// Is the flush timer running?
+    bool flushDue;		// Has it gone off since the last send?
+    bool readToggle;		// Whose turn it is to serve a read
+    char *reply;		// Where to put the reply to a request
+    int replySize;
+    bool replyReady;
+};
+
+// The following class defines the replica's end of the mirror.
+// It writes what it is sent straight to the local disk.
+
+class DiskMirrorServer {
+  public:
+    DiskMirrorServer(PostOfficeInput *postIn, PostOfficeOutput *postOut,
+			NetworkAddress primary);
+    ~DiskMirrorServer();
+
+  private:
+    static void Serve(void *data);
+				// Body of the server thread
+
+    ReliableTransport *connection;
+};
+
+// Checksums used to find sectors that differ
+extern unsigned int SectorChecksum(char *data);
+extern unsigned int RegionChecksum(int firstSector, int numSectors);
+
+#endif // DISKMIRROR_H
@@ -0,0 +1,871 @@
+// fileservice.cc
+//	Routines to export a file system to other Nachos machines, and
+//	to use a file system exported by another machine.
+//
+//	Requests and replies travel over a reliable transport connection
+//	between the client and the server, one connection per client.
+//	Because the transport delivers in order, replies come back in
+//	the order the requests were sent, which is what lets the client
+//	have several reads outstanding at once.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "fileservice.h"
+#include "main.h"
+#include <vector>
+
+// What a server thread needs to know about its client
+class FileServerClient {
+  public:
+    FileServer *server;
+    NetworkAddress host;
+    ReliableTransport *connection;
+    set<int> openFiles;		// Server fd's this client opened, the
+				// only ones it may use
+    map<int, int> leases;	// When its leases run out, by header
+				// sector
+};
+
+//----------------------------------------------------------------------
+// FileServer::FileServer
+//	Initialize a file server; it does nothing until a client is added.
+//----------------------------------------------------------------------
+
+FileServer::FileServer(PostOfficeInput *postIn, PostOfficeOutput *postOut)
+{
+    postOfficeIn = postIn;
+    postOfficeOut = postOut;
+    lock = new Lock("file server lock");
+    for (int i = 0; i < MaxFileServiceHosts; i++) {
+	clients[i] = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// FileServer::~FileServer
+//	The server threads wait forever for requests, so we leave them
+//	(and their connections) alone.
+//----------------------------------------------------------------------
+
+FileServer::~FileServer()
+{
+}
+
+//----------------------------------------------------------------------
+// FileServer::AddClient
+//	Accept requests from the file service on machine "client".
+//----------------------------------------------------------------------
+
+void
+FileServer::AddClient(NetworkAddress client)
+{
+    FileServerClient *c = new FileServerClient;
+
+    ASSERT(client >= 0 && client < MaxFileServiceHosts);
+    ASSERT(clients[client] == NULL);
+    clients[client] = c;
+    c->server = this;
+    c->host = client;
+    c->connection = new ReliableTransport(postOfficeIn, postOfficeOut,
+		FileServerBox(client), client, FileServiceBox, DefaultWindow);
+
+    Thread *t = new Thread("file server", 1);
+    t->Fork(FileServer::Serve, c);
+}
+
+//----------------------------------------------------------------------
+// FileServer::Serve
+//	Body of a server thread: wait for a request from our client,
+//	carry it out, and send back the reply.  When the client says it is
+//	going away, close whatever it left open.
+//----------------------------------------------------------------------
+
+void
+FileServer::Serve(void *data)
+{
+    FileServerClient *c = (FileServerClient *)data;
+    char request[MaxFileServiceMessage];
+    char reply[sizeof(FileServiceReply) + FileServiceBlockSize];
+    FileServiceRequest *req = (FileServiceRequest *)request;
+    FileServiceReply *rep = (FileServiceReply *)reply;
+    int length;
+
+    for (;;) {
+	length = c->connection->Receive(request, MaxFileServiceMessage);
+	ASSERT(length >= (int)sizeof(FileServiceRequest));
+	ASSERT(req->length == length - (int)sizeof(FileServiceRequest));
+
+	c->server->lock->Acquire();
+	if (req->op == FsDisconnect) {
+	    c->server->Disconnect(c);
+	    c->server->lock->Release();
+	    continue;
+	}
+	c->server->HandleRequest(c, req, request + sizeof(FileServiceRequest),
+				rep, reply + sizeof(FileServiceReply));
+	c->server->lock->Release();
+
+	c->connection->Send(reply, sizeof(FileServiceReply) + rep->length);
+    }
+}
+
+//----------------------------------------------------------------------
+// FileServer::Version
+//	Return the version of an open file, or -1 if "fd" isn't open.
+//	Versions are kept by header sector, so that every client that
+//	has the same file open sees the same version.
+//----------------------------------------------------------------------
+
+int
+FileServer::Version(int fd)
+{
+    OpenFile *openFile = kernel->fileSystem->GetOpenFileTable(fd);
+
+    if (openFile == NULL) {
+	return -1;
+    }
+    return versions[openFile->HeaderSector()];
+}
+
+//----------------------------------------------------------------------
+// FileServer::BumpVersion
+//	Note that an open file has been written, and return its new version.
+//----------------------------------------------------------------------
+
+int
+FileServer::BumpVersion(int fd)
+{
+    OpenFile *openFile = kernel->fileSystem->GetOpenFileTable(fd);
+
+    ASSERT(openFile != NULL);
+    return ++versions[openFile->HeaderSector()];
+}
+
+//----------------------------------------------------------------------
+// FileServer::GrantLease
+//	Give a client a lease on an open file, and note when it runs out.
+//	If a write to the file is being held back, the lease is for zero
+//	ticks, so the client will ask again before using its cache.
+//
+//	Returns the length of the lease.
+//----------------------------------------------------------------------
+
+int
+FileServer::GrantLease(FileServerClient *client, int fd)
+{
+    OpenFile *openFile = kernel->fileSystem->GetOpenFileTable(fd);
+    int sector, lease, expires;
+
+    ASSERT(openFile != NULL);
+    sector = openFile->HeaderSector();
+    lease = (writersWaiting[sector] > 0) ? 0 : LeaseTime;
+    expires = kernel->stats->totalTicks + lease;
+    if (client->leases.find(sector) == client->leases.end() ||
+				client->leases[sector] < expires) {
+	client->leases[sector] = expires;
+    }
+    return lease;
+}
+
+//----------------------------------------------------------------------
+// FileServer::WaitForLeases
+//	Hold back a write by "client" to an open file until every other
+//	client's lease on the file has run out.  Called, and returns,
+//	with the server lock held; the lock is let go while we wait.
+//----------------------------------------------------------------------
+
+void
+FileServer::WaitForLeases(FileServerClient *client, int fd)
+{
+    OpenFile *openFile = kernel->fileSystem->GetOpenFileTable(fd);
+    map<int, int>::iterator it;
+    int sector, latest, now;
+
+    ASSERT(openFile != NULL);
+    sector = openFile->HeaderSector();
+    writersWaiting[sector]++;
+    for (;;) {
+	now = kernel->stats->totalTicks;
+	latest = now;
+	for (int i = 0; i < MaxFileServiceHosts; i++) {
+	    if (clients[i] == NULL || clients[i] == client) {
+		continue;
+	    }
+	    it = clients[i]->leases.find(sector);
+	    if (it != clients[i]->leases.end() && it->second > latest) {
+		latest = it->second;
+	    }
+	}
+	if (latest == now) {
+	    break;
+	}
+	DEBUG(dbgNet, "File server holding back write to fd " << fd
+			<< " for " << latest - now << " ticks");
+	lock->Release();
+	kernel->alarm->WaitUntil(latest - now);
+	lock->Acquire();
+    }
+    writersWaiting[sector]--;
+}
+
+//----------------------------------------------------------------------
+// FileServer::Disconnect
+//	A client has gone away; close every file it had open, and forget
+//	its leases.
+//----------------------------------------------------------------------
+
+void
+FileServer::Disconnect(FileServerClient *client)
+{
+    set<int>::iterator it;
+
+    DEBUG(dbgNet, "File server closing files of client " << client->host);
+    client->leases.clear();
+    for (it = client->openFiles.begin(); it != client->openFiles.end(); it++) {
+	kernel->fileSystem->Close(*it);
+    }
+    client->openFiles.clear();
+}
+
+//----------------------------------------------------------------------
+// FileServer::HandleRequest
+//	Carry out one request on the local file system, and fill in the
+//	reply.  A client may only use the file descriptors it got back
+//	from its own FsOpen requests; anything else fails as if the file
+//	weren't open.
+//
+//	"client" -- who sent the request
+//	"request", "payload" -- the request and the bytes following it
+//	"reply", "replyData" -- where to put the reply and any file data
+//----------------------------------------------------------------------
+
+void
+FileServer::HandleRequest(FileServerClient *client,
+			FileServiceRequest *request, char *payload,
+			FileServiceReply *reply, char *replyData)
+{
+    FileSystem *fileSystem = kernel->fileSystem;
+    OpenFile *openFile;
+
+    reply->tag = request->tag;
+    reply->result = -1;
+    reply->length = 0;
+    reply->lease = 0;
+
+    if (request->op != FsCreate && request->op != FsOpen &&
+		request->op != FsRemove &&
+		client->openFiles.find(request->fd) == client->openFiles.end()) {
+	DEBUG(dbgNet, "File server: client " << client->host
+			<< " doesn't have fd " << request->fd << " open");
+	reply->version = reply->priorVersion = -1;
+	return;
+    }
+
+    switch (request->op) {
+      case FsCreate:
+      case FsOpen:
+      case FsRemove:
+	ASSERT(request->length > 0 && request->length <= MaxFileServicePath);
+	payload[request->length - 1] = '\0';
+	DEBUG(dbgNet, "File server op " << request->op << " on " << payload);
+	if (request->op == FsCreate) {
+	    reply->result = fileSystem->Create(payload, request->size);
+	} else if (request->op == FsRemove) {
+	    reply->result = fileSystem->Remove(payload);
+	} else if ((openFile = fileSystem->Open(payload)) != NULL) {
+	    reply->result = openFile->GetFd();
+	    fileSystem->SetOpenFileTable(reply->result, openFile);
+	    client->openFiles.insert(reply->result);
+	}
+	reply->version = reply->priorVersion = 0;
+	if (request->op == FsOpen && reply->result >= 0) {
+	    reply->version = reply->priorVersion = Version(reply->result);
+	}
+	break;
+
+      case FsClose:
+	reply->version = reply->priorVersion = Version(request->fd);
+	if (reply->version >= 0) {
+	    openFile = fileSystem->GetOpenFileTable(request->fd);
+	    client->leases.erase(openFile->HeaderSector());
+	    reply->result = fileSystem->Close(request->fd);
+	}
+	client->openFiles.erase(request->fd);
+	return;				// no lease on a closed file
+
+      case FsValidate:
+	reply->version = reply->priorVersion = Version(request->fd);
+	reply->result = reply->version;
+	break;
+
+      case FsReadAt:
+	ASSERT(request->size <= FileServiceBlockSize);
+	reply->version = reply->priorVersion = Version(request->fd);
+	if (reply->version >= 0) {
+	    openFile = fileSystem->GetOpenFileTable(request->fd);
+	    reply->result = openFile->ReadAt(replyData, request->size,
+						request->offset);
+	    reply->length = max(reply->result, 0);
+	}
+	break;
+
+      case FsWriteAt:
+	ASSERT(request->length <= FileServiceBlockSize);
+	if (Version(request->fd) >= 0) {
+	    WaitForLeases(client, request->fd);
+	}
+	reply->version = reply->priorVersion = Version(request->fd);
+	if (reply->version >= 0) {
+	    openFile = fileSystem->GetOpenFileTable(request->fd);
+	    reply->result = openFile->WriteAt(payload, request->length,
+						request->offset);
+	    reply->version = BumpVersion(request->fd);
+	}
+	break;
+
+      default:
+	ASSERTNOTREACHED();
+    }
+
+    // everything that names an open file renews the client's lease on it
+    if (request->op == FsOpen && reply->result >= 0) {
+	reply->lease = GrantLease(client, reply->result);
+    } else if (request->op != FsCreate && request->op != FsRemove &&
+						reply->version >= 0) {
+	reply->lease = GrantLease(client, request->fd);
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::RemoteFileSystem
+//	Connect to the file server on machine "server".  The server must
+//	have been told to accept requests from this machine.
+//----------------------------------------------------------------------
+
+RemoteFileSystem::RemoteFileSystem(PostOfficeInput *postIn,
+			PostOfficeOutput *postOut, NetworkAddress server)
+{
+    ASSERT(kernel->hostName >= 0 && kernel->hostName < MaxFileServiceHosts);
+    connection = new ReliableTransport(postIn, postOut, FileServiceBox,
+		server, FileServerBox(kernel->hostName), DefaultWindow);
+    lock = new Lock("remote file system lock");
+    nextTag = 0;
+    for (int i = 0; i < FileServiceCacheBlocks; i++) {
+	cache[i].valid = FALSE;
+    }
+    requestsSent = cacheHits = cacheMisses = invalidations = 0;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::~RemoteFileSystem
+//	Tell the server to close everything we still have open.  We
+//	don't wait for it (the server may already be gone), so this is
+//	only as good as the network.
+//
+//	The connection's worker threads run forever, so it is left alone.
+//----------------------------------------------------------------------
+
+RemoteFileSystem::~RemoteFileSystem()
+{
+    FileServiceRequest request;
+
+    request.op = FsDisconnect;
+    request.fd = -1;
+    request.length = 0;
+    SendRequest(&request, NULL);
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::SendRequest
+//	Send a request to the server, without waiting for the reply.
+//
+//	"request" -- the request header; its length field says how much
+//		of "payload" to send along
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::SendRequest(FileServiceRequest *request, char *payload)
+{
+    char buffer[MaxFileServiceMessage];
+
+    ASSERT(request->length >= 0 &&
+	request->length <= (int)(MaxFileServiceMessage - sizeof(FileServiceRequest)));
+    request->tag = nextTag++;
+    bcopy((char *)request, buffer, sizeof(FileServiceRequest));
+    bcopy(payload, buffer + sizeof(FileServiceRequest), request->length);
+    connection->Send(buffer, sizeof(FileServiceRequest) + request->length);
+    requestsSent++;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::GetReply
+//	Wait for the next reply from the server.
+//
+//	"reply" -- where to put the reply header
+//	"data" -- where to put any file data (may be NULL if none expected)
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::GetReply(FileServiceReply *reply, char *data)
+{
+    char buffer[sizeof(FileServiceReply) + FileServiceBlockSize];
+    int length;
+
+    length = connection->Receive(buffer, sizeof(buffer));
+    ASSERT(length >= (int)sizeof(FileServiceReply));
+    bcopy(buffer, (char *)reply, sizeof(FileServiceReply));
+    ASSERT(reply->length == length - (int)sizeof(FileServiceReply));
+    if (reply->length > 0) {
+	ASSERT(data != NULL);
+	bcopy(buffer + sizeof(FileServiceReply), data, reply->length);
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Call
+//	Send a request, and wait for its reply.  Returns the result.
+//----------------------------------------------------------------------
+
+int
+RemoteFileSystem::Call(FileServiceRequest *request, char *payload)
+{
+    FileServiceReply reply;
+    int tag = nextTag;
+    int sent = kernel->stats->totalTicks;	// the lease runs from here
+
+    SendRequest(request, payload);
+    GetReply(&reply, NULL);
+    ASSERT(reply.tag == tag);
+    if (request->fd >= 0 && leases.find(request->fd) != leases.end()) {
+	NoteVersion(request->fd, &reply, sent);
+    }
+    return reply.result;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::NoteVersion
+//	A reply about an open file has come back.  If the file was
+//	changed by someone else since our blocks were fetched, forget
+//	them.  Either way, we now hold the lease the server granted.
+//
+//	"reply" -- the reply; its version and priorVersion are the file's
+//		version after and before the request was carried out
+//		(they differ only for our own writes)
+//	"sent" -- when we sent the request; the lease runs from then
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::NoteVersion(int fd, FileServiceReply *reply, int sent)
+{
+    FileServiceLease *lease = &leases[fd];
+    int version = reply->version, priorVersion = reply->priorVersion;
+
+    if (priorVersion != lease->version) {
+	DEBUG(dbgNet, "Remote file " << fd << " changed, version "
+			<< lease->version << " -> " << priorVersion);
+	Invalidate(fd);
+	invalidations++;
+    }
+    lease->version = version;
+    lease->expires = sent + reply->lease;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::FindBlock
+//	Look for a block of an open file in the cache.  Returns NULL if
+//	it isn't there.
+//----------------------------------------------------------------------
+
+FileServiceBlock *
+RemoteFileSystem::FindBlock(int fd, int blockNum)
+{
+    for (int i = 0; i < FileServiceCacheBlocks; i++) {
+	if (cache[i].valid && cache[i].fd == fd &&
+				cache[i].blockNum == blockNum) {
+	    cache[i].lastUsed = kernel->stats->totalTicks;
+	    return &cache[i];
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::AllocBlock
+//	Find room in the cache for a block, throwing out the least
+//	recently used block if necessary.
+//----------------------------------------------------------------------
+
+FileServiceBlock *
+RemoteFileSystem::AllocBlock(int fd, int blockNum)
+{
+    FileServiceBlock *victim = FindBlock(fd, blockNum);
+
+    for (int i = 0; victim == NULL && i < FileServiceCacheBlocks; i++) {
+	if (!cache[i].valid) {
+	    victim = &cache[i];
+	}
+    }
+    for (int i = 0; victim == NULL && i < FileServiceCacheBlocks; i++) {
+	if (i == 0 || cache[i].lastUsed < victim->lastUsed) {
+	    victim = &cache[i];
+	}
+    }
+    victim->valid = TRUE;
+    victim->fd = fd;
+    victim->blockNum = blockNum;
+    victim->length = 0;
+    victim->lastUsed = kernel->stats->totalTicks;
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Invalidate
+//	Forget every cached block of an open file.
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::Invalidate(int fd)
+{
+    for (int i = 0; i < FileServiceCacheBlocks; i++) {
+	if (cache[i].valid && cache[i].fd == fd) {
+	    cache[i].valid = FALSE;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Create
+// RemoteFileSystem::Remove
+//	Create or remove a file on the server.
+//----------------------------------------------------------------------
+
+bool
+RemoteFileSystem::Create(char *name, int initialSize)
+{
+    FileServiceRequest request;
+    int result;
+
+    request.op = FsCreate;
+    request.fd = -1;
+    request.size = initialSize;
+    request.length = strlen(name) + 1;
+
+    lock->Acquire();
+    result = Call(&request, name);
+    lock->Release();
+    return (result > 0);
+}
+
+bool
+RemoteFileSystem::Remove(char *name)
+{
+    FileServiceRequest request;
+    int result;
+
+    request.op = FsRemove;
+    request.fd = -1;
+    request.length = strlen(name) + 1;
+
+    lock->Acquire();
+    result = Call(&request, name);
+    lock->Release();
+    return (result > 0);
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Open
+//	Open a file on the server.  The file descriptor is the server's.
+//----------------------------------------------------------------------
+
+int
+RemoteFileSystem::Open(char *name)
+{
+    FileServiceRequest request;
+    FileServiceReply reply;
+    int tag, sent;
+
+    request.op = FsOpen;
+    request.fd = -1;
+    request.length = strlen(name) + 1;
+
+    lock->Acquire();
+    tag = nextTag;
+    sent = kernel->stats->totalTicks;
+    SendRequest(&request, name);
+    GetReply(&reply, NULL);
+    ASSERT(reply.tag == tag);
+    if (reply.result >= 0) {
+	FileServiceLease *lease = &leases[reply.result];
+
+	Invalidate(reply.result);	// left over from an earlier open
+	lease->version = reply.version;
+	lease->expires = sent + reply.lease;
+	lease->position = 0;
+    }
+    lock->Release();
+    return reply.result;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Close
+//	Close a file on the server, and forget what we had cached.
+//----------------------------------------------------------------------
+
+int
+RemoteFileSystem::Close(int fd)
+{
+    FileServiceRequest request;
+    int result;
+
+    request.op = FsClose;
+    request.fd = fd;
+    request.length = 0;
+
+    lock->Acquire();
+    if (leases.find(fd) == leases.end()) {
+	lock->Release();
+	return -1;
+    }
+    Invalidate(fd);
+    leases.erase(fd);
+    result = Call(&request, NULL);
+    lock->Release();
+    return result;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Seek
+//	Set the position for the next Read or Write.  Positions are kept
+//	by the client, since every request to the server says where.
+//----------------------------------------------------------------------
+
+int
+RemoteFileSystem::Seek(int position, int fd)
+{
+    lock->Acquire();
+    if (leases.find(fd) == leases.end() || position < 0) {
+	lock->Release();
+	return -1;
+    }
+    leases[fd].position = position;
+    lock->Release();
+    return 1;
+}
+
+// The state of a block that RemoteFileSystem::Read doesn't hold yet
+
+enum { NotHeld = -1, Requested = -2 };
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Read
+//	Read from an open file, at the current position.
+//
+//	If our lease has run out, first check with the server that the
+//	cached blocks are still good.  Then gather the blocks we have,
+//	and send requests for all of the blocks we are missing before
+//	collecting any of the replies (which come back in order).
+//
+//	A reply may show that the file has changed since the blocks we
+//	gathered were fetched.  Those blocks are then stale, so we go
+//	round again for them; nothing is copied into "buf" until every
+//	block we hold is known to be current.
+//
+//	Returns the number of bytes read (less than "size" at end of file),
+//	or -1 if "fd" isn't open.
+//----------------------------------------------------------------------
+
+int
+RemoteFileSystem::Read(char *buf, int size, int fd)
+{
+    FileServiceRequest request;
+    FileServiceReply reply;
+    FileServiceBlock *block;
+    vector<char> data;			// the blocks, as we gather them
+    vector<int> length;			// bytes of each block we have, or
+					// NotHeld or Requested
+    vector<int> got;			// bytes copied out of each block
+    int position, first, last, b, from, to, numRead, sent, i, before;
+    bool stale;
+
+    lock->Acquire();
+    if (leases.find(fd) == leases.end()) {
+	lock->Release();
+	return -1;
+    }
+    if (size <= 0) {
+	lock->Release();
+	return 0;
+    }
+    if (kernel->stats->totalTicks >= leases[fd].expires) {
+	request.op = FsValidate;
+	request.fd = fd;
+	request.length = 0;
+	Call(&request, NULL);
+    }
+
+    position = leases[fd].position;
+    first = position / FileServiceBlockSize;
+    last = (position + size - 1) / FileServiceBlockSize;
+    data.resize((last - first + 1) * FileServiceBlockSize);
+    length.resize(last - first + 1, NotHeld);
+    got.resize(last - first + 1, 0);
+
+    do {
+	// gather what we have, and ask for the rest all at once
+	sent = kernel->stats->totalTicks;
+	request.op = FsReadAt;
+	request.fd = fd;
+	request.size = FileServiceBlockSize;
+	request.length = 0;
+	for (b = first; b <= last; b++) {
+	    if (length[b - first] != NotHeld) {
+		continue;
+	    }
+	    block = FindBlock(fd, b);
+	    if (block == NULL) {
+		request.offset = b * FileServiceBlockSize;
+		SendRequest(&request, NULL);
+		length[b - first] = Requested;
+		continue;
+	    }
+	    cacheHits++;
+	    length[b - first] = block->length;
+	    bcopy(block->data, &data[(b - first) * FileServiceBlockSize],
+							block->length);
+	}
+
+	// collect the missing blocks, in the order we asked for them;
+	// if the file has changed, whatever we held before is stale
+	stale = FALSE;
+	for (b = first; b <= last; b++) {
+	    if (length[b - first] != Requested) {
+		continue;
+	    }
+	    GetReply(&reply, &data[(b - first) * FileServiceBlockSize]);
+	    cacheMisses++;
+	    before = invalidations;
+	    NoteVersion(fd, &reply, sent);
+	    if (invalidations != before) {
+		for (i = 0; i <= last - first; i++) {
+		    if (length[i] >= 0) {
+			length[i] = NotHeld;	// fetch it again
+			stale = TRUE;
+		    }
+		}
+	    }
+	    length[b - first] = reply.length;
+	    block = AllocBlock(fd, b);
+	    block->length = reply.length;
+	    bcopy(&data[(b - first) * FileServiceBlockSize], block->data,
+							reply.length);
+	}
+    } while (stale);
+
+    // now copy out the part of each block that was asked for
+    for (b = first; b <= last; b++) {
+	from = max(position, b * FileServiceBlockSize) - b * FileServiceBlockSize;
+	to = min(position + size, (b + 1) * FileServiceBlockSize)
+					- b * FileServiceBlockSize;
+	to = min(to, length[b - first]);
+	got[b - first] = max(to - from, 0);
+	if (to > from) {
+	    bcopy(&data[(b - first) * FileServiceBlockSize + from],
+		buf + b * FileServiceBlockSize + from - position, to - from);
+	}
+    }
+
+    // the read stops at the first block that ends short of what we wanted
+    numRead = 0;
+    for (i = 0; i < (int)got.size(); i++) {
+	numRead += got[i];
+	b = first + i;
+	to = min(position + size, (b + 1) * FileServiceBlockSize);
+	if (position + numRead < to) {
+	    break;
+	}
+    }
+    leases[fd].position += numRead;
+    lock->Release();
+    return numRead;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Write
+//	Write to an open file, at the current position.  Each block's
+//	worth is sent to the server as a separate request; all of the
+//	requests go out before we wait for the replies.  Blocks we have
+//	cached are updated in place.
+//
+//	Returns the number of bytes written, or -1 if "fd" isn't open.
+//----------------------------------------------------------------------
+
+int
+RemoteFileSystem::Write(char *buf, int size, int fd)
+{
+    FileServiceRequest request;
+    FileServiceReply reply;
+    FileServiceBlock *block;
+    int position, offset, chunk, numRequests, numWritten, sent, b;
+
+    lock->Acquire();
+    if (leases.find(fd) == leases.end()) {
+	lock->Release();
+	return -1;
+    }
+    position = leases[fd].position;
+
+    // pipeline the writes, one per block touched
+    sent = kernel->stats->totalTicks;
+    request.op = FsWriteAt;
+    request.fd = fd;
+    numRequests = 0;
+    for (offset = 0; offset < size; offset += chunk) {
+	chunk = min(size - offset, FileServiceBlockSize -
+			(position + offset) % FileServiceBlockSize);
+	request.offset = position + offset;
+	request.length = chunk;
+	SendRequest(&request, buf + offset);
+	numRequests++;
+    }
+
+    // collect the replies, and keep the cache up to date
+    numWritten = 0;
+    for (offset = 0; numRequests > 0; numRequests--, offset += chunk) {
+	chunk = min(size - offset, FileServiceBlockSize -
+			(position + offset) % FileServiceBlockSize);
+	GetReply(&reply, NULL);
+	NoteVersion(fd, &reply, sent);
+	if (reply.result <= 0) {
+	    continue;
+	}
+	b = (position + offset) / FileServiceBlockSize;
+	block = FindBlock(fd, b);
+	if (block != NULL) {
+	    int from = (position + offset) % FileServiceBlockSize;
+
+	    bcopy(buf + offset, block->data + from, reply.result);
+	    block->length = max(block->length, from + reply.result);
+	}
+	numWritten += reply.result;
+    }
+    leases[fd].position += numWritten;
+    lock->Release();
+    return numWritten;
+}
+
+//----------------------------------------------------------------------
+// RemoteFileSystem::Print
+//	Print the client cache statistics.
+//----------------------------------------------------------------------
+
+void
+RemoteFileSystem::Print()
+{
+    cout << "Remote file system: " << requestsSent << " requests, "
+	<< cacheHits << " cache hits, " << cacheMisses << " misses, "
+	<< invalidations << " invalidations\n";
+}
@@ -0,0 +1,212 @@
+// fileservice.h
+//	Data structures for sharing one machine's file system with
+//	other Nachos machines over the network.
+//
+//	The server side is a set of kernel threads, one per client
+//	machine, that carry out file system requests on the local disk.
+//	The client side is a proxy with the same open/read/write/create/
+//	remove interface as the local file system, which forwards each
+//	operation to the server over a reliable transport connection.
+//
+//	The client caches file blocks.  Every reply from the server
+//	carries the file's current version number (bumped on every write
+//	made through the server), and grants the client a lease: for that
+//	many ticks, the client trusts its cached blocks without asking.
+//	Once the lease runs out, the next read revalidates it, and if
+//	someone else has written the file in the meantime the cached
+//	blocks are thrown away.  Writes go straight through to the server.
+//
+//	The server remembers the leases it has granted, and holds back a
+//	write to a file until every other client's lease on it has run
+//	out, so that no client reads stale blocks from its cache.  While
+//	a write is held back, leases on the file are granted for zero
+//	ticks, so that readers can't keep the writer waiting forever.
+//
+//	Reads that miss in the cache are pipelined: the requests for all
+//	of the missing blocks are sent before waiting for the first reply.
+//
+//	Each client may only use the files it opened itself through the
+//	server, and they are closed when the client goes away.
+//
+//	Note that leases are measured by each machine's own clock: the
+//	client's runs from when it sent the request, the server's from
+//	when it granted the lease, which is later.  So long as the two
+//	clocks run at about the same rate, the client stops trusting its
+//	blocks before the server lets a write through.  Writes made
+//	directly on the server machine (not through the file service)
+//	are not held back, and are not seen until the next revalidation.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILESERVICE_H
+#define FILESERVICE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "synch.h"
+#include "transport.h"
+#include <map>
+#include <set>
+
+#define FileServiceBox		3	// client's mailbox
+#define FileServerBox(client)	(4 + (client))
+					// server's mailbox for each client
+#define MaxFileServiceHosts	12	// clients must have smaller ids
+#define FileServiceMailBoxes	FileServerBox(MaxFileServiceHosts)
+					// mailboxes a post office needs
+#define FileServiceBlockSize	128	// unit of transfer and of caching
+#define FileServiceCacheBlocks	32	// blocks cached by each client
+#define MaxFileServicePath	256	// longest path name we will send
+#define LeaseTime		(50 * NetworkTime)
+					// how long a client may trust its
+					// cached blocks without asking, when
+					// no one is waiting to write
+
+// The operations a client can ask for
+enum FileServiceOp { FsCreate, FsOpen, FsClose, FsRemove,
+			FsReadAt, FsWriteAt, FsValidate, FsDisconnect };
+
+// A request is this header, followed by "length" bytes: the path
+// name for FsCreate/FsOpen/FsRemove, the data for FsWriteAt.
+// FsDisconnect gets no reply.
+
+class FileServiceRequest {
+  public:
+    int op;			// A FileServiceOp
+    int tag;			// Echoed in the reply, to match them up
+    int fd;			// Open file, on the server
+    int offset;			// Where to read or write
+    int size;			// Bytes to read, or initial file size
+    int length;			// Bytes following this header
+};
+
+// A reply is this header, followed by "length" bytes of file data
+// for FsReadAt.
+
+class FileServiceReply {
+  public:
+    int tag;			// From the request
+    int result;			// What the file system call returned
+    int version;		// File version, after the operation
+    int priorVersion;		// File version, before the operation
+    int lease;			// Ticks the client may trust its cache
+    int length;			// Bytes following this header
+};
+
+#define MaxFileServiceMessage	(sizeof(FileServiceRequest) + \
+				max(MaxFileServicePath, FileServiceBlockSize))
+
+class FileServerClient;
+
+// The following class defines the server.  It exports the local
+// file system (kernel->fileSystem) to each client machine that is
+// added.
+
+class FileServer {
+  public:
+    FileServer(PostOfficeInput *postIn, PostOfficeOutput *postOut);
+    ~FileServer();
+
+    void AddClient(NetworkAddress client);
+				// Start a connection and a server thread
+				// for requests from "client"
+
+  private:
+    static void Serve(void *data);
+				// Body of a server thread
+    void HandleRequest(FileServerClient *client,
+			FileServiceRequest *request, char *payload,
+			FileServiceReply *reply, char *replyData);
+				// Carry out one request
+    void Disconnect(FileServerClient *client);
+				// Close everything "client" has open
+    int Version(int fd);	// Current version of an open file
+    int BumpVersion(int fd);	// Note that an open file has changed
+    int GrantLease(FileServerClient *client, int fd);
+				// Give "client" a lease on an open file,
+				// and return how long it is
+    void WaitForLeases(FileServerClient *client, int fd);
+				// Wait until no other client holds a
+				// lease on an open file
+
+    PostOfficeInput *postOfficeIn;
+    PostOfficeOutput *postOfficeOut;
+    Lock *lock;			// Serializes requests from all clients,
+				// since the file system is not re-entrant
+    map<int, int> versions;	// File version, by header sector
+    map<int, int> writersWaiting;
+				// Writes held back, by header sector
+    FileServerClient *clients[MaxFileServiceHosts];
+				// Every client, by machine, or NULL
+};
+
+// A block of a remote file, as cached on the client
+
+class FileServiceBlock {
+  public:
+    bool valid;			// Is anything cached here?
+    int fd;			// Which open file
+    int blockNum;		// Which block of the file
+    int length;			// Bytes of the block that exist
+    int lastUsed;		// For LRU replacement
+    char data[FileServiceBlockSize];
+};
+
+// What the client knows about each file it has open
+
+class FileServiceLease {
+  public:
+    int version;		// Version of the file our blocks are from
+    int expires;		// When we must revalidate them
+    int position;		// Current seek position, for Read/Write
+};
+
+// The following class defines the client-side proxy.  It supports
+// the same calls as the local file system, by file descriptor.
+
+class RemoteFileSystem {
+  public:
+    RemoteFileSystem(PostOfficeInput *postIn, PostOfficeOutput *postOut,
+			NetworkAddress server);
+    ~RemoteFileSystem();
+
+    bool Create(char *name, int initialSize);
+    int Open(char *name);	// Returns a file descriptor, or -1
+    int Close(int fd);
+    bool Remove(char *name);
+    int Read(char *buf, int size, int fd);
+    int Write(char *buf, int size, int fd);
+    int Seek(int position, int fd);
+
+    void Print();		// Print cache statistics
+
+    int requestsSent;		// Requests sent to the server
+    int cacheHits;		// Blocks read from the cache
+    int cacheMisses;		// Blocks fetched from the server
+    int invalidations;		// Times cached blocks were thrown away
+
+  private:
+    void SendRequest(FileServiceRequest *request, char *payload);
+				// Send one request, without waiting
+    void GetReply(FileServiceReply *reply, char *data);
+				// Wait for the next reply
+    int Call(FileServiceRequest *request, char *payload);
+				// Send a request, wait for the reply, and
+				// return its result
+    void NoteVersion(int fd, FileServiceReply *reply, int sent);
+				// Update our lease from a reply
+    FileServiceBlock *FindBlock(int fd, int blockNum);
+    FileServiceBlock *AllocBlock(int fd, int blockNum);
+    void Invalidate(int fd);	// Forget all cached blocks of "fd"
+
+    ReliableTransport *connection;
+    Lock *lock;			// One caller at a time
+    int nextTag;
+    map<int, FileServiceLease> leases;
+				// Open files, by file descriptor
+    FileServiceBlock cache[FileServiceCacheBlocks];
+};
+
+#endif // FILESERVICE_H
@@ -12,6 +12,13 @@
 // 	The implementation synchronizes incoming messages with threads
 //	waiting for those messages.
 //
+//	Incoming messages live in a fixed pool of Mail buffers.  A packet
+//	is copied once, from the network device straight into a free
+//	buffer, and the buffer itself is then passed by reference through
+//	the mailbox to the receiving thread.  No mailbox may hold more than
+//	MaxMailPerBox of the buffers; mail for a full mailbox is dropped,
+//	as the network itself might have done.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -50,6 +57,7 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 MailBox::MailBox()
 { 
     messages = new SynchList<Mail *>(); 
+    numMessages = 0;
 }
 
 //----------------------------------------------------------------------
@@ -86,19 +94,13 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr)
 // 	Add a message to the mailbox.  If anyone is waiting for message
 //	arrival, wake them up!
 //
-//	We need to reconstruct the Mail message (by concatenating the headers
-//	to the data), to simplify queueing the message on the SynchList.
-//
-//	"pktHdr" -- source, destination machine ID's
-//	"mailHdr" -- source, destination mailbox ID's
-//	"data" -- payload message data
+//	"mail" -- the message; the mailbox holds on to the buffer itself
 //----------------------------------------------------------------------
 
 void 
-MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
+MailBox::Put(Mail *mail)
 { 
-    Mail *mail = new Mail(pktHdr, mailHdr, data); 
-
+    numMessages++;
     messages->Append(mail);		// put on the end of the list of 
 					// arrived messages, and wake up 
 					// any waiters
@@ -106,34 +108,26 @@ MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 
 //----------------------------------------------------------------------
 // MailBox::Get
-// 	Get a message from a mailbox, parsing it into the packet header,
-//	mailbox header, and data. 
+// 	Get a message from a mailbox.  The caller is handed the buffer
+//	the message arrived in, and is responsible for giving it back
+//	to the post office.
 //
 //	The calling thread waits if there are no messages in the mailbox.
-//
-//	"pktHdr" -- address to put: source, destination machine ID's
-//	"mailHdr" -- address to put: source, destination mailbox ID's
-//	"data" -- address to put: payload message data
 //----------------------------------------------------------------------
 
-void 
-MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
+Mail *
+MailBox::Get() 
 { 
     DEBUG(dbgNet, "Waiting for mail in mailbox");
     Mail *mail = messages->RemoveFront();	// remove message from list;
 						// will wait if list is empty
+    numMessages--;
 
-    *pktHdr = mail->pktHdr;
-    *mailHdr = mail->mailHdr;
     if (debug->IsEnabled('n')) {
 	cout << "Got mail from mailbox: ";
-	PrintHeader(*pktHdr, *mailHdr);
+	PrintHeader(mail->pktHdr, mail->mailHdr);
     }
-    bcopy(mail->data, data, mail->mailHdr.length);
-					// copy the message data into
-					// the caller's buffer
-    delete mail;			// we've copied out the stuff we
-					// need, we can now discard the message
+    return mail;
 }
 
 //----------------------------------------------------------------------
@@ -157,6 +151,15 @@ PostOfficeInput::PostOfficeInput(int nBoxes)
     numBoxes = nBoxes;
     boxes = new MailBox[nBoxes];
 
+    mailPool = new Mail[NumMailBuffers];
+    freeMail = new SynchList<Mail *>;
+    for (int i = 0; i < NumMailBuffers; i++) {
+	freeMail->Append(&mailPool[i]);
+    }
+    buffersInUse = maxBuffersInUse = 0;
+    mailDelivered = mailDropped = 0;
+    copies = bytesCopied = 0;
+
     network = new NetworkInput(this);
 
     Thread *t = new Thread("postal worker", 1);
@@ -177,6 +180,8 @@ PostOfficeInput::~PostOfficeInput()
 {
     delete network;
     delete [] boxes;
+    delete freeMail;
+    delete [] mailPool;
 }
 
 //----------------------------------------------------------------------
@@ -184,34 +189,53 @@ PostOfficeInput::~PostOfficeInput()
 // 	Wait for incoming messages, and put them in the right mailbox.
 //
 //      Incoming messages have had the PacketHeader stripped off,
-//	but the MailHeader is still tacked on the front of the data.
+//	but the MailHeader is still tacked on the front of the data --
+//	which is just how a Mail buffer is laid out, so the network
+//	device can copy the packet directly into it.
 //----------------------------------------------------------------------
 
 void
 PostOfficeInput::PostalDelivery(void* data)
 {
     PostOfficeInput* _this = (PostOfficeInput*)data;
-    PacketHeader pktHdr;
-    MailHeader mailHdr;
-    char *buffer = new char[MaxPacketSize];
+    Mail *mail;
+
+    ASSERT(_this->mailPool[0].data ==
+		(char *)&_this->mailPool[0].mailHdr + sizeof(MailHeader));
 
     for (;;) {
         // first, wait for a message
         _this->messageAvailable->P();	
-        pktHdr = _this->network->Receive(buffer);
 
-        mailHdr = *(MailHeader *)buffer;
+	// then for somewhere to put it; if every buffer is in a
+	// mailbox, the packet waits in the network device
+	mail = _this->freeMail->RemoveFront();
+	_this->buffersInUse++;
+	if (_this->buffersInUse > _this->maxBuffersInUse) {
+	    _this->maxBuffersInUse = _this->buffersInUse;
+	}
+        mail->pktHdr = _this->network->Receive((char *)&mail->mailHdr);
+	_this->copies++;
+	_this->bytesCopied += mail->pktHdr.length;
+
         if (debug->IsEnabled('n')) {
 	    cout << "Putting mail into mailbox: ";
-	    PrintHeader(pktHdr, mailHdr);
+	    PrintHeader(mail->pktHdr, mail->mailHdr);
         }
 
 	// check that arriving message is legal!
-	ASSERT(0 <= mailHdr.to && mailHdr.to < _this->numBoxes);
-	ASSERT(mailHdr.length <= MaxMailSize);
-
-	// put into mailbox
-        _this->boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(MailHeader));
+	ASSERT(0 <= mail->mailHdr.to && mail->mailHdr.to < _this->numBoxes);
+	ASSERT(mail->mailHdr.length <= MaxMailSize);
+
+	// put into mailbox, unless it already holds its share of buffers
+	if (_this->boxes[mail->mailHdr.to].IsFull()) {
+	    DEBUG(dbgNet, "Mailbox " << mail->mailHdr.to << " full, dropping mail");
+	    _this->mailDropped++;
+	    _this->ReturnMail(mail);
+	    continue;
+	}
+	_this->mailDelivered++;
+        _this->boxes[mail->mailHdr.to].Put(mail);
     }
 }
 
@@ -233,11 +257,70 @@ PostOfficeInput::PostalDelivery(void* data)
 void
 PostOfficeInput::Receive(int box, PacketHeader *pktHdr, 
 				MailHeader *mailHdr, char* data)
+{
+    Mail *mail = ReceiveMail(box);
+
+    *pktHdr = mail->pktHdr;
+    *mailHdr = mail->mailHdr;
+    bcopy(mail->data, data, mail->mailHdr.length);
+					// copy the message data into
+					// the caller's buffer
+    copies++;
+    bytesCopied += mail->mailHdr.length;
+    ReturnMail(mail);			// we've copied out the stuff we
+					// need, the buffer can be reused
+}
+
+//----------------------------------------------------------------------
+// PostOfficeInput::ReceiveMail
+// 	Retrieve a message from a specific box if one is available, 
+//	otherwise wait for a message to arrive in the box.  Rather than
+//	copying the message out, return the buffer it arrived in; the
+//	caller must hand it back with ReturnMail when done with it.
+//
+//	"box" -- mailbox ID in which to look for message
+//----------------------------------------------------------------------
+
+Mail *
+PostOfficeInput::ReceiveMail(int box)
 {
     ASSERT((box >= 0) && (box < numBoxes));
 
-    boxes[box].Get(pktHdr, mailHdr, data);
-    ASSERT(mailHdr->length <= MaxMailSize);
+    Mail *mail = boxes[box].Get();
+    ASSERT(mail->mailHdr.length <= MaxMailSize);
+    return mail;
+}
+
+//----------------------------------------------------------------------
+// PostOfficeInput::ReturnMail
+// 	Put a mail buffer back in the pool, once its message has been 
+//	read.  Wakes up the postal worker, if it is waiting for a buffer.
+//
+//	"mail" -- a buffer returned by ReceiveMail
+//----------------------------------------------------------------------
+
+void
+PostOfficeInput::ReturnMail(Mail *mail)
+{
+    ASSERT(mail >= mailPool && mail < mailPool + NumMailBuffers);
+    buffersInUse--;
+    freeMail->Append(mail);
+}
+
+//----------------------------------------------------------------------
+// PostOfficeInput::Print
+// 	Print how many of the mail buffers were ever in use at once, how
+//	much mail was delivered or dropped at a full mailbox, and how much
+//	copying it took to deliver the mail.
+//----------------------------------------------------------------------
+
+void
+PostOfficeInput::Print()
+{
+    cout << "Post office: at most " << maxBuffersInUse << " of "
+	<< NumMailBuffers << " mail buffers in use, " << mailDelivered
+	<< " messages delivered, " << mailDropped << " dropped at a full mailbox, "
+	<< copies << " copies of " << bytesCopied << " bytes\n";
 }
 
 //----------------------------------------------------------------------
@@ -299,9 +382,6 @@ PostOfficeOutput::~PostOfficeOutput()
 void
 PostOfficeOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 {
-    char* buffer = new char[MaxPacketSize];	// space to hold concatenated
-						// mailHdr + data
-
     if (debug->IsEnabled('n')) {
 	cout << "Post send: ";
 	PrintHeader(pktHdr, mailHdr);
@@ -313,19 +393,19 @@ PostOfficeOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
     pktHdr.from = kernel->hostName;
     pktHdr.length = mailHdr.length + sizeof(MailHeader);
 
+    sendLock->Acquire();   		// only one message can be sent
+					// to the network at any one time
+
     // concatenate MailHeader and data
     bcopy((char *)&mailHdr, buffer, sizeof(MailHeader));
     bcopy(data, buffer + sizeof(MailHeader), mailHdr.length);
 
-    sendLock->Acquire();   		// only one message can be sent
-					// to the network at any one time
     network->Send(pktHdr, buffer);
-    messageSent->P();			// wait for interrupt to tell us
+    if (!kernel->untimed) {
+	messageSent->P();		// wait for interrupt to tell us
 					// ok to send the next message
+    }
     sendLock->Release();
-
-    delete [] buffer;			// we've sent the message, so
-					// we can delete our buffer
 }
 
 //----------------------------------------------------------------------
@@ -56,14 +56,30 @@ class MailHeader {
 #define MaxMailSize 	(MaxPacketSize - sizeof(MailHeader))
 
 
+// Number of incoming mail buffers in a post office.  If all of them
+// are sitting in mailboxes, the postal worker stops pulling packets
+// off the network until a receiver gives one back.
+
+#define NumMailBuffers	32
+
+// Most messages one mailbox may hold.  Past this, new mail for the box
+// is dropped, so a mailbox nobody reads can't tie up the whole pool
+// and starve the others.
+
+#define MaxMailPerBox	(NumMailBuffers / 4)
+
 // The following class defines the format of an incoming/outgoing 
 // "Mail" message.  The message format is layered: 
 //	network header (PacketHeader) 
 //	post office header (MailHeader) 
 //	data
+//
+// The MailHeader and data are laid out just as they are on the wire,
+// so an arriving packet can be read straight into a Mail.
 
 class Mail {
   public:
+     Mail() {}			// Uninitialized buffer, for the pool
      Mail(PacketHeader pktH, MailHeader mailH, char *msgData);
 				// Initialize a mail message by
 				// concatenating the headers to the data
@@ -83,14 +99,15 @@ class MailBox {
     MailBox();			// Allocate and initialize mail box
     ~MailBox();			// De-allocate mail box
 
-    void Put(PacketHeader pktHdr, MailHeader mailHdr, char *data);
-   				// Atomically put a message into the mailbox
-    void Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data); 
-   				// Atomically get a message out of the 
+    void Put(Mail *mail);	// Atomically put a message into the mailbox
+    Mail *Get();		// Atomically get a message out of the 
 				// mailbox (and wait if there is no message 
 				// to get!)
+    bool IsFull() { return numMessages >= MaxMailPerBox; }
+				// Is the mailbox holding all it may?
   private:
     SynchList<Mail *> *messages; // A mailbox is just a list of arrived messages
+    int numMessages;		// How many are on it
 };
 
 // The following two classes defines a "Post Office", or a collection of 
@@ -112,6 +129,12 @@ class PostOfficeInput : public CallBackObj {
     				// Retrieve a message from "box".  Wait if
 				// there is no message in the box.
 
+    Mail *ReceiveMail(int box);	// Same, but hand back the mail buffer 
+				// itself rather than copying it out
+    void ReturnMail(Mail *mail);// Give a buffer from ReceiveMail back
+
+    void Print();		// Print buffer and copy statistics
+
     static void PostalDelivery(void* data);
 				// Wait for incoming messages, 
 				// and then put them in the correct mailbox
@@ -125,6 +148,17 @@ class PostOfficeInput : public CallBackObj {
     MailBox *boxes;		// Table of mail boxes to hold incoming mail
     int numBoxes;		// Number of mail boxes
     Semaphore *messageAvailable;// V'ed when message has arrived from network
+
+    Mail *mailPool;		// All of the incoming mail buffers
+    SynchList<Mail *> *freeMail;// Buffers not holding a message
+
+    int buffersInUse;		// Mail buffers out of the pool right now
+    int maxBuffersInUse;	// ... and the most ever out at once
+    int mailDelivered;		// Messages put into a mailbox
+    int mailDropped;		// Messages dropped because their
+				// mailbox was full
+    int copies;			// Times message data was copied
+    int bytesCopied;		// ... and how much of it
 };
 
 class PostOfficeOutput : public CallBackObj {
@@ -147,5 +181,7 @@ class PostOfficeOutput : public CallBackObj {
     NetworkOutput *network;	// Physical network connection
     Semaphore *messageSent;	// V'ed when next message can be sent to network
     Lock *sendLock;		// Only one outgoing message at a time
+    char buffer[MaxPacketSize];	// Outgoing MailHeader + data, protected
+				// by sendLock
 };
 #endif
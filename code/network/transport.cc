@@ -0,0 +1,441 @@
+// transport.cc
+//	Routines to provide reliable, ordered delivery of arbitrary-size
+//	messages on top of the (unreliable) post office.
+//
+//	Outgoing messages are chopped into fragments, numbered, and kept
+//	in the sender's window until the other side acknowledges them.
+//	Acknowledgements are cumulative, so a lost ack is repaired by any
+//	later one.  A lost fragment causes the receiver to discard
+//	everything after it; the sender's retransmit timer eventually
+//	goes off and the whole window is sent again.
+//
+//	The retransmit timer is driven by the interrupt simulation.  Its
+//	handler can't send anything itself (sending waits on the network
+//	device), so it just wakes up a retransmitter thread.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "transport.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// TransportMessage::TransportMessage
+//      Remember a reassembled message; we take over the buffer.
+//----------------------------------------------------------------------
+
+TransportMessage::TransportMessage(char *msgData, int msgLength)
+{
+    data = msgData;
+    length = msgLength;
+}
+
+TransportMessage::~TransportMessage()
+{
+    delete [] data;
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::ReliableTransport
+//      Initialize one end of a reliable connection, and start the
+//	threads that receive incoming fragments and retransmit lost ones.
+//
+//	"postIn", "postOut" -- the post office to run on top of
+//	"localBox" -- our mailbox; data and acks both arrive here
+//	"farHost", "farBox" -- the other end of the connection
+//	"window" -- how many unacknowledged fragments may be in flight
+//----------------------------------------------------------------------
+
+ReliableTransport::ReliableTransport(PostOfficeInput *postIn,
+		PostOfficeOutput *postOut, MailBoxAddress lBox,
+		NetworkAddress fHost, MailBoxAddress fBox, int w)
+{
+    ASSERT(w > 0);
+
+    postOfficeIn = postIn;
+    postOfficeOut = postOut;
+    localBox = lBox;
+    farHost = fHost;
+    farBox = fBox;
+
+    lock = new Lock("transport lock");
+    windowOpen = new Condition("transport window open");
+    messageReady = new Condition("transport message ready");
+    timedOut = new Semaphore("transport timed out", 0);
+
+    window = w;
+    segments = new TransportSegment[window];
+    sendBase = nextSeq = 0;
+    timeout = RetransmitTimeout;
+    deadline = 0;
+    timerPending = FALSE;
+
+    expectedSeq = 0;
+    partialSize = 2 * MaxFragmentSize;
+    partial = new char[partialSize];
+    partialLength = 0;
+    completed = new List<TransportMessage *>;
+
+    fragmentsSent = retransmissions = 0;
+    acksSent = acksRecvd = duplicatesRecvd = malformedRecvd = 0;
+
+    Thread *t = new Thread("transport receiver", 1);
+    t->Fork(ReliableTransport::ReceiveWorker, this);
+    t = new Thread("transport retransmitter", 1);
+    t->Fork(ReliableTransport::RetransmitWorker, this);
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::~ReliableTransport
+//	De-allocate the connection.
+//
+//	As with the post office, the worker threads are left waiting
+//	forever, so we don't deallocate what they are waiting on.
+//----------------------------------------------------------------------
+
+ReliableTransport::~ReliableTransport()
+{
+    while (!completed->IsEmpty()) {
+	delete completed->RemoveFront();
+    }
+    delete completed;
+    delete [] partial;
+    delete [] segments;
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::Transmit
+//	Hand one fragment to the post office.  The caller holds the
+//	connection lock, so fragments go out in sequence order.
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::Transmit(TransportSegment *segment)
+{
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+
+    pktHdr.to = farHost;
+    mailHdr.to = farBox;
+    mailHdr.from = localBox;
+    mailHdr.length = sizeof(TransportHeader) + segment->hdr.length;
+
+    postOfficeOut->Send(pktHdr, mailHdr, (char *)segment);
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::SendAck
+//	Tell the other side we have everything before sequence number "ack".
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::SendAck(int ack)
+{
+    PacketHeader pktHdr;
+    MailHeader mailHdr;
+    TransportHeader hdr;
+
+    hdr.seq = 0;
+    hdr.ack = ack;
+    hdr.kind = TransportAck;
+    hdr.lastFragment = FALSE;
+    hdr.length = 0;
+
+    pktHdr.to = farHost;
+    mailHdr.to = farBox;
+    mailHdr.from = localBox;
+    mailHdr.length = sizeof(TransportHeader);
+
+    DEBUG(dbgNet, "Transport ack " << ack << " to " << farHost);
+    acksSent++;
+    postOfficeOut->Send(pktHdr, mailHdr, (char *)&hdr);
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::ArmTimer
+//	Restart the retransmit timer for the oldest unacknowledged fragment.
+//
+//	We can't cancel an interrupt once it is scheduled, so if one is
+//	already pending we just move the deadline; the handler notices
+//	the deadline hasn't passed yet and reschedules itself.
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::ArmTimer()
+{
+    deadline = kernel->stats->totalTicks + timeout;
+    if (!timerPending) {
+	timerPending = TRUE;
+	kernel->interrupt->Schedule(this, timeout, NetworkTimerInt);
+    }
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::CallBack
+//	Interrupt handler for the retransmit timer.  If there is still
+//	something unacknowledged and its deadline has passed, wake up
+//	the retransmitter.
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::CallBack()
+{
+    int now = kernel->stats->totalTicks;
+
+    timerPending = FALSE;
+    if (sendBase == nextSeq) {		// everything acked, nothing to do
+	return;
+    }
+    if (now < deadline) {		// progress made since we were armed
+	timerPending = TRUE;
+	kernel->interrupt->Schedule(this, deadline - now, NetworkTimerInt);
+	return;
+    }
+    timedOut->V();
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::RetransmitWorker
+//	Wait for the retransmit timer to expire, then go back and resend
+//	every fragment in the window, and back off the timeout.
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::RetransmitWorker(void *data)
+{
+    ReliableTransport *_this = (ReliableTransport *)data;
+
+    for (;;) {
+	_this->timedOut->P();
+
+	_this->lock->Acquire();
+	if (_this->sendBase != _this->nextSeq) {
+	    DEBUG(dbgNet, "Transport timeout, resending " << _this->sendBase
+			<< " to " << _this->nextSeq - 1);
+	    for (int seq = _this->sendBase; seq < _this->nextSeq; seq++) {
+		_this->Transmit(&_this->segments[seq % _this->window]);
+		_this->retransmissions++;
+	    }
+	    _this->timeout = min(2 * _this->timeout, MaxRetransmitTimeout);
+	    _this->ArmTimer();
+	}
+	_this->lock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::ReceiveWorker
+//	Wait for fragments and acks to arrive in our mailbox, and
+//	dispatch them.  Acks for incoming data are sent from here, after
+//	the connection lock has been released.
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::ReceiveWorker(void *data)
+{
+    ReliableTransport *_this = (ReliableTransport *)data;
+    Mail *mail;
+    TransportHeader *hdr;
+    int ack;
+
+    for (;;) {
+	// work on the fragment in place, in the post office's buffer
+	mail = _this->postOfficeIn->ReceiveMail(_this->localBox);
+	hdr = (TransportHeader *)mail->data;
+	if (mail->mailHdr.length < sizeof(TransportHeader)
+		|| hdr->length > mail->mailHdr.length - sizeof(TransportHeader)
+		|| (hdr->kind != TransportData && hdr->kind != TransportAck)) {
+	    DEBUG(dbgNet, "Transport dropping malformed fragment");
+	    _this->malformedRecvd++;	// a bad peer mustn't stop us
+	    _this->postOfficeIn->ReturnMail(mail);
+	    continue;
+	}
+
+	_this->lock->Acquire();
+	if (hdr->kind == TransportAck) {
+	    _this->AckArrived(hdr);
+	    _this->lock->Release();
+	    _this->postOfficeIn->ReturnMail(mail);
+	} else {
+	    _this->DataArrived(hdr, mail->data + sizeof(TransportHeader));
+	    ack = _this->expectedSeq;
+	    _this->lock->Release();
+	    _this->postOfficeIn->ReturnMail(mail);
+	    _this->SendAck(ack);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::AckArrived
+//	Slide the window forward past everything the other side has
+//	acknowledged, and wake up anyone waiting for room in the window.
+//
+//	"hdr" -- the acknowledgement
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::AckArrived(TransportHeader *hdr)
+{
+    ASSERT(lock->IsHeldByCurrentThread());
+
+    if (hdr->ack <= sendBase || hdr->ack > nextSeq) {
+	return;				// old or bogus ack
+    }
+    DEBUG(dbgNet, "Transport acked through " << hdr->ack - 1);
+    acksRecvd++;
+    sendBase = hdr->ack;
+    timeout = RetransmitTimeout;	// we're making progress again
+    if (sendBase != nextSeq) {
+	ArmTimer();
+    }
+    windowOpen->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::DataArrived
+//	Accept the next in-order fragment; anything else is dropped (the
+//	ack sent by our caller tells the sender where to resume).  When
+//	the last fragment of a message arrives, the message is complete.
+//
+//	"hdr" -- the fragment header
+//	"data" -- the fragment payload
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::DataArrived(TransportHeader *hdr, char *data)
+{
+    ASSERT(lock->IsHeldByCurrentThread());
+
+    if (hdr->seq != expectedSeq) {
+	DEBUG(dbgNet, "Transport dropping fragment " << hdr->seq
+			<< ", expecting " << expectedSeq);
+	duplicatesRecvd++;
+	return;
+    }
+    expectedSeq++;
+
+    if (partialLength + hdr->length > partialSize) {
+	char *bigger = new char[2 * partialSize];
+
+	bcopy(partial, bigger, partialLength);
+	delete [] partial;
+	partial = bigger;
+	partialSize *= 2;
+    }
+    bcopy(data, partial + partialLength, hdr->length);
+    partialLength += hdr->length;
+
+    if (hdr->lastFragment) {
+	char *msgData = new char[partialLength];
+
+	bcopy(partial, msgData, partialLength);
+	completed->Append(new TransportMessage(msgData, partialLength));
+	partialLength = 0;
+	messageReady->Signal(lock);
+    }
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::Send
+//	Split a message into fragments and send each as soon as there is
+//	room for it in the window.  Returns once the last fragment has
+//	been put on the wire; use Flush to wait until it is acknowledged.
+//
+//	"data" -- the message
+//	"length" -- its size in bytes; an empty message is one empty fragment
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::Send(char *data, int length)
+{
+    int offset = 0;
+    TransportSegment *segment;
+
+    ASSERT(length >= 0);
+
+    lock->Acquire();
+    do {
+	while (nextSeq - sendBase >= window) {
+	    windowOpen->Wait(lock);
+	}
+	segment = &segments[nextSeq % window];
+	segment->hdr.seq = nextSeq;
+	segment->hdr.ack = 0;
+	segment->hdr.kind = TransportData;
+	segment->hdr.length = min(length - offset, (int)MaxFragmentSize);
+	segment->hdr.lastFragment = (offset + segment->hdr.length == length);
+	bcopy(data + offset, segment->data, segment->hdr.length);
+	offset += segment->hdr.length;
+
+	if (sendBase == nextSeq) {	// window was empty; start the clock
+	    ArmTimer();
+	}
+	nextSeq++;
+	Transmit(segment);
+	fragmentsSent++;
+    } while (offset < length);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::Receive
+//	Wait for the next reassembled message, and copy it out.
+//
+//	"data" -- where to put the message
+//	"maxLength" -- size of "data"; the rest of a longer message is lost
+//
+// Returns:
+//	the full length of the message
+//----------------------------------------------------------------------
+
+int
+ReliableTransport::Receive(char *data, int maxLength)
+{
+    TransportMessage *message;
+    int length;
+
+    lock->Acquire();
+    while (completed->IsEmpty()) {
+	messageReady->Wait(lock);
+    }
+    message = completed->RemoveFront();
+    lock->Release();
+
+    length = message->length;
+    bcopy(message->data, data, min(length, maxLength));
+    delete message;
+    return length;
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::Flush
+//	Wait until every fragment sent so far has been acknowledged.
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::Flush()
+{
+    lock->Acquire();
+    while (sendBase != nextSeq) {
+	windowOpen->Wait(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// ReliableTransport::Print
+//	Print the connection statistics.
+//----------------------------------------------------------------------
+
+void
+ReliableTransport::Print()
+{
+    cout << "Transport: fragments sent " << fragmentsSent
+	<< ", retransmitted " << retransmissions
+	<< ", acks sent " << acksSent << ", acks received " << acksRecvd
+	<< ", out of order dropped " << duplicatesRecvd
+	<< ", malformed dropped " << malformedRecvd << "\n";
+}
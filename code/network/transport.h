@@ -0,0 +1,163 @@
+// transport.h
+//	Data structures for providing the abstraction of reliable,
+//	ordered delivery of arbitrary-size messages between a pair of
+//	mailboxes on (directly connected) machines.
+//
+//	The transport is layered on top of the unreliable post office.
+//	Each message is split into fragments small enough to fit in a
+//	single piece of mail; every fragment carries a sequence number.
+//	The receiver accepts fragments strictly in order, reassembles
+//	them into messages, and replies with cumulative acknowledgements
+//	(the sequence number of the next fragment it expects).
+//
+//	The sender keeps up to "window" unacknowledged fragments in flight.
+//	If the oldest of them is not acknowledged before the retransmit
+//	timer goes off, the sender goes back and resends every fragment in
+//	the window (go-back-N), doubling the timeout each time it fails
+//	to make progress.
+//
+//	Both data and acknowledgements for a connection arrive in the
+//	same local mailbox, so a mailbox must not be shared between a
+//	transport and any other user of the post office.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "callback.h"
+#include "list.h"
+#include "synch.h"
+#include "post.h"
+
+// The kinds of segment the transport puts on the wire.
+enum TransportKind { TransportData, TransportAck };
+
+// The transport header is prepended to every fragment, after the
+// MailHeader.  It is kept small, since every byte of it comes out
+// of the payload of a packet.
+
+class TransportHeader {
+  public:
+    int seq;			// Sequence number of this fragment (data)
+    int ack;			// Next sequence number expected (acks)
+    unsigned char kind;		// TransportData or TransportAck
+    unsigned char lastFragment;	// TRUE if this fragment ends a message
+    unsigned short length;	// Bytes of fragment data
+};
+
+// Largest piece of a message that can be carried by one fragment
+
+#define MaxFragmentSize	(MaxMailSize - sizeof(TransportHeader))
+
+#define DefaultWindow		8	// fragments in flight, by default
+#define RetransmitTimeout	(20 * NetworkTime)
+					// initial time to wait for an ack
+#define MaxRetransmitTimeout	(16 * RetransmitTimeout)
+					// give up backing off beyond this
+
+// A fragment, as kept in the sender's window until it is acknowledged
+
+class TransportSegment {
+  public:
+    TransportHeader hdr;
+    char data[MaxFragmentSize];
+};
+
+// A completely reassembled message, waiting to be received
+
+class TransportMessage {
+  public:
+    TransportMessage(char *msgData, int msgLength);
+    ~TransportMessage();
+
+    char *data;
+    int length;
+};
+
+// The following class defines one end of a reliable connection
+// between mailbox "localBox" on this machine and mailbox "farBox"
+// on machine "farHost".  The other machine must create the mirror
+// image connection.
+//
+// The transport is also the interrupt handler for its own retransmit
+// timer.
+
+class ReliableTransport : public CallBackObj {
+  public:
+    ReliableTransport(PostOfficeInput *postIn, PostOfficeOutput *postOut,
+		MailBoxAddress localBox, NetworkAddress farHost,
+		MailBoxAddress farBox, int window);
+				// Set up one end of a connection
+    ~ReliableTransport();
+
+    void Send(char *data, int length);
+				// Fragment "data" and queue it for
+				// reliable delivery; waits only if the
+				// window is full
+    int Receive(char *data, int maxLength);
+				// Wait for the next complete message,
+				// copy at most "maxLength" bytes of it
+				// into "data", and return its length
+    void Flush();		// Wait until everything sent so far
+				// has been acknowledged
+
+    void CallBack();		// Retransmit timer has gone off
+
+    void Print();		// Print the connection statistics
+
+    int fragmentsSent;		// Fragments put on the wire the first time
+    int retransmissions;	// Fragments put on the wire again
+    int acksSent;		// Acknowledgements sent
+    int acksRecvd;		// Acknowledgements that advanced the window
+    int duplicatesRecvd;	// Fragments thrown away as out of order
+    int malformedRecvd;		// Fragments thrown away as too short,
+				// or not data or an ack
+
+  private:
+    static void ReceiveWorker(void *data);
+				// Handle incoming fragments and acks
+    static void RetransmitWorker(void *data);
+				// Resend the window when the timer expires
+
+    void Transmit(TransportSegment *segment);
+				// Put one fragment on the wire
+    void SendAck(int ack);	// Acknowledge everything before "ack"
+    void ArmTimer();		// (Re)start the retransmit timer
+    void DataArrived(TransportHeader *hdr, char *data);
+    void AckArrived(TransportHeader *hdr);
+
+    PostOfficeInput *postOfficeIn;
+    PostOfficeOutput *postOfficeOut;
+    MailBoxAddress localBox;
+    NetworkAddress farHost;
+    MailBoxAddress farBox;
+
+    Lock *lock;			// Protects the connection state below
+    Condition *windowOpen;	// Signalled when acks advance sendBase
+    Condition *messageReady;	// Signalled when a message is reassembled
+    Semaphore *timedOut;	// V'ed by the timer; wakes the retransmitter
+
+    // Sender state
+    int window;			// Most fragments allowed in flight
+    TransportSegment *segments;	// Unacknowledged fragments, by seq % window
+    int sendBase;		// Oldest unacknowledged sequence number
+    int nextSeq;		// Sequence number of the next new fragment
+    int timeout;		// Current retransmit timeout (ticks)
+    int deadline;		// When the oldest fragment times out
+    bool timerPending;		// Is a timer interrupt scheduled?
+
+    // Receiver state
+    int expectedSeq;		// Next in-order fragment we will accept
+    char *partial;		// Message being reassembled
+    int partialLength;		// Bytes reassembled so far
+    int partialSize;		// Size of the "partial" buffer
+    List<TransportMessage *> *completed;
+				// Reassembled, not yet received messages
+};
+
+#endif // TRANSPORT_H
@@ -0,0 +1,497 @@
+/* bufio.c
+ *	Buffered I/O for Nachos user programs.  See bufio.h.
+ *
+ *	A File being read holds the bytes from buf[next] to buf[count]
+ *	that haven't been read yet; one being written holds "count"
+ *	bytes that haven't been written.  Transfers of a whole buffer
+ *	or more skip the buffer, when it is empty, and go straight to
+ *	Read or Write.
+ */
+
+#include "bufio.h"
+#include <stdarg.h>
+
+/* The first two are the console, which is always open. */
+File bufFiles[MaxFiles] = {
+    { SysConsoleInput, BufRead },
+    { SysConsoleOutput, BufWrite | BufLine }
+};
+
+/* -------------------------------------------------------------
+ * Copy
+ *	Copy "size" bytes from "from" to "to".
+ * -------------------------------------------------------------
+ */
+
+static void
+Copy(char *to, char *from, int size)
+{
+    while (size-- > 0) {
+	*to++ = *from++;
+    }
+}
+
+/* -------------------------------------------------------------
+ * ReadInto
+ *	Call Read for up to "size" bytes of "f".  Before waiting for
+ *	the keyboard, write out any prompt.  Returns how many bytes
+ *	were read, or 0 at the end of the file.
+ * -------------------------------------------------------------
+ */
+
+static int
+ReadInto(File *f, char *buffer, int size)
+{
+    int n;
+
+    if (f == Stdin) {
+	Fflush(Stdout);
+    }
+    n = Read(buffer, size, f->id);
+    if (n <= 0) {
+	f->flags |= BufEnd;
+	return 0;
+    }
+    return n;
+}
+
+/* -------------------------------------------------------------
+ * Fill
+ *	Refill the (empty) buffer of a File being read.
+ * -------------------------------------------------------------
+ */
+
+static void
+Fill(File *f)
+{
+    f->next = 0;
+    f->count = ReadInto(f, f->buf, BufSize);
+}
+
+/* -------------------------------------------------------------
+ * Fopen
+ *	Open a Nachos file for reading or writing, and give it a
+ *	buffer.
+ *
+ *	"name" -- the file
+ *	"mode" -- "r" to read it, "w" to write it
+ * -------------------------------------------------------------
+ */
+
+File *
+Fopen(char *name, char *mode)
+{
+    File *f;
+    int i, flags;
+
+    if (mode[0] == 'r') {
+	flags = BufRead;
+    } else if (mode[0] == 'w') {
+	flags = BufWrite;
+    } else {
+	return 0;
+    }
+    for (i = 0; i < MaxFiles; i++) {
+	if (bufFiles[i].flags == 0) {
+	    break;
+	}
+    }
+    if (i == MaxFiles) {
+	return 0;
+    }
+    f = &bufFiles[i];
+    f->id = Open(name);
+    if (f->id <= 0) {
+	return 0;
+    }
+    f->flags = flags;
+    f->count = 0;
+    f->next = 0;
+    return f;
+}
+
+/* -------------------------------------------------------------
+ * Fclose
+ *	Write out what is buffered, and close the file.  The console
+ *	is only flushed.
+ * -------------------------------------------------------------
+ */
+
+int
+Fclose(File *f)
+{
+    int result = Fflush(f);
+
+    if (f != Stdin && f != Stdout) {
+	Close(f->id);
+	f->flags = 0;
+    }
+    return result;
+}
+
+/* -------------------------------------------------------------
+ * Fflush
+ *	Write out what is buffered for a File being written.  Returns
+ *	-1 if it couldn't all be written; it is thrown away anyway.
+ * -------------------------------------------------------------
+ */
+
+int
+Fflush(File *f)
+{
+    int size = f->count;
+
+    if (!(f->flags & BufWrite) || size == 0) {
+	return 0;
+    }
+    f->count = 0;
+    if (Write(f->buf, size, f->id) != size) {
+	return -1;
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------
+ * FflushAll
+ *	Write out what is buffered for every File.  Call this before
+ *	Exit or Halt.
+ * -------------------------------------------------------------
+ */
+
+void
+FflushAll()
+{
+    int i;
+
+    for (i = 0; i < MaxFiles; i++) {
+	Fflush(&bufFiles[i]);
+    }
+}
+
+/* -------------------------------------------------------------
+ * Fgetc
+ *	Return the next character of a File, or BufEOF if there are
+ *	no more.
+ * -------------------------------------------------------------
+ */
+
+int
+Fgetc(File *f)
+{
+    if (!(f->flags & BufRead)) {
+	return BufEOF;
+    }
+    if (f->next == f->count) {
+	if (f->flags & BufEnd) {
+	    return BufEOF;
+	}
+	Fill(f);
+	if (f->count == 0) {
+	    return BufEOF;
+	}
+    }
+    return f->buf[f->next++] & 0xff;
+}
+
+/* -------------------------------------------------------------
+ * Fputc
+ *	Add a character to a File, writing out the buffer if it is
+ *	full, or if it is the end of a line on the console.  Returns
+ *	the character, or BufEOF if it couldn't be written.
+ * -------------------------------------------------------------
+ */
+
+int
+Fputc(int c, File *f)
+{
+    if (!(f->flags & BufWrite)) {
+	return BufEOF;
+    }
+    f->buf[f->count++] = c;
+    if (f->count == BufSize || (c == '\n' && (f->flags & BufLine))) {
+	if (Fflush(f) < 0) {
+	    return BufEOF;
+	}
+    }
+    return c & 0xff;
+}
+
+/* -------------------------------------------------------------
+ * Fread
+ *	Read "size" bytes from a File into "buffer".  Returns how
+ *	many there were.
+ * -------------------------------------------------------------
+ */
+
+int
+Fread(char *buffer, int size, File *f)
+{
+    int done = 0, n;
+
+    if (!(f->flags & BufRead)) {
+	return 0;
+    }
+    while (done < size) {
+	if (f->next == f->count) {
+	    if (f->flags & BufEnd) {
+		break;
+	    }
+	    if (size - done >= BufSize) {	/* don't bother buffering it */
+		n = ReadInto(f, buffer + done, size - done);
+		if (n == 0) {
+		    break;
+		}
+		done += n;
+		continue;
+	    }
+	    Fill(f);
+	    if (f->count == 0) {
+		break;
+	    }
+	}
+	n = f->count - f->next;
+	if (n > size - done) {
+	    n = size - done;
+	}
+	Copy(buffer + done, f->buf + f->next, n);
+	f->next += n;
+	done += n;
+    }
+    return done;
+}
+
+/* -------------------------------------------------------------
+ * Fwrite
+ *	Write "size" bytes from "buffer" to a File.  Returns how many
+ *	were written (or buffered).
+ * -------------------------------------------------------------
+ */
+
+int
+Fwrite(char *buffer, int size, File *f)
+{
+    int done = 0, n;
+
+    if (!(f->flags & BufWrite)) {
+	return 0;
+    }
+    if (f->flags & BufLine) {		/* look for the newlines */
+	for (; done < size; done++) {
+	    if (Fputc(buffer[done], f) == BufEOF) {
+		break;
+	    }
+	}
+	return done;
+    }
+    while (done < size) {
+	if (f->count == 0 && size - done >= BufSize) {
+	    n = Write(buffer + done, size - done, f->id);
+	    if (n <= 0) {
+		break;
+	    }
+	    done += n;
+	    continue;
+	}
+	n = BufSize - f->count;
+	if (n > size - done) {
+	    n = size - done;
+	}
+	Copy(f->buf + f->count, buffer + done, n);
+	f->count += n;
+	done += n;
+	if (f->count == BufSize && Fflush(f) < 0) {
+	    break;
+	}
+    }
+    return done;
+}
+
+/* -------------------------------------------------------------
+ * Fgets
+ *	Read a line from a File into "buffer", and null-terminate it.
+ *	A line longer than "size" - 1 characters is read in pieces.
+ * -------------------------------------------------------------
+ */
+
+char *
+Fgets(char *buffer, int size, File *f)
+{
+    int i = 0, c;
+
+    while (i < size - 1) {
+	c = Fgetc(f);
+	if (c == BufEOF) {
+	    break;
+	}
+	buffer[i++] = c;
+	if (c == '\n') {
+	    break;
+	}
+    }
+    if (i == 0) {
+	return 0;
+    }
+    buffer[i] = '\0';
+    return buffer;
+}
+
+/* -------------------------------------------------------------
+ * Fputs
+ *	Write a null-terminated string to a File.  Returns how many
+ *	characters were written.
+ * -------------------------------------------------------------
+ */
+
+int
+Fputs(char *s, File *f)
+{
+    int len = 0;
+
+    while (s[len] != '\0') {
+	len++;
+    }
+    return Fwrite(s, len, f);
+}
+
+/* -------------------------------------------------------------
+ * PrintNumber
+ *	Write "n" in base "base", at least "width" characters wide.
+ *	Returns how many characters were written.
+ *
+ *	"negative" -- put a minus sign in front
+ *	"pad" -- what to fill the width with: ' ' or '0'
+ * -------------------------------------------------------------
+ */
+
+static int
+PrintNumber(File *f, unsigned int n, int base, int negative, int width,
+								char pad)
+{
+    char digits[12];
+    int len = 0, count = 0;
+
+    do {
+	digits[len++] = "0123456789abcdef"[n % base];
+	n /= base;
+    } while (n != 0);
+    if (negative) {
+	if (pad == '0') {		/* the sign goes before the zeros */
+	    Fputc('-', f);
+	    count++;
+	    width--;
+	} else {
+	    digits[len++] = '-';
+	}
+    }
+    for (; width > len; width--) {
+	Fputc(pad, f);
+	count++;
+    }
+    while (len > 0) {
+	Fputc(digits[--len], f);
+	count++;
+    }
+    return count;
+}
+
+/* -------------------------------------------------------------
+ * DoPrint
+ *	The guts of Fprintf and Printf.
+ * -------------------------------------------------------------
+ */
+
+static int
+DoPrint(File *f, char *format, va_list args)
+{
+    char *p, *s, pad;
+    int count = 0, width, len, value;
+
+    for (p = format; *p != '\0'; p++) {
+	if (*p != '%') {
+	    Fputc(*p, f);
+	    count++;
+	    continue;
+	}
+	p++;
+	pad = ' ';
+	width = 0;
+	if (*p == '0') {
+	    pad = '0';
+	    p++;
+	}
+	while (*p >= '0' && *p <= '9') {
+	    width = width * 10 + *p++ - '0';
+	}
+	switch (*p) {
+	  case 'd':
+	    value = va_arg(args, int);
+	    if (value < 0) {
+		count += PrintNumber(f, -(unsigned int) value, 10, 1,
+								width, pad);
+	    } else {
+		count += PrintNumber(f, value, 10, 0, width, pad);
+	    }
+	    break;
+	  case 'u':
+	    count += PrintNumber(f, va_arg(args, unsigned int), 10, 0,
+								width, pad);
+	    break;
+	  case 'x':
+	    count += PrintNumber(f, va_arg(args, unsigned int), 16, 0,
+								width, pad);
+	    break;
+	  case 'c':
+	    Fputc(va_arg(args, int), f);
+	    count++;
+	    break;
+	  case 's':
+	    s = va_arg(args, char *);
+	    for (len = 0; s[len] != '\0'; len++)
+		;
+	    for (; width > len; width--) {
+		Fputc(' ', f);
+		count++;
+	    }
+	    count += Fwrite(s, len, f);
+	    break;
+	  case '\0':			/* a '%' at the end */
+	    p--;
+	    break;
+	  default:			/* "%%", or one we don't know */
+	    Fputc(*p, f);
+	    count++;
+	    break;
+	}
+    }
+    return count;
+}
+
+/* -------------------------------------------------------------
+ * Fprintf, Printf
+ *	Formatted output, to a File or to the console.
+ * -------------------------------------------------------------
+ */
+
+int
+Fprintf(File *f, char *format, ...)
+{
+    va_list args;
+    int count;
+
+    va_start(args, format);
+    count = DoPrint(f, format, args);
+    va_end(args);
+    return count;
+}
+
+int
+Printf(char *format, ...)
+{
+    va_list args;
+    int count;
+
+    va_start(args, format);
+    count = DoPrint(Stdout, format, args);
+    va_end(args);
+    return count;
+}
@@ -0,0 +1,88 @@
+/* bufio.h
+ *	A small buffered I/O library for Nachos user programs, along
+ *	the lines of UNIX stdio.
+ *
+ *	Every Read and Write is a trap into the kernel, so a program
+ *	that reads or writes a few bytes at a time spends most of its
+ *	time getting in and out of the kernel.  Instead, each File
+ *	here has a page-sized buffer, and we only call Read or Write
+ *	when it is empty or full.
+ *
+ *	Output to the console is line buffered: it is written out at
+ *	each newline, and before reading from the console, so that a
+ *	prompt shows up.  Output to a file stays in the buffer until it
+ *	is full, or the file is flushed or closed.  Nothing flushes it
+ *	when the program exits -- call FflushAll first.
+ *
+ *	To use it, link bufio.o in after the program (see Makefile).
+ */
+
+#ifndef BUFIO_H
+#define BUFIO_H
+
+#include "syscall.h"
+
+#define BufSize		128	/* a page; see DefaultPageSize in machine.h */
+#define MaxFiles	8	/* how many Files can be open, with the console */
+#define BufEOF		(-1)	/* what Fgetc returns at end of file */
+
+/* Flags in File.flags */
+#define BufRead		1	/* open for reading */
+#define BufWrite	2	/* open for writing */
+#define BufLine		4	/* write out a line at a time */
+#define BufEnd		8	/* Read has returned end of file */
+
+typedef struct {
+    OpenFileId id;		/* the Nachos file */
+    int flags;			/* 0 if this File isn't in use */
+    int count;			/* bytes in the buffer */
+    int next;			/* next one to read, if reading */
+    char buf[BufSize];
+} File;
+
+extern File bufFiles[MaxFiles];
+
+#define Stdin	(&bufFiles[0])	/* the keyboard */
+#define Stdout	(&bufFiles[1])	/* the display */
+
+/* Open an existing Nachos file, for reading ("r") or writing ("w").
+ * Returns 0 if it can't be opened.  Create the file first to write
+ * a new one.
+ */
+File *Fopen(char *name, char *mode);
+
+/* Write out anything buffered, and close the file.  Returns -1 if
+ * the buffer couldn't all be written.
+ */
+int Fclose(File *f);
+
+/* Write out anything buffered for "f", or for every open File. */
+int Fflush(File *f);
+void FflushAll();
+
+/* Read or write one character.  Fgetc returns BufEOF at the end of
+ * the file.
+ */
+int Fgetc(File *f);
+int Fputc(int c, File *f);
+
+/* Read or write "size" bytes; returns how many were. */
+int Fread(char *buffer, int size, File *f);
+int Fwrite(char *buffer, int size, File *f);
+
+/* Read a line, up to "size" - 1 characters, including the newline
+ * if there is room.  Returns 0 if there was nothing left to read.
+ */
+char *Fgets(char *buffer, int size, File *f);
+
+/* Write a string, without adding a newline. */
+int Fputs(char *s, File *f);
+
+/* Formatted output: %d, %u, %x, %c, %s and %%, with an optional
+ * field width ("%4d"), padded with zeros if it starts with 0.
+ * Returns how many characters were written.
+ */
+int Fprintf(File *f, char *format, ...);
+int Printf(char *format, ...);
+
+#endif /* BUFIO_H */
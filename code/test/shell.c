@@ -1,35 +1,31 @@
 #include "syscall.h"
+#include "bufio.h"
 
 int
 main()
 {
     SpaceId newProc;
-    OpenFileId input = ConsoleInput;
-    OpenFileId output = ConsoleOutput;
-    char prompt[2], ch, buffer[60];
+    char buffer[60];
     int i;
 
-    prompt[0] = '-';
-    prompt[1] = '-';
-
     while( 1 )
     {
-	Write(prompt, 2, output);
-
-	i = 0;
-	
-	do {
-	
-	    Read(&buffer[i], 1, input); 
+	Fputs("--", Stdout);
 
-	} while( buffer[i++] != '\n' );
+	/* one Read per line, not per character */
+	if (Fgets(buffer, sizeof(buffer), Stdin) == 0) {
+	    break;
+	}
 
-	buffer[--i] = '\0';
+	for (i = 0; buffer[i] != '\0' && buffer[i] != '\n'; i++)
+	    ;
+	buffer[i] = '\0';
 
 	if( i > 0 ) {
 		newProc = Exec(buffer);
 		Join(newProc);
 	}
     }
+    FflushAll();
+    Exit(0);
 }
-
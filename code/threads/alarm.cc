@@ -1,11 +1,10 @@
 // alarm.cc
 //	Routines to use a hardware timer device to provide a
-//	software alarm clock.  For now, we just provide time-slicing.
-//
-//	Not completely implemented.
+//	software alarm clock: time-slicing, and putting threads to
+//	sleep until a given time.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
-// All rights reserved.  See copyright.h for copyright notice and limitation 
+// All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
@@ -16,13 +15,111 @@
 // Alarm::Alarm
 //      Initialize a software alarm clock.  Start up a timer device
 //
-//      "doRandom" -- if true, arrange for the hardware interrupts to 
+//      "doRandom" -- if true, arrange for the hardware interrupts to
 //		occur at random, instead of fixed, intervals.
+//      "ticklessMode" -- if true, stop the timer while only one thread
+//		can run
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom)
+Alarm::Alarm(bool doRandom, bool ticklessMode)
 {
+    tickless = ticklessMode;
+    for (int i = 0; i < WheelLevels; i++) {
+	levelCount[i] = 0;
+    }
+    numSleepers = 0;
+    wheelTime = kernel->stats->totalTicks;
+    disabled = FALSE;
+
     timer = new Timer(doRandom, this);
+    if (tickless && !TimerNeeded()) {
+	timer->Stop();
+    }
+}
+
+//----------------------------------------------------------------------
+// Alarm::Disable
+//	There is nothing left to run, so stop the timer, letting the
+//	machine halt once the other devices are done -- unless someone
+//	is asleep, and needs waking up.
+//
+//	This isn't for good: more threads may yet run (this happens
+//	whenever the only thread waits for the disk), and CheckTimer
+//	starts the timer again as soon as someone needs it.
+//----------------------------------------------------------------------
+
+void
+Alarm::Disable()
+{
+    if (numSleepers == 0) {
+	DEBUG(dbgThread, "Disabling the timer at " << kernel->stats->totalTicks);
+	timer->Stop();
+	disabled = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Alarm::TimerNeeded
+//	Is there any point in a timer interrupt?  Only if some other
+//	thread is waiting to run.  While the machine is idle, the first
+//	thread to become ready will run by itself, so there must be two.
+//----------------------------------------------------------------------
+
+bool
+Alarm::TimerNeeded()
+{
+    int waiting = kernel->scheduler->NumReady();
+
+    if (kernel->interrupt->getStatus() == IdleMode) {
+	return waiting > 1;
+    }
+    return waiting > 0;
+}
+
+//----------------------------------------------------------------------
+// Alarm::CheckTimer
+//	Called when a thread becomes ready, goes to sleep, or wakes up,
+//	to set the timer for what it has to do now.
+//
+//	If no one needs time slicing, and we are idle (or tickless),
+//	the timer is only needed for the next sleeper: set it for then,
+//	so we skip the ticks in between.
+//
+//	Otherwise the timer runs as usual -- but no later than the next
+//	sleeper is due.  If it was set for a sleeper a long way off,
+//	someone needs time slicing now, so bring it back in.
+//
+//	We don't stop the timer just because no one needs slicing any
+//	more; the next interrupt does that, if it is still the case.
+//----------------------------------------------------------------------
+
+void
+Alarm::CheckTimer()
+{
+    int now = kernel->stats->totalTicks;
+    int deadline = NextDeadline();
+
+    if (!TimerNeeded()) {
+	if (tickless || kernel->interrupt->getStatus() == IdleMode) {
+	    if (deadline >= 0) {
+		timer->Reprogram(max(deadline - now, 1));
+		disabled = FALSE;
+	    }
+	    return;
+	}
+    }
+    if (!timer->IsRunning()) {
+	if (!tickless && deadline < 0 && !disabled) {
+	    return;			// will be reset shortly
+	}
+	timer->Start();
+	disabled = FALSE;
+    } else if (timer->NextInterrupt() > now + 2 * TimerTicks) {
+	timer->Reprogram(TimerTicks);	// longest a slice can be
+    }
+    if (deadline >= 0 && timer->NextInterrupt() > deadline) {
+	timer->Reprogram(max(deadline - now, 1));
+    }
 }
 
 //----------------------------------------------------------------------
@@ -32,24 +129,256 @@ Alarm::Alarm(bool doRandom)
 //	This routine is called each time there is a timer interrupt,
 //	with interrupts disabled.
 //
+//	First we wake up any sleeping threads that are due.
+//
 //	Note that instead of calling Yield() directly (which would
 //	suspend the interrupt handler, not the interrupted thread
 //	which is what we wanted to context switch), we set a flag
-//	so that once the interrupt handler is done, it will appear as 
-//	if the interrupted thread called Yield at the point it is 
+//	so that once the interrupt handler is done, it will appear as
+//	if the interrupted thread called Yield at the point it is
 //	was interrupted.
 //
-//	For now, just provide time-slicing.  Only need to time slice 
-//      if we're currently running something (in other words, not idle).
+//	Only need to time slice if we're currently running something
+//	(in other words, not idle).  In tickless mode, we also need
+//	someone to switch to; if there is no one, and no one asleep,
+//	we stop the timer until there is.
 //----------------------------------------------------------------------
 
-void 
-Alarm::CallBack() 
+void
+Alarm::CallBack()
 {
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
-    
-    if (status != IdleMode) {
+
+    Advance(kernel->stats->totalTicks);
+
+    if (tickless && !TimerNeeded() && numSleepers == 0) {
+	DEBUG(dbgThread, "Stopping the timer at " << kernel->stats->totalTicks);
+	timer->Stop();
+	return;
+    }
+    if (status != IdleMode && (!tickless || TimerNeeded())) {
 	interrupt->YieldOnReturn();
     }
+    CheckTimer();
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+//	Put the current thread to sleep for "x" ticks.  The thread is
+//	woken up by the first timer interrupt after that.
+//
+//	"x" -- how long to sleep; if it is not positive, we just return
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int x)
+{
+    IntStatus oldLevel;
+    Sleeper sleeper;
+
+    if (x <= 0) {
+	return;
+    }
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    sleeper.thread = kernel->currentThread;
+    sleeper.when = kernel->stats->totalTicks + x;
+    DEBUG(dbgThread, "Sleeping thread " << sleeper.thread->getName()
+				<< " until " << sleeper.when);
+    Add(&sleeper);
+    kernel->currentThread->Sleep(FALSE);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::Add
+//	Arrange for sleeper->thread to be put on the ready list at
+//	time sleeper->when.  The caller is responsible for putting it
+//	to sleep, and for keeping "sleeper" around until then.
+//
+//	Interrupts must be disabled.
+//----------------------------------------------------------------------
+
+void
+Alarm::Add(Sleeper *sleeper)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(sleeper->when > kernel->stats->totalTicks);
+
+    if (numSleepers == 0) {
+	wheelTime = kernel->stats->totalTicks;	// nothing to catch up on
+    }
+    Insert(sleeper);
+    numSleepers++;
+    CheckTimer();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Cancel
+//	Take a sleeper off the timer wheel, if it hasn't been woken up
+//	yet.  Waking up the thread, if need be, is up to the caller.
+//
+//	Returns TRUE if it was still waiting.
+//----------------------------------------------------------------------
+
+bool
+Alarm::Cancel(Sleeper *sleeper)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (sleeper->link.list == NULL) {
+	return FALSE;			// already woken up
+    }
+    wheel[sleeper->level][sleeper->slot].Remove(sleeper);
+    levelCount[sleeper->level]--;
+    numSleepers--;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Insert
+//	Put a sleeper on the lowest wheel whose turn reaches its time.
+//	On wheel "level", each slot is 64^level ticks wide, and the
+//	slot it goes in is the one for its wake-up time; we only look
+//	at that slot once we get to the start of it.
+//
+//	Anyone due further off than the top wheel reaches goes in the
+//	top wheel's current slot, which comes round again after a full
+//	turn; then we look at it again.
+//----------------------------------------------------------------------
+
+void
+Alarm::Insert(Sleeper *sleeper)
+{
+    int delta = sleeper->when - wheelTime;
+    int level;
+
+    ASSERT(delta >= 0);
+    for (level = 0; level < WheelLevels; level++) {
+	if (delta < (1 << ((level + 1) * WheelBits))) {
+	    break;
+	}
+    }
+    if (level == WheelLevels) {			// too far off
+	level = WheelLevels - 1;
+	sleeper->slot = (wheelTime >> (level * WheelBits)) & (WheelSlots - 1);
+    } else {
+	sleeper->slot = (sleeper->when >> (level * WheelBits))
+							& (WheelSlots - 1);
+    }
+    sleeper->level = level;
+    wheel[level][sleeper->slot].Append(sleeper);
+    levelCount[level]++;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Cascade
+//	We have come to a new slot on wheel "level": move its sleepers
+//	down to the wheels below, now that they are close enough.
+//----------------------------------------------------------------------
+
+void
+Alarm::Cascade(int level)
+{
+    int slot = (wheelTime >> (level * WheelBits)) & (WheelSlots - 1);
+    IntrusiveList<Sleeper> moving;
+    Sleeper *sleeper;
+
+    while (!wheel[level][slot].IsEmpty()) {	// take them all off first,
+	moving.Append(wheel[level][slot].RemoveFront());
+	levelCount[level]--;			// since some may go back on
+    }
+    while (!moving.IsEmpty()) {
+	sleeper = moving.RemoveFront();
+	Insert(sleeper);
+    }
+}
+
+//----------------------------------------------------------------------
+// Alarm::Advance
+//	Step the wheels forward to "now", waking up everyone who is due.
+//	Stretches with nothing on the bottom wheel are skipped, up to
+//	the next time a higher wheel has to be cascaded.
+//----------------------------------------------------------------------
+
+void
+Alarm::Advance(int now)
+{
+    IntrusiveList<Sleeper> *due;
+    Sleeper *sleeper;
+    int level, skipTo;
+
+    while (wheelTime < now) {
+	if (numSleepers == 0) {
+	    wheelTime = now;
+	    break;
+	}
+	if (levelCount[0] == 0) {		// nothing to do this turn
+	    skipTo = wheelTime | (WheelSlots - 1);
+	    if (skipTo >= now) {
+		wheelTime = now;
+		break;
+	    }
+	    wheelTime = skipTo;
+	}
+	wheelTime++;
+
+	// cascade the top wheel first, since it may move sleepers
+	// into the current slot of the ones below
+	for (level = WheelLevels - 1; level > 0; level--) {
+	    if ((wheelTime & ((1 << (level * WheelBits)) - 1)) == 0) {
+		Cascade(level);
+	    }
+	}
+
+	due = &wheel[0][wheelTime & (WheelSlots - 1)];
+	while (!due->IsEmpty()) {
+	    sleeper = due->RemoveFront();
+	    ASSERT(sleeper->when == wheelTime);
+	    levelCount[0]--;
+	    numSleepers--;
+	    DEBUG(dbgThread, "Waking thread " << sleeper->thread->getName()
+				<< " at " << wheelTime);
+	    kernel->scheduler->ReadyToRun(sleeper->thread);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Alarm::NextDeadline
+//	Return when the next sleeper is due, or -1 if no one is asleep.
+//	On each wheel, the first slot we come to with anyone in it has
+//	that wheel's earliest sleepers; the answer is the earliest of those.
+//----------------------------------------------------------------------
+
+int
+Alarm::NextDeadline()
+{
+    IntrusiveList<Sleeper> *list;
+    Sleeper *sleeper;
+    int level, i, current;
+    int earliest = -1;
+
+    if (numSleepers == 0) {
+	return -1;
+    }
+    for (level = 0; level < WheelLevels; level++) {
+	if (levelCount[level] == 0) {
+	    continue;
+	}
+	current = wheelTime >> (level * WheelBits);
+	for (i = 1; i <= WheelSlots; i++) {
+	    list = &wheel[level][(current + i) & (WheelSlots - 1)];
+	    if (!list->IsEmpty()) {
+		break;
+	    }
+	}
+	for (sleeper = list->Front(); sleeper != NULL;
+					sleeper = sleeper->link.next) {
+	    if (earliest < 0 || sleeper->when < earliest) {
+		earliest = sleeper->when;
+	    }
+	}
+    }
+    return earliest;
 }
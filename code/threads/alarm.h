@@ -8,7 +8,22 @@
 //	From this, we provide the ability for a thread to be
 //	woken up after a delay; we also provide time-slicing.
 //
-//	NOTE: this abstraction is not completely implemented.
+//	Sleeping threads are kept on a "timer wheel": an array of slots,
+//	one per tick, which we step through as time goes by, waking up
+//	whoever is in each slot.  A single wheel would have to be huge
+//	to hold long sleeps, so there are several, each slot of one
+//	covering a whole turn of the one below.  When we come to a slot
+//	on a higher wheel, its sleepers are moved down to the wheels
+//	below.  Putting a sleeper on the wheel, or taking it off, takes
+//	constant time.
+//
+//	If nothing else is going on, the timer is set for when the next
+//	sleeper is due, so the machine can idle until then in one step.
+//
+//	In "tickless" mode, the timer only runs while there is some
+//	use for it: while another thread is waiting for the CPU.
+//	Otherwise it is stopped, so a lone thread is not interrupted
+//	for nothing.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -21,21 +36,63 @@
 #include "utility.h"
 #include "callback.h"
 #include "timer.h"
+#include "list.h"
+
+class Thread;
+
+const int WheelBits = 6;
+const int WheelSlots = 1 << WheelBits;	// slots on each wheel
+const int WheelLevels = 4;		// wheels, covering 2^24 ticks in all
+
+// The following class defines a thread waiting for the alarm clock.
+// It is usually on the sleeping thread's stack.
+
+class Sleeper {
+  public:
+    Thread *thread;		// who to wake up
+    int when;			// and when
+    int level, slot;		// where it is on the timer wheel
+    ListLink<Sleeper> link;	// on the list for that slot
+};
 
 // The following class defines a software alarm clock. 
 class Alarm : public CallBackObj {
   public:
-    Alarm(bool doRandomYield);	// Initialize the timer, and callback 
+    Alarm(bool doRandomYield, bool tickless = FALSE);
+				// Initialize the timer, and callback 
 				// to "toCall" every time slice.
     ~Alarm() { delete timer; }
     
     void WaitUntil(int x);	// suspend execution until time > now + x
-                                // this method is not yet implemented
+
+    void Add(Sleeper *sleeper);	// wake up sleeper->thread at sleeper->when
+    bool Cancel(Sleeper *sleeper);
+				// don't, if it hasn't happened yet
 	
-	void Disable() { timer->Disable(); } //2015.11.25
+	void Disable();		// stop the timer, unless someone is
+				// asleep; it starts again when needed
+
+    void CheckTimer();		// Start, stop or reset the timer
+				// depending on what it is needed for
 
   private:
     Timer *timer;		// the hardware timer device
+    bool tickless;		// only run the timer when it's needed?
+    bool disabled;		// stopped by Disable, until needed again
+
+    IntrusiveList<Sleeper> wheel[WheelLevels][WheelSlots];
+				// the sleeping threads
+    int levelCount[WheelLevels];// how many on each wheel
+    int numSleepers;		// how many in all
+    int wheelTime;		// the last tick we've woken threads for
+
+    bool TimerNeeded();		// is there anyone to time slice?
+    void Insert(Sleeper *sleeper);
+				// put a sleeper on the right wheel
+    void Cascade(int level);	// move the current slot of a wheel
+				// down to the wheels below
+    void Advance(int now);	// wake up everyone due by "now"
+    int NextDeadline();		// when is the next sleeper due?
 
     void CallBack();		// called when the hardware
 				// timer generates an interrupt
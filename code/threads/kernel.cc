@@ -15,8 +15,33 @@
 #include "libtest.h"
 #include "string.h"
 #include "synchdisk.h"
+#include "disktrace.h"
 #include "post.h"
+#include "transport.h"
+#include "fileservice.h"
+#include "diskmirror.h"
 #include "synchconsole.h"
+#include "imagecache.h"
+#include "profile.h"
+
+//----------------------------------------------------------------------
+// ParseCacheConfig
+// 	Read the geometry of a cache from the command line: its size,
+//	line size, associativity and miss penalty, following the flag
+//	at argv[i].  Returns the index of the last argument used.
+//----------------------------------------------------------------------
+
+static int
+ParseCacheConfig(int argc, char **argv, int i, CacheConfig *config)
+{
+    ASSERT(i + 4 < argc);
+    config->size = atoi(argv[i + 1]);
+    config->lineSize = atoi(argv[i + 2]);
+    config->ways = atoi(argv[i + 3]);
+    config->missPenalty = atoi(argv[i + 4]);
+    ASSERT(config->size > 0 && config->missPenalty >= 0);
+    return i + 4;
+}
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -27,7 +52,15 @@
 Kernel::Kernel(int argc, char **argv)
 {
     randomSlice = FALSE; 
+    ticklessTimer = FALSE;
     debugUserProg = FALSE;
+    numPhysPages = DefaultNumPhysPages;
+    pageSize = DefaultPageSize;
+    tlbEntries = 0;             // use the page table directly
+    tlbWays = 0;
+    tlbPolicy = TlbLRU;
+    statsFlag = FALSE;
+    profileInterval = 0;
     consoleIn = NULL;          // default is stdin
     consoleOut = NULL;         // default is stdout
 #ifndef FILESYS_STUB
@@ -36,9 +69,27 @@ Kernel::Kernel(int argc, char **argv)
     reliability = 1;            // network reliability, default is 1.0
     hostName = 0;               // machine id, also UNIX socket name
                                 // 0 is the default machine id
+    untimed = FALSE;            // devices take as long as they would
+    networkFlag = FALSE;        // no post office unless asked for
+    transportWindow = DefaultWindow;
+    fileClientNum = 0;
+    fileServerHost = -1;        // use the local file system
+    numDisks = 1;               // just DISK_<hostName>
+    stripeUnit = DefaultStripeUnit;
+    diskTraceFile = NULL;       // don't trace disk requests
+    mirrorHost = -1;            // no disk mirroring
+    mirrorSync = FALSE;
+    mirrorBalance = FALSE;
+    mirrorResync = -1;
+    mirrorPrimary = -1;
 								
-	// MP4 mod tag
-	execfileNum = 0; // dummy operation to keep valgrind happy
+    processes = new ProcessTable;
+    execfiles = new List<char *>;
+    maxJobs = -1;               // run all the -e programs at once
+    jobSlots = NULL;
+    jobsRunning = 0;
+    jobsDone = 0;
+    jobsStartTime = 0;
 								
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-rs") == 0) {
@@ -47,11 +98,57 @@ Kernel::Kernel(int argc, char **argv)
 			// number generator
 	    	randomSlice = TRUE;
 	    	i++;
+        } else if (strcmp(argv[i], "-tickless") == 0) {
+            ticklessTimer = TRUE;
+        } else if (strcmp(argv[i], "-untimed") == 0) {
+            untimed = TRUE;
         } else if (strcmp(argv[i], "-s") == 0) {
             debugUserProg = TRUE;
+        } else if (strcmp(argv[i], "-pages") == 0) {
+            ASSERT(i + 1 < argc);
+            numPhysPages = atoi(argv[i + 1]);
+            i++;
+        } else if (strcmp(argv[i], "-pagesize") == 0) {
+            ASSERT(i + 1 < argc);
+            pageSize = atoi(argv[i + 1]);
+            i++;
+        } else if (strcmp(argv[i], "-tlb") == 0) {
+            ASSERT(i + 3 < argc);   // entries, ways, policy
+            tlbEntries = atoi(argv[i + 1]);
+            tlbWays = atoi(argv[i + 2]);
+            ASSERT(tlbEntries > 0 && tlbWays > 0 && tlbWays <= tlbEntries
+                        && tlbEntries % tlbWays == 0);
+            if (strcmp(argv[i + 3], "lru") == 0) {
+                tlbPolicy = TlbLRU;
+            } else if (strcmp(argv[i + 3], "fifo") == 0) {
+                tlbPolicy = TlbFIFO;
+            } else {
+                ASSERT(strcmp(argv[i + 3], "random") == 0);
+                tlbPolicy = TlbRandom;
+            }
+            i += 3;
+        } else if (strcmp(argv[i], "-l1i") == 0) {
+            i = ParseCacheConfig(argc, argv, i, &l1iCache);
+        } else if (strcmp(argv[i], "-l1d") == 0) {
+            i = ParseCacheConfig(argc, argv, i, &l1dCache);
+        } else if (strcmp(argv[i], "-l2") == 0) {
+            i = ParseCacheConfig(argc, argv, i, &l2Cache);
+        } else if (strcmp(argv[i], "-stats") == 0) {
+            statsFlag = TRUE;
+        } else if (strcmp(argv[i], "-prof") == 0) {
+            ASSERT(i + 1 < argc);
+            profileInterval = atoi(argv[i + 1]);
+            ASSERT(profileInterval > 0);
+            i++;
 		} else if (strcmp(argv[i], "-e") == 0) {
-        	execfile[++execfileNum]= argv[++i];
-			cout << execfile[execfileNum] << "\n";
+	    	ASSERT(i + 1 < argc);
+        	execfiles->Append(argv[++i]);
+			cout << argv[i] << "\n";
+        } else if (strcmp(argv[i], "-jobs") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            maxJobs = atoi(argv[i + 1]);
+            ASSERT(maxJobs >= 0);
+            i++;
 		} else if (strcmp(argv[i], "-ci") == 0) {
 	    	ASSERT(i + 1 < argc);
 	    	consoleIn = argv[i + 1];
@@ -72,14 +169,76 @@ Kernel::Kernel(int argc, char **argv)
             ASSERT(i + 1 < argc);   // next argument is int
             hostName = atoi(argv[i + 1]);
             i++;
+        } else if (strcmp(argv[i], "-N") == 0) {
+            networkFlag = TRUE;
+        } else if (strcmp(argv[i], "-nw") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            transportWindow = atoi(argv[i + 1]);
+            ASSERT(transportWindow > 0);
+            i++;
+        } else if (strcmp(argv[i], "-fsrv") == 0) {
+            ASSERT(i + 1 < argc && fileClientNum < 10);
+            fileClients[fileClientNum++] = atoi(argv[i + 1]);
+            networkFlag = TRUE;
+            i++;
+        } else if (strcmp(argv[i], "-frem") == 0) {
+            ASSERT(i + 1 < argc);
+            fileServerHost = atoi(argv[i + 1]);
+            networkFlag = TRUE;
+            i++;
+        } else if (strcmp(argv[i], "-disks") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            numDisks = atoi(argv[i + 1]);
+            ASSERT(numDisks > 0 && numDisks <= MaxDisks);
+            i++;
+        } else if (strcmp(argv[i], "-stripe") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            stripeUnit = atoi(argv[i + 1]);
+            ASSERT(stripeUnit > 0);
+            i++;
+        } else if (strcmp(argv[i], "-dtrace") == 0) {
+            ASSERT(i + 1 < argc);
+            diskTraceFile = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "-dmirror") == 0) {
+            ASSERT(i + 1 < argc);
+            mirrorHost = atoi(argv[i + 1]);
+            networkFlag = TRUE;
+            i++;
+        } else if (strcmp(argv[i], "-dmsync") == 0) {
+            mirrorSync = TRUE;
+        } else if (strcmp(argv[i], "-dmbalance") == 0) {
+            mirrorBalance = TRUE;
+        } else if (strcmp(argv[i], "-dmresync") == 0) {
+            ASSERT(i + 1 < argc);   // 0 means the whole disk
+            mirrorResync = atoi(argv[i + 1]);
+            ASSERT(mirrorResync >= 0 && mirrorResync <= NumSectors);
+            if (mirrorResync == 0) {
+                mirrorResync = NumSectors;
+            }
+            i++;
+        } else if (strcmp(argv[i], "-dmserve") == 0) {
+            ASSERT(i + 1 < argc);
+            mirrorPrimary = atoi(argv[i + 1]);
+            networkFlag = TRUE;
+            i++;
         } else if (strcmp(argv[i], "-u") == 0) {
-            cout << "Partial usage: nachos [-rs randomSeed]\n";
+            cout << "Partial usage: nachos [-rs randomSeed] [-tickless] [-untimed]\n";
 	   		cout << "Partial usage: nachos [-s]\n";
+            cout << "Partial usage: nachos [-pages #] [-pagesize #]\n";
+            cout << "Partial usage: nachos [-tlb entries ways lru|fifo|random]\n";
+            cout << "Partial usage: nachos [-l1i|-l1d|-l2 size lineSize ways missPenalty] [-stats]\n";
+            cout << "Partial usage: nachos [-prof sampleInterval]\n";
+            cout << "Partial usage: nachos [-e userProgram]... [-jobs #]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
 #ifndef FILESYS_STUB
 	    	cout << "Partial usage: nachos [-nf]\n";
 #endif
-            cout << "Partial usage: nachos [-n #] [-m #]\n";
+            cout << "Partial usage: nachos [-n #] [-m #] [-nw #]\n";
+            cout << "Partial usage: nachos [-fsrv clientId] [-frem serverId]\n";
+            cout << "Partial usage: nachos [-disks #] [-stripe #] [-dtrace traceFile]\n";
+            cout << "Partial usage: nachos [-dmirror replicaId] [-dmsync] [-dmbalance] [-dmresync #]\n";
+            cout << "Partial usage: nachos [-dmserve primaryId]\n";
 		}
     }
 }
@@ -99,28 +258,77 @@ Kernel::Initialize()
     // object to save its state. 
 
 	
-    currentThread = new Thread("main", threadNum++);		
+    currentThread = new Thread("main", 0);
+    currentThread->setID(processes->Add(currentThread));
     currentThread->setStatus(RUNNING);
 
     stats = new Statistics();		// collect statistics
     interrupt = new Interrupt;		// start up interrupt handling
     scheduler = new Scheduler();	// initialize the ready queue
-    alarm = new Alarm(randomSlice);	// start up time slicing
-    machine = new Machine(debugUserProg);
+    alarm = new Alarm(randomSlice, ticklessTimer);
+					// start up time slicing
+    machine = new Machine(debugUserProg, numPhysPages, pageSize,
+				tlbEntries, tlbWays, tlbPolicy);
+    machine->SetUpCaches(&l1iCache, &l1dCache, &l2Cache);
+    profiler = NULL;
+    if (profileInterval > 0) {
+	profiler = new Profiler(profileInterval);
+    }
     synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
-    synchDisk = new SynchDisk();    //
+    diskTrace = NULL;
+    if (diskTraceFile != NULL) {	// before anything uses the disk
+	diskTrace = new DiskTrace(diskTraceFile, numDisks);
+    }
+    synchDisk = new SynchDisk(numDisks, stripeUnit);
+
+	// MP4 mod tag
+	// The network device polls forever, which would keep Nachos from
+	// ever halting, so only start the post office when it is wanted.
+	// It comes before the file system, so that the disk can be
+	// mirrored before the file system touches it.
+    postOfficeIn = NULL;
+    postOfficeOut = NULL;
+    fileServer = NULL;
+    remoteFileSystem = NULL;
+    diskMirror = NULL;
+    diskMirrorServer = NULL;
+    if (networkFlag) {
+	postOfficeIn = new PostOfficeInput(max(FileServiceMailBoxes,
+						DiskMirrorBox + 1));
+	postOfficeOut = new PostOfficeOutput(reliability);
+    }
+    if (mirrorPrimary >= 0) {
+	diskMirrorServer = new DiskMirrorServer(postOfficeIn, postOfficeOut,
+						mirrorPrimary);
+    }
+    if (mirrorHost >= 0) {
+	diskMirror = new DiskMirror(postOfficeIn, postOfficeOut, mirrorHost,
+					mirrorSync, mirrorBalance);
+	if (mirrorResync > 0) {
+	    diskMirror->Resync(mirrorResync);
+	}
+	synchDisk->SetMirror(diskMirror);
+    }
+
 #ifdef FILESYS_STUB
+    imageCache = NULL;
     fileSystem = new FileSystem();
 #else
+    imageCache = new ImageCache();	// before formatting writes to files
     fileSystem = new FileSystem(formatFlag);
 #endif // FILESYS_STUB
 
-	// MP4 mod tag
-    /*
-	postOfficeIn = new PostOfficeInput(10);
-    postOfficeOut = new PostOfficeOutput(reliability);
-	*/
+    if (fileClientNum > 0) {
+	fileServer = new FileServer(postOfficeIn, postOfficeOut);
+	for (int i = 0; i < fileClientNum; i++) {
+	    fileServer->AddClient(fileClients[i]);
+	}
+    }
+    if (fileServerHost >= 0) {
+	remoteFileSystem = new RemoteFileSystem(postOfficeIn, postOfficeOut,
+						fileServerHost);
+    }
 
     interrupt->Enable();
 }
@@ -146,6 +354,34 @@ Kernel::PrepareToEnd()
 
 Kernel::~Kernel()
 {
+    if (statsFlag) {
+	stats->Print();
+	machine->PrintCaches();
+    }
+    if (profiler != NULL) {
+	profiler->Print();
+	delete profiler;
+    }
+    delete diskTrace;			// anything after this isn't traced
+    diskTrace = NULL;
+	// Mp4 mod tag
+	// the network devices detach from the interrupt simulation,
+	// so they have to go first
+    delete remoteFileSystem;
+    delete fileServer;
+    synchDisk->SetMirror(NULL);
+    delete diskMirror;
+    delete diskMirrorServer;
+    if (postOfficeIn != NULL) {
+	delete postOfficeIn;
+	delete postOfficeOut;
+    }
+	// closing files writes them back and takes locks, so the disk,
+	// the scheduler and the interrupt simulation must still be here
+#ifndef FILESYS_STUB
+    delete imageCache;
+#endif
+    delete fileSystem;
     delete stats;
     delete interrupt;
     delete scheduler;
@@ -154,13 +390,9 @@ Kernel::~Kernel()
     delete synchConsoleIn;
     delete synchConsoleOut;
     delete synchDisk;
-    delete fileSystem;
-	
-	// Mp4 mod tag
-	/*
-    delete postOfficeIn;
-    delete postOfficeOut;
-    */
+    delete processes;
+    delete execfiles;
+    delete jobSlots;
 	
     Exit(0);
 }
@@ -168,12 +400,30 @@ Kernel::~Kernel()
 //----------------------------------------------------------------------
 // Kernel::ThreadSelfTest
 //      Test threads, semaphores, synchlists
+//
+//	Then measure how fast a producer and a consumer can hand items
+//	back and forth through a pair of synchlists, so that every item
+//	blocks one thread and wakes up the other.
 //----------------------------------------------------------------------
 
+static const int SynchListTestItems = 10000;
+static SynchList<int> *producerList;	// items for the consumer
+static SynchList<int> *consumerList;	// items handed back
+
+static void
+SynchListConsumer(void *data)
+{
+    for (int i = 0; i < SynchListTestItems; i++) {
+	consumerList->Append(producerList->RemoveFront());
+    }
+}
+
 void
 Kernel::ThreadSelfTest() {
    Semaphore *semaphore;
    SynchList<int> *synchList;
+   Thread *consumer;
+   double start, elapsed;
    
    LibSelfTest();		// test library routines
    
@@ -190,6 +440,21 @@ Kernel::ThreadSelfTest() {
    synchList->SelfTest(9);
    delete synchList;
 
+				// measure producer/consumer throughput
+   producerList = new SynchList<int>;
+   consumerList = new SynchList<int>;
+   consumer = new Thread("consumer", 1);
+   start = HostSeconds();
+   consumer->Fork(SynchListConsumer, NULL);
+   for (int i = 0; i < SynchListTestItems; i++) {
+       producerList->Append(i);
+       ASSERT(consumerList->RemoveFront() == i);
+   }
+   elapsed = HostSeconds() - start;
+   cout << "SynchList handoff: " << SynchListTestItems << " items in "
+	<< (int)(elapsed * 1000000) << " usec\n";
+   delete producerList;
+   delete consumerList;
 }
 
 //----------------------------------------------------------------------
@@ -225,9 +490,17 @@ Kernel::ConsoleTest() {
 //      4. wait for an acknowledgement from the other machine to our 
 //          original message
 //
+//  Then measure goodput over the reliable transport: machine #0 streams
+//  multi-fragment messages to machine #1, which checks every byte.
+//  Run both machines with "-n 0.9" to see the cost of 10% packet loss,
+//  and with "-nw #" to try different window sizes.
+//
 //  This test works best if each Nachos machine has its own window
 //----------------------------------------------------------------------
 
+static const int TransportTestMessages = 50;
+static const int TransportTestSize = 200;
+
 void
 Kernel::NetworkTest() {
 
@@ -269,6 +542,44 @@ Kernel::NetworkTest() {
         cout << "Got: " << buffer << " : from " << inPktHdr.from << ", box " 
                                                 << inMailHdr.from << "\n";
         cout.flush();
+
+        // Both machines talk over mailbox #2; the transport's worker
+        // threads run forever, so it is never deallocated.
+        ReliableTransport *transport = new ReliableTransport(postOfficeIn,
+                        postOfficeOut, 2, farHost, 2, transportWindow);
+        char message[TransportTestSize];
+        int i, j;
+
+        if (hostName == 0) {
+            int start = stats->totalTicks;
+            int bytes = TransportTestMessages * TransportTestSize;
+            int elapsed;
+
+            for (i = 0; i < TransportTestMessages; i++) {
+                for (j = 0; j < TransportTestSize; j++) {
+                    message[j] = (char)(i + j);
+                }
+                transport->Send(message, TransportTestSize);
+            }
+            transport->Flush();
+            elapsed = stats->totalTicks - start;
+            cout << "Transport sent " << bytes << " bytes in " << elapsed
+                 << " ticks, goodput " << (bytes * 1000) / elapsed
+                 << " bytes per 1000 ticks\n";
+        } else {
+            for (i = 0; i < TransportTestMessages; i++) {
+                ASSERT(transport->Receive(message, TransportTestSize)
+                                == TransportTestSize);
+                for (j = 0; j < TransportTestSize; j++) {
+                    ASSERT(message[j] == (char)(i + j));
+                }
+            }
+            cout << "Transport received " << TransportTestMessages
+                 << " messages intact\n";
+        }
+        transport->Print();
+        postOfficeIn->Print();
+        cout.flush();
     }
 
     // Then we're done!
@@ -284,24 +595,49 @@ void ForkExecute(Thread *t)
 
 }
 
+//----------------------------------------------------------------------
+// Kernel::ExecAll
+// 	Run the user programs given with -e, in order.  At most
+//	"maxJobs" of them run at once (all of them, if it is 0 or -jobs
+//	wasn't given); when one exits, the next one is started.  Once
+//	they have all been started, the main thread is done.
+//
+//	Each job has memory of its own; one that doesn't fit in what the
+//	running jobs have left over is not run.
+//----------------------------------------------------------------------
+
 void Kernel::ExecAll()
 {
-	for (int i=1;i<=execfileNum;i++) {
-		int a = Exec(execfile[i]);
+	int numJobs = execfiles->NumInList();
+
+	jobSlots = new Semaphore("job slots",
+				(maxJobs > 0) ? min(maxJobs, numJobs) : numJobs);
+	jobsStartTime = stats->totalTicks;
+	while (!execfiles->IsEmpty()) {
+		jobSlots->P();		// wait for a job to exit, if need be
+		Exec(execfiles->RemoveFront());
+		jobsRunning++;
 	}
 	currentThread->Finish();
-    //Kernel::Exec();	
 }
 
+//----------------------------------------------------------------------
+// Kernel::Exec
+// 	Start running a user program in a new process.
+//
+//	Returns the new process's id.
+//----------------------------------------------------------------------
 
 int Kernel::Exec(char* name)
 {
-	t[threadNum] = new Thread(name, threadNum);
-	t[threadNum]->space = new AddrSpace();
-	t[threadNum]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[threadNum]);
-	threadNum++;
+	Thread *t = new Thread(name, 0);
 
-	return threadNum-1;
+	t->setID(processes->Add(t));
+	t->space = new AddrSpace();
+	t->Fork((VoidFunctionPtr) &ForkExecute, (void *)t);
+	DEBUG(dbgThread, "Started process " << t->getID() << ": " << name);
+
+	return t->getID();
 /*
     cout << "Total threads number is " << execfileNum << endl;
     for (int n=1;n<=execfileNum;n++) {
@@ -329,6 +665,35 @@ int Kernel::Exec(char* name)
 //  cout << "after ThreadedKernel:Run();" << endl;  // unreachable
 }
 
+//----------------------------------------------------------------------
+// Kernel::ProcessExit
+// 	Called by a thread when it finishes.  If it is a process, free
+//	its process id; if it is one of our -e jobs, let the next one
+//	start.  If -jobs was given, print how long they all took when
+//	the last one exits.
+//----------------------------------------------------------------------
+
+void Kernel::ProcessExit(Thread *thread)
+{
+	int elapsed;
+
+	if (processes->Get(thread->getID()) != thread) {
+		return;			// just a kernel thread
+	}
+	processes->Remove(thread->getID());
+	if (thread->space == NULL || jobSlots == NULL) {
+		return;			// the main thread
+	}
+	jobsRunning--;
+	jobsDone++;
+	if (maxJobs >= 0 && execfiles->IsEmpty() && jobsRunning == 0) {
+		elapsed = stats->totalTicks - jobsStartTime;
+		cout << "Ran " << jobsDone << " jobs in " << elapsed
+		     << " ticks, " << elapsed / jobsDone << " ticks per job\n";
+	}
+	jobSlots->V();
+}
+
 #ifdef FILESYS_STUB
 int Kernel::CreateFile(char *filename)
 {
@@ -339,6 +704,8 @@ int Kernel::CreateFile(char *filename)
 #ifndef FILESYS_STUB
 int Kernel::CreateFile(char *filename, int initSize)
 {
+    if (remoteFileSystem != NULL)
+      return remoteFileSystem->Create(filename,initSize);
     return fileSystem->Create(filename,initSize);
 }
 //---------------------------------
@@ -347,6 +714,9 @@ int Kernel::CreateFile(char *filename, int initSize)
 //---------------------------------
 int Kernel::Open(char *filename)
 {
+    if (remoteFileSystem != NULL)
+      return remoteFileSystem->Open(filename);
+
     OpenFile *opFile = fileSystem->Open(filename);
 
     if(opFile){
@@ -361,26 +731,43 @@ int Kernel::Open(char *filename)
 
 int Kernel::CloseFile(int fd)
 {
+    if (remoteFileSystem != NULL)
+      return remoteFileSystem->Close(fd);
     return fileSystem->Close(fd);
 }
 
+int Kernel::SyncFile(int fd)
+{
+    if (remoteFileSystem != NULL)
+      return 1;				// writes go straight to the server
+    return fileSystem->Sync(fd);
+}
+
 int Kernel::ReadFile(char *buf, int size, int fd)
 {
+    if (remoteFileSystem != NULL)
+      return remoteFileSystem->Read(buf,size,fd);
     return fileSystem->Read(buf,size,fd);
 }
 
 int Kernel::WriteFile(char *buf, int size, int fd)
 {
+    if (remoteFileSystem != NULL)
+      return remoteFileSystem->Write(buf,size,fd);
     return fileSystem->Write(buf,size,fd);
 }
 
 int Kernel::SeekFile(int position, int fd)
 {
+    if (remoteFileSystem != NULL)
+      return remoteFileSystem->Seek(position,fd);
     return fileSystem->Seek(position,fd);
 }
 
 int Kernel::RemoveFile(char *filename)
 {
+    if (remoteFileSystem != NULL)
+      return remoteFileSystem->Remove(filename);
     return fileSystem->Remove(filename);
 }
 
@@ -16,14 +16,24 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "alarm.h"
+#include "proctable.h"
+#include "list.h"
 #include "filesys.h"
 #include "machine.h"
 
 class PostOfficeInput;
 class PostOfficeOutput;
+class FileServer;
+class RemoteFileSystem;
+class DiskMirror;
+class DiskMirrorServer;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class Semaphore;
+class ImageCache;
+class Profiler;
+class DiskTrace;
 
 
 
@@ -40,13 +50,15 @@ class Kernel {
 	// 2015.11.25 added
 	void PrepareToEnd(); // called before all running programs end
 	
-	void ExecAll();
-	int Exec(char* name);
+	void ExecAll();		// run the -e programs, -jobs at a time
+	int Exec(char* name);	// start a user program; returns its pid
+	void ProcessExit(Thread *thread);
+				// called when a thread finishes
     void ThreadSelfTest();	// self test of threads and synchronization
 	
     void ConsoleTest();         // interactive console self test
     void NetworkTest();         // interactive 2-machine network test
-	Thread* getThread(int threadID){return t[threadID];}    
+	Thread* getThread(int threadID){return processes->Get(threadID);}
 
 	#ifdef FILESYS_STUB	
 	int CreateFile(char* filename); // fileSystem call
@@ -60,6 +72,7 @@ class Kernel {
     int ReadFile(char *buf, int size, int fd);
     int RemoveFile(char* filename);
     int SeekFile(int position,int fd);
+    int SyncFile(int fd);
     #endif
 // These are public for notational convenience; really, 
 // they're global variables used everywhere.
@@ -73,21 +86,63 @@ class Kernel {
     SynchConsoleInput *synchConsoleIn;
     SynchConsoleOutput *synchConsoleOut;
     SynchDisk *synchDisk;
+    DiskTrace *diskTrace;	// records disk requests (-dtrace), or NULL
     FileSystem *fileSystem;     
+    ImageCache *imageCache;	// executables kept in memory
+    Profiler *profiler;		// profiles user programs, or NULL
     PostOfficeInput *postOfficeIn;
     PostOfficeOutput *postOfficeOut;
+    FileServer *fileServer;	// exports fileSystem to other machines
+    RemoteFileSystem *remoteFileSystem;
+				// if not NULL, file system calls go to
+				// another machine's file server
+    DiskMirror *diskMirror;	// copies our disk writes to a replica
+    DiskMirrorServer *diskMirrorServer;
+				// keeps our disk as another machine's replica
 
     int hostName;               // machine identifier
+    bool untimed;               // devices finish at once, taking no
+                                // simulated time (-untimed)
 
   private:
 
-	Thread* t[10];
-	char*   execfile[10];
-	int execfileNum;
-	int threadNum;
+    ProcessTable *processes;	// the user programs, by pid
+    List<char *> *execfiles;	// programs still to be run (-e)
+    int maxJobs;		// how many to run at once (-jobs), or
+				// 0 for all of them; -1 (all of them)
+				// if -jobs wasn't given
+    Semaphore *jobSlots;	// one for each job that may start now
+    int jobsRunning;		// how many have started, and not exited
+    int jobsDone;		// how many have exited
+    int jobsStartTime;		// when the first was started
     bool randomSlice;		// enable pseudo-random time slicing
+    bool ticklessTimer;		// only run the timer when needed (-tickless)
     bool debugUserProg;         // single step user program
+    int numPhysPages;           // size of user memory (-pages)
+    int pageSize;               // and of a page (-pagesize)
+    int tlbEntries;             // TLB geometry (-tlb), or 0 for no TLB
+    int tlbWays;
+    TlbPolicy tlbPolicy;
+    CacheConfig l1iCache;       // simulated caches (-l1i, -l1d, -l2)
+    CacheConfig l1dCache;
+    CacheConfig l2Cache;
+    bool statsFlag;             // print statistics when we halt (-stats)
+    int profileInterval;        // ticks between PC samples (-prof), or
+                                // 0 to not profile
     double reliability;         // likelihood messages are dropped
+    bool networkFlag;           // start the post office (-N)
+    int transportWindow;        // fragments in flight in NetworkTest
+    int fileClients[10];        // machines to serve files to (-fsrv)
+    int fileClientNum;
+    int fileServerHost;         // machine to get files from (-frem), or -1
+    int mirrorHost;             // machine to mirror our disk on (-dmirror)
+    bool mirrorSync;            // wait for the replica on each write (-dmsync)
+    bool mirrorBalance;         // spread reads over both disks (-dmbalance)
+    int mirrorResync;           // sectors to resync at startup (-dmresync)
+    int mirrorPrimary;          // machine whose disk we mirror (-dmserve)
+    int numDisks;               // disks to stripe the volume over (-disks)
+    int stripeUnit;             // sectors per disk per stripe (-stripe)
+    char *diskTraceFile;        // where to record disk requests (-dtrace)
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
 #ifndef FILESYS_STUB
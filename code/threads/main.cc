@@ -11,16 +11,35 @@
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -tickless stops the timer while only one thread can run
+//    -untimed makes the disk, console output and network sends finish
+//	as soon as they start, with no interrupt; for bulk file system
+//	work (-f, -cp, -rr) where only the disk contents matter
+//    -dtrace records every disk request in a UNIX file, to be replayed
+//	with other disk models by disktrace/replay
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
+//    -pages, -pagesize set how many pages of physical memory there are,
+//	and how many bytes in a page (a power of 2)
+//    -tlb runs user programs with a TLB of the given geometry and
+//	replacement policy, instead of the page table
+//    -l1i, -l1d, -l2 simulate an L1 instruction, L1 data or L2 cache,
+//	of the given size, line size, associativity and miss penalty
+//    -stats prints performance statistics when Nachos halts
+//    -prof profiles user programs, sampling the PC every so many ticks,
+//	and prints the instruction mix and a flat profile when Nachos halts
 //    -x runs a user program
+//    -e runs a user program; give it more than once to run several
+//    -jobs limits how many of the -e programs run at the same time,
+//	and prints how long they took
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
-//    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -N run a two-machine network test (see Kernel::NetworkTest),
+//	over the reliable transport; -nw sets its window
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -29,6 +48,9 @@
 //    -r removes a Nachos file from the file system
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system 
+//    -fst measures the file system under concurrent use by kernel threads
+//    -fsw runs the file system workload described in a UNIX file, and
+//	reports how it performed (see filesys/workload.h)
 //
 //  Note: the file system flags are not used if the stub filesystem
 //        is being used
@@ -43,7 +65,9 @@
 
 #include "main.h"
 #include "filesys.h"
+#include "synchdisk.h"
 #include "openfile.h"
+#include "workload.h"
 #include "sysdep.h"
 
 // global variables
@@ -169,6 +193,107 @@ static char* TransferName(char * name){
     return transferName;
 }
 
+#ifndef FILESYS_STUB
+//----------------------------------------------------------------------
+// StressFileSystem
+//      Measure how well the file system handles concurrent use: start
+//	"numThreads" kernel threads that each repeatedly read a shared
+//	file, and create, write, read back and remove a file of their
+//	own.  Report how long (in simulated time) they take together,
+//	and the throughput of their reads and writes.  Running it with
+//	-disks 1, 2, 4, ... shows how throughput grows with the number
+//	of disks the volume is striped over.
+//
+//	The root directory only has room for a few files, so keep
+//	"numThreads" small.
+//----------------------------------------------------------------------
+
+static const int StressFileSize = 1024;
+static const int StressRounds = 10;
+static const char *StressSharedName = "/stress";
+static Semaphore *stressDone;
+static int stressOps, stressFailures, stressBytes;
+
+static void
+StressWorker(void *arg)
+{
+    int id = (int)(long)arg;
+    char name[16], *buffer = new char[StressFileSize];
+    OpenFile *openFile;
+
+    sprintf(name, "/stress%d", id);
+    for (int round = 0; round < StressRounds; round++) {
+	openFile = kernel->fileSystem->Open((char *)StressSharedName);
+	if (openFile == NULL ||
+		openFile->ReadAt(buffer, StressFileSize, 0) != StressFileSize
+		|| buffer[StressFileSize - 1] != (char)(StressFileSize - 1)) {
+	    stressFailures++;
+	}
+	delete openFile;
+
+	if (!kernel->fileSystem->Create(name, StressFileSize) ||
+		(openFile = kernel->fileSystem->Open(name)) == NULL) {
+	    stressFailures++;
+	    continue;
+	}
+	memset(buffer, id + round, StressFileSize);
+	openFile->WriteAt(buffer, StressFileSize, 0);
+	buffer[0] = 0;
+	openFile->ReadAt(buffer, StressFileSize, 0);
+	if (buffer[0] != (char)(id + round)) {
+	    stressFailures++;
+	}
+	delete openFile;
+	if (!kernel->fileSystem->Remove(name)) {
+	    stressFailures++;
+	}
+	stressOps += 6;
+	stressBytes += 3 * StressFileSize;	// read, write, read back
+    }
+    delete [] buffer;
+    stressDone->V();
+}
+
+static void
+StressFileSystem(int numThreads)
+{
+    char *buffer = new char[StressFileSize];
+    OpenFile *openFile;
+    int start, elapsed;
+
+    for (int i = 0; i < StressFileSize; i++) {
+	buffer[i] = (char)i;
+    }
+    kernel->fileSystem->Create((char *)StressSharedName, StressFileSize);
+    openFile = kernel->fileSystem->Open((char *)StressSharedName);
+    ASSERT(openFile != NULL);
+    openFile->WriteAt(buffer, StressFileSize, 0);
+    delete openFile;
+    delete [] buffer;
+
+    stressDone = new Semaphore("stress done", 0);
+    stressOps = stressFailures = stressBytes = 0;
+    start = kernel->stats->totalTicks;
+    for (int i = 0; i < numThreads; i++) {
+	Thread *t = new Thread("stress", 1);
+	t->Fork(StressWorker, (void *)(long)i);
+    }
+    for (int i = 0; i < numThreads; i++) {
+	stressDone->P();
+    }
+    elapsed = kernel->stats->totalTicks - start;
+    cout << "File system stress: " << numThreads << " threads, "
+	<< kernel->synchDisk->NumDisks() << " disks, "
+	<< stressOps << " operations in " << elapsed << " ticks, "
+	<< stressFailures << " failures\n";
+    cout << "Throughput: " << stressBytes << " bytes, "
+	<< (elapsed > 0 ? stressBytes * 1000.0 / elapsed : 0)
+	<< " bytes per 1000 ticks\n";
+    kernel->fileSystem->Remove((char *)StressSharedName);
+    delete stressDone;
+}
+#endif // FILESYS_STUB
+
 
 //----------------------------------------------------------------------
 // main
@@ -206,6 +331,8 @@ main(int argc, char **argv)
 	bool mkdirFlag = false;
 	bool recursiveListFlag = false;
 	bool recursiveRemoveFlag = false;
+	int stressThreads = 0;
+	char *workloadSpec = NULL;
 #endif //FILESYS_STUB
 
     // some command line arguments are handled here.
@@ -291,15 +418,27 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-D") == 0) {
 	    dumpFlag = true;
 	}
+	else if (strcmp(argv[i], "-fst") == 0) {
+	    ASSERT(i + 1 < argc);
+	    stressThreads = atoi(argv[i + 1]);
+	    ASSERT(stressThreads > 0);
+	    i++;
+	}
+	else if (strcmp(argv[i], "-fsw") == 0) {
+	    ASSERT(i + 1 < argc);
+	    workloadSpec = argv[i + 1];
+	    i++;
+	}
 #endif //FILESYS_STUB
 	else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
-	    cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+	    cout << "Partial usage: nachos [-K] [-C] [-N [-nw window]]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
             cout << "Partial usage: nachos [-l] [-D]\n";
+            cout << "Partial usage: nachos [-fst numThreads] [-fsw workloadSpec]\n";
 #endif //FILESYS_STUB
 	}
 
@@ -335,6 +474,7 @@ main(int argc, char **argv)
     }
     if (dumpFlag) {
 		kernel->fileSystem->Print();
+		kernel->synchDisk->Print();
     }
     if (dirListFlag) {
 		kernel->fileSystem->List(listDirectoryName,recursiveListFlag);
@@ -347,6 +487,16 @@ main(int argc, char **argv)
     if (printFileName != NULL) {
       Print(printFileName);
     }
+    if (stressThreads > 0) {
+      StressFileSystem(stressThreads);
+    }
+    if (workloadSpec != NULL) {
+      Workload *workload = new Workload;
+      if (workload->Load(workloadSpec)) {
+        workload->Run();
+      }
+      delete workload;
+    }
 #endif // FILESYS_STUB
 
     // finally, run an initial user program if requested to do so
@@ -0,0 +1,145 @@
+// proctable.cc
+//	Routines to manage the table of processes.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "proctable.h"
+#include "thread.h"
+#include "debug.h"
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize an empty process table.
+//
+//	"initialSize" -- how many ids to start with; more are added
+//		as needed
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable(int initialSize)
+{
+    ASSERT(initialSize > 0);
+    size = 0;
+    table = NULL;
+    nextFree = NULL;
+    firstFree = -1;
+    numInUse = 0;
+    while (size < initialSize) {
+	Grow();
+    }
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::~ProcessTable
+// 	De-allocate the process table.  The threads in it are not ours
+//	to delete.
+//----------------------------------------------------------------------
+
+ProcessTable::~ProcessTable()
+{
+    delete [] table;
+    delete [] nextFree;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Grow
+// 	Double the number of ids, and put the new ones on the free
+//	list, lowest first.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Grow()
+{
+    int newSize = (size == 0) ? 1 : size * 2;
+    Thread **newTable = new Thread *[newSize];
+    int *newNext = new int[newSize];
+    int i;
+
+    for (i = 0; i < size; i++) {
+	newTable[i] = table[i];
+	newNext[i] = nextFree[i];
+    }
+    for (i = newSize - 1; i >= size; i--) {	// all free, so they
+	newTable[i] = NULL;			// go on the front of
+	newNext[i] = firstFree;			// the free list
+	firstFree = i;
+    }
+    delete [] table;
+    delete [] nextFree;
+    table = newTable;
+    nextFree = newNext;
+    DEBUG(dbgThread, "Process table grown from " << size << " to " << newSize);
+    size = newSize;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Add
+// 	Give a thread a process id: the one most recently freed, if
+//	there is one.
+//
+//	Returns the process id.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::Add(Thread *thread)
+{
+    int pid;
+
+    ASSERT(thread != NULL);
+    if (firstFree < 0) {
+	Grow();
+    }
+    pid = firstFree;
+    firstFree = nextFree[pid];
+    table[pid] = thread;
+    numInUse++;
+    return pid;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Remove
+// 	Free a process id, so it can be given to another process.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Remove(int pid)
+{
+    ASSERT(pid >= 0 && pid < size && table[pid] != NULL);
+    table[pid] = NULL;
+    nextFree[pid] = firstFree;
+    firstFree = pid;
+    numInUse--;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Get
+// 	Return the thread with process id "pid", or NULL if there is
+//	no such process.
+//----------------------------------------------------------------------
+
+Thread *
+ProcessTable::Get(int pid)
+{
+    if (pid < 0 || pid >= size) {
+	return NULL;
+    }
+    return table[pid];
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Print
+// 	Print the processes in the table, for debugging.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Print()
+{
+    cout << "Process table: " << numInUse << " of " << size << " ids in use\n";
+    for (int pid = 0; pid < size; pid++) {
+	if (table[pid] != NULL) {
+	    cout << "  " << pid << ": " << table[pid]->getName() << "\n";
+	}
+    }
+}
@@ -0,0 +1,50 @@
+// proctable.h
+//	Data structures for keeping track of the processes (user
+//	programs) that are running.
+//
+//	Each process has a process id, which is its slot in the table,
+//	so finding a process from its id takes constant time.  When a
+//	process exits its slot is put on a free list, and handed out
+//	again to the next process.  The table doubles in size when it
+//	runs out of slots, so there is no limit on how many processes
+//	there can be.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROCTABLE_H
+#define PROCTABLE_H
+
+#include "copyright.h"
+
+class Thread;
+
+// The following class defines a table of processes, indexed by
+// process id.
+
+class ProcessTable {
+  public:
+    ProcessTable(int initialSize = 16);
+				// initialize an empty table
+    ~ProcessTable();		// de-allocate the table
+
+    int Add(Thread *thread);	// give "thread" a process id
+    void Remove(int pid);	// free the process id
+    Thread *Get(int pid);	// who has this id, or NULL
+
+    int NumInUse() { return numInUse; }
+				// how many processes there are
+    void Print();		// print the processes in the table
+
+  private:
+    Thread **table;		// the thread for each id, or NULL
+    int *nextFree;		// for free ids, the next free one
+    int size;			// how many ids there are so far
+    int firstFree;		// the first free id, or -1
+    int numInUse;		// how many ids are taken
+
+    void Grow();		// double the size of the table
+};
+
+#endif // PROCTABLE_H
@@ -14,6 +14,13 @@
 // 	Very simple implementation -- no priorities, straight FIFO.
 //	Might need to be improved in later assignments.
 //
+//	The user state of a thread -- its user registers and address
+//	space -- is loaded into the machine lazily.  It stays there
+//	while the thread is switched out, and is only saved when some
+//	other user thread needs the machine.  So switching to a kernel
+//	thread and back, or between threads sharing an address space,
+//	doesn't reload what the machine already has.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -31,8 +38,10 @@
 
 Scheduler::Scheduler()
 { 
-    readyList = new List<Thread *>; 
+    readyList = new IntrusiveList<Thread>; 
     toBeDestroyed = NULL;
+    registerOwner = NULL;
+    installedSpace = NULL;
 } 
 
 //----------------------------------------------------------------------
@@ -61,6 +70,7 @@ Scheduler::ReadyToRun (Thread *thread)
 	//cout << "Putting thread on ready list: " << thread->getName() << endl ;
     thread->setStatus(READY);
     readyList->Append(thread);
+    kernel->alarm->CheckTimer();	// there may be someone to time slice
 }
 
 //----------------------------------------------------------------------
@@ -112,11 +122,6 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 	 toBeDestroyed = oldThread;
     }
     
-    if (oldThread->space != NULL) {	// if this thread is a user program,
-        oldThread->SaveUserState(); 	// save the user's CPU registers
-	oldThread->space->SaveState();
-    }
-    
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
@@ -124,6 +129,7 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     nextThread->setStatus(RUNNING);      // nextThread is now running
     
     DEBUG(dbgThread, "Switching from: " << oldThread->getName() << " to: " << nextThread->getName());
+    kernel->stats->numContextSwitches++;
     
     // This is a machine-dependent assembly language routine defined 
     // in switch.s.  You may have to think
@@ -144,8 +150,51 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 					// and needs to be cleaned up
     
     if (oldThread->space != NULL) {	    // if there is an address space
-        oldThread->RestoreUserState();     // to restore, do it.
-	oldThread->space->RestoreState();
+	LoadUserState(oldThread);	    // to restore, do it.
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::LoadUserState
+// 	Make sure the machine has "thread"'s user registers and address
+//	space, saving those of the thread that had it, if need be.
+//	Anything the machine already has is left alone.
+//----------------------------------------------------------------------
+
+void
+Scheduler::LoadUserState(Thread *thread)
+{
+    ASSERT(thread->space != NULL);
+
+    if (registerOwner != thread) {
+	if (registerOwner != NULL) {
+	    registerOwner->SaveUserState();
+	}
+	thread->RestoreUserState();
+	registerOwner = thread;
+	kernel->stats->numRegisterLoads++;
+    }
+    if (installedSpace != thread->space) {
+	if (installedSpace != NULL) {
+	    installedSpace->SaveState();
+	}
+	thread->space->RestoreState();
+	installedSpace = thread->space;
+	kernel->stats->numAddrSpaceLoads++;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SpaceDeleted
+// 	Forget that the machine has "space", since it is being deleted;
+//	another one could be allocated in its place.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SpaceDeleted(AddrSpace *space)
+{
+    if (installedSpace == space) {
+	installedSpace = NULL;
     }
 }
 
@@ -161,6 +210,9 @@ void
 Scheduler::CheckToBeDestroyed()
 {
     if (toBeDestroyed != NULL) {
+	if (registerOwner == toBeDestroyed) {	// no need to save them
+	    registerOwner = NULL;
+	}
         delete toBeDestroyed;
 	toBeDestroyed = NULL;
     }
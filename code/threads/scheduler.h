@@ -30,15 +30,26 @@ class Scheduler {
     				// Cause nextThread to start running
     void CheckToBeDestroyed();// Check if thread that had been
     				// running needs to be deleted
+    void LoadUserState(Thread *thread);
+    				// Get the machine ready to run a
+				// thread's user program
+    void SpaceDeleted(AddrSpace *space);
+    				// An address space is going away
+    int NumReady() { return readyList->NumInList(); }
+				// How many threads are waiting to run?
     void Print();		// Print contents of ready list
     
     // SelfTest for scheduler is implemented in class Thread
     
   private:
-    List<Thread *> *readyList;  // queue of threads that are ready to run,
+    IntrusiveList<Thread> *readyList;
+				// queue of threads that are ready to run,
 				// but not running
     Thread *toBeDestroyed;	// finishing thread to be destroyed
     				// by the next thread that runs
+    Thread *registerOwner;	// whose user registers are in the
+				// machine, or NULL
+    AddrSpace *installedSpace;	// whose translation the machine has
 };
 
 #endif // SCHEDULER_H
@@ -25,8 +25,9 @@
 // whether the lock is held or not -- a semaphore value of 0 means
 // the lock is busy; a semaphore value of 1 means the lock is free.
 //
-// The implementation of condition variables using semaphores is
-// a bit trickier, as explained below under Condition::Wait.
+// Condition variables, on the other hand, put the waiting threads
+// straight on a queue, rather than allocating a semaphore for each
+// one; see Condition::Wait.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -48,7 +49,6 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List<Thread *>;
 }
 
 //----------------------------------------------------------------------
@@ -59,7 +59,6 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 
 Semaphore::~Semaphore()
 {
-    delete queue;
 }
 
 //----------------------------------------------------------------------
@@ -82,7 +81,7 @@ Semaphore::P()
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	
     
     while (value == 0) { 		// semaphore not available
-	queue->Append(currentThread);	// so go to sleep
+	queue.Append(currentThread);	// so go to sleep
 	currentThread->Sleep(FALSE);
     } 
     value--; 			// semaphore available, consume its value
@@ -107,8 +106,8 @@ Semaphore::V()
     // disable interrupts
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	
     
-    if (!queue->IsEmpty()) {  // make thread ready.
-	kernel->scheduler->ReadyToRun(queue->RemoveFront());
+    if (!queue.IsEmpty()) {  // make thread ready.
+	kernel->scheduler->ReadyToRun(queue.RemoveFront());
     }
     value++;
     
@@ -213,7 +212,6 @@ void Lock::Release()
 Condition::Condition(char* debugName)
 {
     name = debugName;
-    waitQueue = new List<Semaphore *>;
 }
 
 //----------------------------------------------------------------------
@@ -223,17 +221,16 @@ Condition::Condition(char* debugName)
 
 Condition::~Condition()
 {
-    delete waitQueue;
 }
 
 //----------------------------------------------------------------------
 // Condition::Wait
 // 	Atomically release monitor lock and go to sleep.
-//	Our implementation uses semaphores to implement this, by
-//	allocating a semaphore for each waiting thread.  The signaller
-//	will V() this semaphore, so there is no chance the waiter
-//	will miss the signal, even though the lock is released before
-//	calling P().
+//	We put ourselves on the wait queue and release the lock with
+//	interrupts disabled, and keep them disabled until we are
+//	asleep, so that no one can signal us in between and the signal
+//	can't be missed.  Releasing the lock may make another thread
+//	ready, but never switches to it.
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	waiter must re-acquire the monitor lock when waking up.
@@ -243,16 +240,15 @@ Condition::~Condition()
 
 void Condition::Wait(Lock* conditionLock) 
 {
-     Semaphore *waiter;
+     IntStatus oldLevel;
     
      ASSERT(conditionLock->IsHeldByCurrentThread());
-
-     waiter = new Semaphore("condition", 0);
-     waitQueue->Append(waiter);
+     oldLevel = kernel->interrupt->SetLevel(IntOff);
+     waitQueue.Append(kernel->currentThread);
      conditionLock->Release();
-     waiter->P();
+     kernel->currentThread->Sleep(FALSE);
+     (void) kernel->interrupt->SetLevel(oldLevel);
      conditionLock->Acquire();
-     delete waiter;
 }
 
 //----------------------------------------------------------------------
@@ -264,22 +260,25 @@ void Condition::Wait(Lock* conditionLock)
 //	being woken up (unlike Hoare-style).
 //
 //	Also note: we assume the caller holds the monitor lock
-//	(unlike what is described in Birrell's paper).  This allows
-//	us to access waitQueue without disabling interrupts.
+//	(unlike what is described in Birrell's paper).  That keeps
+//	other signallers away from waitQueue, but a waiter adds itself
+//	with interrupts off, and Scheduler::ReadyToRun needs them off,
+//	so we disable them too.
 //
 //	"conditionLock" -- lock protecting the use of this condition
 //----------------------------------------------------------------------
 
 void Condition::Signal(Lock* conditionLock)
 {
-    Semaphore *waiter;
+    IntStatus oldLevel;
     
     ASSERT(conditionLock->IsHeldByCurrentThread());
     
-    if (!waitQueue->IsEmpty()) {
-        waiter = waitQueue->RemoveFront();
-	waiter->V();
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    if (!waitQueue.IsEmpty()) {
+	kernel->scheduler->ReadyToRun(waitQueue.RemoveFront());
     }
+    (void) kernel->interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
@@ -291,7 +290,109 @@ void Condition::Signal(Lock* conditionLock)
 
 void Condition::Broadcast(Lock* conditionLock) 
 {
-    while (!waitQueue->IsEmpty()) {
+    while (!waitQueue.IsEmpty()) {
         Signal(conditionLock);
     }
 }
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock.  Initially, no one holds it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char* debugName)
+{
+    name = debugName;
+    lock = new Lock("rwlock");
+    okToRead = new Condition("rwlock read");
+    okToWrite = new Condition("rwlock write");
+    readers = waitingWriters = 0;
+    writing = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	Deallocate a reader-writer lock.  No one may be holding it.
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    ASSERT(readers == 0 && !writing);
+    delete okToWrite;
+    delete okToRead;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireRead
+// 	Wait until no writer holds or is waiting for the lock, then
+//	join the readers.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireRead()
+{
+    lock->Acquire();
+    while (writing || waitingWriters > 0) {
+	okToRead->Wait(lock);
+    }
+    readers++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseRead
+// 	Leave the readers; the last one out lets a writer in.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseRead()
+{
+    lock->Acquire();
+    ASSERT(readers > 0);
+    readers--;
+    if (readers == 0) {
+	okToWrite->Signal(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireWrite
+// 	Wait until no one else holds the lock, then take it alone.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireWrite()
+{
+    lock->Acquire();
+    waitingWriters++;
+    while (writing || readers > 0) {
+	okToWrite->Wait(lock);
+    }
+    waitingWriters--;
+    writing = TRUE;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseWrite
+// 	Give up the lock.  Let the next writer in if there is one,
+//	otherwise all the waiting readers.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseWrite()
+{
+    lock->Acquire();
+    ASSERT(writing);
+    writing = FALSE;
+    if (waitingWriters > 0) {
+	okToWrite->Signal(lock);
+    } else {
+	okToRead->Broadcast(lock);
+    }
+    lock->Release();
+}
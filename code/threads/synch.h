@@ -22,6 +22,13 @@
 #include "list.h"
 #include "main.h"
 
+// A queue of blocked threads.  It is linked through the threads
+// themselves (Thread::link), so blocking and waking up never allocate
+// memory.  Interrupts must be disabled, or the queue otherwise
+// protected, when it is used.
+
+typedef IntrusiveList<Thread> WaitQueue;
+
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
 //
@@ -50,7 +57,7 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List<Thread *> *queue;     
+    WaitQueue queue;
 		  	// threads waiting in P() for the value to be > 0
    };
 
@@ -139,6 +146,39 @@ class Condition {
 
   private:
     char* name;
-    List<Semaphore *> *waitQueue;	// list of waiting threads
+    WaitQueue waitQueue;		// threads waiting in Wait()
 };
+
+// The following class defines a "reader-writer lock".  Any number of
+// readers can hold it at once, or a single writer:
+//
+//	AcquireRead/ReleaseRead -- for looking at the protected data
+//
+//	AcquireWrite/ReleaseWrite -- for changing it
+//
+// Once a writer is waiting, new readers wait behind it, so a steady
+// stream of readers can't starve writers.  As with locks, the lock is
+// not re-entrant: a thread that holds it must not acquire it again.
+
+class RWLock {
+  public:
+    RWLock(char* debugName);		// initialize to "no one holds it"
+    ~RWLock();
+    char* getName() { return (name); }
+
+    void AcquireRead();
+    void ReleaseRead();
+    void AcquireWrite();
+    void ReleaseWrite();
+
+  private:
+    char* name;
+    Lock *lock;				// protects the fields below
+    Condition *okToRead;		// signalled when a writer leaves
+    Condition *okToWrite;		// signalled when the lock is free
+    int readers;			// threads holding it for reading
+    int waitingWriters;			// threads waiting in AcquireWrite
+    bool writing;			// is a writer holding it?
+};
+
 #endif // SYNCH_H
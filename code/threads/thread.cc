@@ -46,10 +46,11 @@ Thread::Thread(char* threadName, int threadID)
 					// of machine registers
     }
     space = NULL;
-    for(int i=1;i<=THREAD_MAX_OPEN_FILE_NUM;i++)
+    for(int i=0;i<=THREAD_MAX_OPEN_FILE_NUM;i++)
     {
-        perthreadTable[i]=-1;
+        perthreadTable[i]=-1;	// no file; 0 and 1 are never handed out
     }
+    fdPosition = THREAD_FIRST_FILE_FD;	// hand out the first one first
 }
 
 //----------------------------------------------------------------------
@@ -178,6 +179,7 @@ Thread::Finish ()
     ASSERT(this == kernel->currentThread);
     
     DEBUG(dbgThread, "Finishing thread: " << name);
+    kernel->ProcessExit(this);
     Sleep(TRUE);				// invokes SWITCH
     // not reached
 }
@@ -259,14 +261,23 @@ Thread::Sleep (bool finishing)
     kernel->scheduler->Run(nextThread, finishing); 
 }
 
+//----------------------------------------------------------------------
+// Thread::GetAvlEntry
+//	Find a free file descriptor, starting from the one after the
+//	last handed out.  Only THREAD_FIRST_FILE_FD and up are files;
+//	0 and 1 are always the console, so they are never handed out.
+//----------------------------------------------------------------------
+
 bool
 Thread::GetAvlEntry(int *fdout)
 {
-     int fd = fdPosition;
-     int i = 1;
+     int numFds = THREAD_MAX_OPEN_FILE_NUM - THREAD_FIRST_FILE_FD + 1;
+     int fd;
+     int i = 0;
      int opFd = -1;
-     while(i<=THREAD_MAX_OPEN_FILE_NUM){
-         fd = (fd+i)%(THREAD_MAX_OPEN_FILE_NUM+1);
+     while(i<numFds){
+         fd = THREAD_FIRST_FILE_FD
+		+ (fdPosition - THREAD_FIRST_FILE_FD + i) % numFds;
          opFd = perthreadTable[fd];
          if(opFd==-1){
              *fdout = fd;
@@ -40,6 +40,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "sysdep.h"
+#include "list.h"
 #include "machine.h"
 #include "addrspace.h"
 
@@ -52,6 +53,7 @@
 
 #define MachineStateSize 75 
 #define THREAD_MAX_OPEN_FILE_NUM 10
+#define THREAD_FIRST_FILE_FD 2	// 0 and 1 are the console (see syscall.h)
 
 
 // Size of the thread's private execution stack.
@@ -108,6 +110,7 @@ class Thread {
 	char* getName() { return (name); }
     
 	int getID() { return (ID); }
+	void setID(int id) { ID = id; }
     void Print() { cout << name; }
     void SelfTest();		// test whether thread impl is working
 
@@ -135,6 +138,9 @@ class Thread {
     void RestoreUserState();		// restore user-level register state
 
     AddrSpace *space;			// User code this thread is running.
+    ListLink<Thread> link;		// On the ready list, or the queue
+					// of whatever the thread is blocked
+					// on -- never both at once
 };
 
 // external function, dummy routine whose sole job is to call Thread::Print
@@ -18,77 +18,79 @@
 #include "copyright.h"
 #include "main.h"
 #include "addrspace.h"
+#include "profile.h"
 #include "machine.h"
-#include "noff.h"
+#include "imagecache.h"
+#include "bitmap.h"
+
+Bitmap *AddrSpace::asids = NULL;
+Bitmap *AddrSpace::frames = NULL;
 
 //----------------------------------------------------------------------
-// SwapHeader
-// 	Do little endian to big endian conversion on the bytes in the 
-//	object file header, in case the file was generated on a little
-//	endian machine, and we're now running on a big endian machine.
+// FindFrames
+// 	Find "count" free physical pages in a row, and mark them in use.
+//	Each address space gets a contiguous run of pages, so that a
+//	buffer a user program passes to a system call is contiguous in
+//	the machine's memory too, and the kernel can use it in place.
+//
+//	Returns the first of the pages, or -1 if there is no such run.
 //----------------------------------------------------------------------
 
-static void 
-SwapHeader (NoffHeader *noffH)
+static int
+FindFrames(Bitmap *frames, int numFrames, int count)
 {
-    noffH->noffMagic = WordToHost(noffH->noffMagic);
-    noffH->code.size = WordToHost(noffH->code.size);
-    noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
-    noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
-#ifdef RDATA
-    noffH->readonlyData.size = WordToHost(noffH->readonlyData.size);
-    noffH->readonlyData.virtualAddr = 
-           WordToHost(noffH->readonlyData.virtualAddr);
-    noffH->readonlyData.inFileAddr = 
-           WordToHost(noffH->readonlyData.inFileAddr);
-#endif 
-    noffH->initData.size = WordToHost(noffH->initData.size);
-    noffH->initData.virtualAddr = WordToHost(noffH->initData.virtualAddr);
-    noffH->initData.inFileAddr = WordToHost(noffH->initData.inFileAddr);
-    noffH->uninitData.size = WordToHost(noffH->uninitData.size);
-    noffH->uninitData.virtualAddr = WordToHost(noffH->uninitData.virtualAddr);
-    noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
-
-#ifdef RDATA
-    DEBUG(dbgAddr, "code = " << noffH->code.size <<  
-                   " readonly = " << noffH->readonlyData.size <<
-                   " init = " << noffH->initData.size <<
-                   " uninit = " << noffH->uninitData.size << "\n");
-#endif
+    int run = 0;
+
+    for (int i = 0; i < numFrames; i++) {
+	run = frames->Test(i) ? 0 : run + 1;
+	if (run == count) {
+	    for (int j = i - count + 1; j <= i; j++) {
+		frames->Mark(j);
+	    }
+	    return i - count + 1;
+	}
+    }
+    return -1;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::AddrSpace
-// 	Create an address space to run a user program.
-//	Set up the translation from program memory to physical 
-//	memory.  For now, this is really simple (1:1), since we are
-//	only uniprogramming, and we have a single unsegmented page table
+// 	Create an address space to run a user program.  It has no
+//	memory until Load finds out how much the program needs.
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace()
 {
-    pageTable = new TranslationEntry[NumPhysPages];
-    for (int i = 0; i < NumPhysPages; i++) {
-	pageTable[i].virtualPage = i;	// for now, virt page # = phys page #
-	pageTable[i].physicalPage = i;
-	pageTable[i].valid = TRUE;
-	pageTable[i].use = FALSE;
-	pageTable[i].dirty = FALSE;
-	pageTable[i].readOnly = FALSE;  
+    if (asids == NULL) {
+	asids = new Bitmap(NumAsids);
+	frames = new Bitmap(kernel->machine->numPhysPages);
     }
-    
-    // zero out the entire address space
-    bzero(kernel->machine->mainMemory, MemorySize);
+    asid = asids->FindAndSet();		// -1 if they are all in use
+    symbols = NULL;
+    pageTable = NULL;
+    numPages = 0;
+    firstFrame = -1;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.
+// 	Dealloate an address space, and give back its physical pages.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
-   delete pageTable;
+   if (kernel->machine->tlb != NULL) {
+	kernel->machine->tlb->Flush(asid, TRUE);
+   }					// the entries point into
+					// our page table
+   if (asid >= 0) {
+	asids->Clear(asid);
+   }
+   kernel->scheduler->SpaceDeleted(this);
+   for (unsigned int i = 0; pageTable != NULL && i < numPages; i++) {
+	frames->Clear(pageTable[i].physicalPage);
+   }
+   delete [] pageTable;
 }
 
 
@@ -96,8 +98,15 @@ AddrSpace::~AddrSpace()
 // AddrSpace::Load
 // 	Load a user program into memory from a file.
 //
-//	Assumes that the page table has been initialized, and that
-//	the object code file is in NOFF format.
+//	Finds physical pages for the program, sets up the page table to
+//	point at them, and clears them.  Only our own pages are touched,
+//	so other programs can be running while we load.
+//
+//	Assumes that the object code file is in NOFF format.
+//
+//	The file is read through the kernel's image cache, so a program
+//	that has been run recently is copied from memory, instead of
+//	being read from disk again.
 //
 //	"fileName" is the file containing the object code to load into memory
 //----------------------------------------------------------------------
@@ -106,6 +115,8 @@ bool
 AddrSpace::Load(char *fileName) 
 {
     OpenFile *executable = kernel->fileSystem->Open(fileName);
+    int startTime = kernel->stats->totalTicks;
+    NoffImage *image;
     NoffHeader noffH;
     unsigned int size;
     if (executable == NULL) {
@@ -113,12 +124,15 @@ AddrSpace::Load(char *fileName)
 	return FALSE;
     }
     
-    
-    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-    if ((noffH.noffMagic != NOFFMAGIC) && 
-		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
-    	SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
+#ifdef FILESYS_STUB
+    image = new NoffImage(executable);	// no sectors to key a cache by
+#else
+    image = kernel->imageCache->Get(executable);
+#endif
+    noffH = image->header;
+    if (kernel->profiler != NULL) {
+	symbols = kernel->profiler->Symbols(fileName, executable);
+    }
 
 #ifdef RDATA
 // how big is address space?
@@ -132,44 +146,69 @@ AddrSpace::Load(char *fileName)
 			+ UserStackSize;	// we need to increase the size
 						// to leave room for the stack
 #endif
-    numPages = divRoundUp(size, PageSize);
-    size = numPages * PageSize;
-
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
+    numPages = divRoundUp(size, kernel->machine->pageSize);
+    size = numPages * kernel->machine->pageSize;
+
+    firstFrame = FindFrames(frames, kernel->machine->numPhysPages, numPages);
+    if (firstFrame < 0) {		// too big, at least until we
+					// have virtual memory
+	cerr << "Not enough memory to run " << fileName << "\n";
+	numPages = 0;
+#ifdef FILESYS_STUB
+	delete image;
+#else
+	kernel->imageCache->Put(image);
+#endif
+	delete executable;
+	return FALSE;
+    }
 
-    DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
+    DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size
+			<< " at physical page " << firstFrame);
+    pageTable = new TranslationEntry[numPages];
+    for (unsigned int i = 0; i < numPages; i++) {
+	pageTable[i].virtualPage = i;
+	pageTable[i].physicalPage = firstFrame + i;
+	pageTable[i].valid = TRUE;
+	pageTable[i].use = FALSE;
+	pageTable[i].dirty = FALSE;
+	pageTable[i].readOnly = FALSE;  
+    }
+    
+    // zero out our part of memory
+    bzero(KernelAddr(0), size);
 
 // then, copy in the code and data segments into memory
-// Note: this code assumes that virtual address = physical address
     if (noffH.code.size > 0) {
         DEBUG(dbgAddr, "Initializing code segment.");
 	DEBUG(dbgAddr, noffH.code.virtualAddr << ", " << noffH.code.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.code.virtualAddr]), 
-			noffH.code.size, noffH.code.inFileAddr);
+        bcopy(image->code, KernelAddr(noffH.code.virtualAddr),
+			noffH.code.size);
     }
     if (noffH.initData.size > 0) {
         DEBUG(dbgAddr, "Initializing data segment.");
 	DEBUG(dbgAddr, noffH.initData.virtualAddr << ", " << noffH.initData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.initData.virtualAddr]),
-			noffH.initData.size, noffH.initData.inFileAddr);
+        bcopy(image->initData, KernelAddr(noffH.initData.virtualAddr),
+			noffH.initData.size);
     }
 
 #ifdef RDATA
     if (noffH.readonlyData.size > 0) {
         DEBUG(dbgAddr, "Initializing read only data segment.");
 	DEBUG(dbgAddr, noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.readonlyData.virtualAddr]),
-			noffH.readonlyData.size, noffH.readonlyData.inFileAddr);
+        bcopy(image->readonlyData, KernelAddr(noffH.readonlyData.virtualAddr),
+			noffH.readonlyData.size);
     }
 #endif
  
+#ifdef FILESYS_STUB
+    delete image;
+#else
+    kernel->imageCache->Put(image);
+#endif
     delete executable;			// close file
+    kernel->stats->numProgramLoads++;
+    kernel->stats->programLoadTicks += kernel->stats->totalTicks - startTime;
     return TRUE;			// success
 }
 
@@ -188,8 +227,9 @@ AddrSpace::Execute(char* fileName)
 
     kernel->currentThread->space = this;
 
+    kernel->scheduler->LoadUserState(kernel->currentThread);
+					// take over the machine
     this->InitRegisters();		// set the initial register values
-    this->RestoreState();		// load page table register
 
     kernel->machine->Run();		// jump to the user progam
 
@@ -231,8 +271,9 @@ AddrSpace::InitRegisters()
    // Set the stack register to the end of the address space, where we
    // allocated the stack; but subtract off a bit, to make sure we don't
    // accidentally reference off the end!
-    machine->WriteRegister(StackReg, numPages * PageSize - 16);
-    DEBUG(dbgAddr, "Initializing stack pointer: " << numPages * PageSize - 16);
+    machine->WriteRegister(StackReg, numPages * machine->pageSize - 16);
+    DEBUG(dbgAddr, "Initializing stack pointer: "
+				<< numPages * machine->pageSize - 16);
 }
 
 //----------------------------------------------------------------------
@@ -251,15 +292,64 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table,
+//	and the profiler what program is running.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
-    kernel->machine->pageTable = pageTable;
-    kernel->machine->pageTableSize = numPages;
+    Machine *machine = kernel->machine;
+
+    if (kernel->profiler != NULL) {
+	kernel->profiler->SetSymbols(symbols);
+    }
+    if (machine->tlb != NULL) {		// the TLB is loaded on demand,
+	machine->asid = asid;		// from our page table
+	if (asid < 0) {			// shared with other address
+	    machine->tlb->Flush(asid);	// spaces, so start afresh
+	}
+	return;
+    }
+    machine->pageTable = pageTable;
+    machine->pageTableSize = numPages;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::LoadTlb
+// 	Handle a TLB miss: load the translation for the virtual address
+//	"vaddr" from our page table into the TLB, so the instruction
+//	that missed can be tried again.
+//
+//	Returns FALSE if "vaddr" isn't part of the address space.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::LoadTlb(int vaddr)
+{
+    unsigned int vpn = (unsigned) vaddr >> kernel->machine->pageShift;
+
+    if (vpn >= numPages || !pageTable[vpn].valid) {
+	return FALSE;
+    }
+    kernel->machine->tlb->Load(&pageTable[vpn], asid);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::KernelAddr
+// 	Return where the user address "vaddr" is in the machine's memory,
+//	so the kernel can get at system call arguments.  Since our pages
+//	are contiguous, so is whatever starts there.
+//----------------------------------------------------------------------
+
+char *
+AddrSpace::KernelAddr(int vaddr)
+{
+    ASSERT(vaddr >= 0 &&
+	(unsigned) vaddr < numPages * kernel->machine->pageSize);
+    return &(kernel->machine->mainMemory[firstFrame * kernel->machine->pageSize
+								+ vaddr]);
+}
 
 //----------------------------------------------------------------------
 // AddrSpace::Translate
@@ -272,10 +362,11 @@ void AddrSpace::RestoreState()
 ExceptionType
 AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 {
+    Machine          *machine = kernel->machine;
     TranslationEntry *pte;
     int               pfn;
-    unsigned int      vpn    = vaddr / PageSize;
-    unsigned int      offset = vaddr % PageSize;
+    unsigned int      vpn    = vaddr >> machine->pageShift;
+    unsigned int      offset = vaddr & (machine->pageSize - 1);
 
     if(vpn >= numPages) {
         return AddressErrorException;
@@ -291,7 +382,7 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     // if the pageFrame is too big, there is something really wrong!
     // An invalid translation was loaded into the page table or TLB.
-    if (pfn >= NumPhysPages) {
+    if (pfn >= machine->numPhysPages) {
         DEBUG(dbgAddr, "Illegal physical page " << pfn);
         return BusErrorException;
     }
@@ -301,9 +392,9 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
     if(isReadWrite)
         pte->dirty = TRUE;
 
-    *paddr = pfn*PageSize + offset;
+    *paddr = (pfn << machine->pageShift) + offset;
 
-    ASSERT((*paddr < MemorySize));
+    ASSERT((*paddr < (unsigned) machine->memorySize));
 
     //cerr << " -- AddrSpace::Translate(): vaddr: " << vaddr <<
     //  ", paddr: " << *paddr << "\n";
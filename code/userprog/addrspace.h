@@ -16,6 +16,9 @@
 #include "copyright.h"
 #include "filesys.h"
 
+class Bitmap;
+class SymbolTable;
+
 #define UserStackSize		1024 	// increase this as necessary!
 
 class AddrSpace {
@@ -34,6 +37,11 @@ class AddrSpace {
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
 
+    bool LoadTlb(int vaddr);		// Handle a TLB miss at "vaddr"
+
+    char *KernelAddr(int vaddr);	// Where user address "vaddr" is
+					// in the machine's memory
+
     // Translate virtual address _vaddr_
     // to physical address _paddr_. _mode_
     // is 0 for Read, 1 for Write.
@@ -44,6 +52,16 @@ class AddrSpace {
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    int firstFrame;			// Our physical pages are this
+					// one and the numPages-1 after it
+    int asid;				// Tags our TLB entries; -1 if we
+					// have to share, since there are
+					// more address spaces than ids
+    SymbolTable *symbols;		// Our procedure names, if we are
+					// being profiled
+
+    static Bitmap *asids;		// Which ids are in use
+    static Bitmap *frames;		// Which physical pages are in use
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
@@ -68,7 +68,7 @@ ExceptionHandler(ExceptionType which)
 					DEBUG(dbgSys, "Message received.\n");
 					val = kernel->machine->ReadRegister(4);
 					{
-						char *msg = &(kernel->machine->mainMemory[val]);
+						char *msg = kernel->currentThread->space->KernelAddr(val);
 						cout << msg << endl;
 					}
 					SysHalt();
@@ -78,7 +78,7 @@ ExceptionHandler(ExceptionType which)
 				case SC_Create:
 					val = kernel->machine->ReadRegister(4);
 					{
-						char *filename = &(kernel->machine->mainMemory[val]);
+						char *filename = kernel->currentThread->space->KernelAddr(val);
 						//cout << filename << endl;
 						status = SysCreate(filename);
 						kernel->machine->WriteRegister(2, (int) status);
@@ -96,7 +96,7 @@ ExceptionHandler(ExceptionType which)
 				case SC_Create:
 					val = kernel->machine->ReadRegister(4);
 					{
-						char *filename = &(kernel->machine->mainMemory[val]);
+						char *filename = kernel->currentThread->space->KernelAddr(val);
 						int initSize = kernel->machine->ReadRegister(5);	//args 2
 						//cout << filename << endl;
 						status = SysCreate(filename,initSize);
@@ -112,7 +112,7 @@ ExceptionHandler(ExceptionType which)
 				case SC_Remove:
 					val = kernel->machine->ReadRegister(4);
 					{
-						char *filename = &(kernel->machine->mainMemory[val]);
+						char *filename = kernel->currentThread->space->KernelAddr(val);
 						//cout << filename << endl;
 						status = SysRemove(filename);
 						kernel->machine->WriteRegister(2, (int) status);
@@ -127,7 +127,7 @@ ExceptionHandler(ExceptionType which)
 				case SC_Open:
 					val = kernel->machine->ReadRegister(4);
 					{
-						char *filename = &(kernel->machine->mainMemory[val]);
+						char *filename = kernel->currentThread->space->KernelAddr(val);
 						OpenFileId fd = (OpenFileId)SysOpen(filename);
             OpenFileId fd_t = -1;
             if (kernel->currentThread->GetAvlEntry(&fd_t)&&(fd_t!=-1))
@@ -147,11 +147,16 @@ ExceptionHandler(ExceptionType which)
 
 					val = kernel->machine->ReadRegister(4);
 					{  
-						char *buf       =  &(kernel->machine->mainMemory[val]);
+						char *buf       =  kernel->currentThread->space->KernelAddr(val);
 						int nByes       =  kernel->machine->ReadRegister(5);
 						OpenFileId  fId =  (OpenFileId)(kernel->machine->ReadRegister(6));
+						int  writeByes;
+						if (fId == SysConsoleOutput) {
+							writeByes = SysWriteConsole(buf, nByes);
+						} else {
             OpenFileId  fdsys = (OpenFileId)(kernel->currentThread->GetOpFileTable(fId));
-						int  writeByes  =  SysWrite(buf,nByes, fdsys);
+							writeByes = SysWrite(buf,nByes, fdsys);
+						}
 						kernel->machine->WriteRegister(2, writeByes);
 					}
 					kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -165,12 +170,16 @@ ExceptionHandler(ExceptionType which)
 
 					val = kernel->machine->ReadRegister(4);
 					{  
-						char *buf       =  &(kernel->machine->mainMemory[val]);		// read arguments from memory 
+						char *buf       =  kernel->currentThread->space->KernelAddr(val);		// read arguments from memory 
 						int nBytes      =  kernel->machine->ReadRegister(5);
 						OpenFileId  fId =  (OpenFileId)(kernel->machine->ReadRegister(6));
+						int  readBytes;
+						if (fId == SysConsoleInput) {
+							readBytes = SysReadConsole(buf, nBytes);
+						} else {
             OpenFileId  fdsys = (OpenFileId)(kernel->currentThread->GetOpFileTable(fId));
-
-						int  readBytes  =  SysRead(buf,nBytes, fdsys);	//call ksyscall.h
+							readBytes = SysRead(buf,nBytes, fdsys);	//call ksyscall.h
+						}
 						kernel->machine->WriteRegister(2, readBytes);
 					}
 					kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -210,6 +219,15 @@ ExceptionHandler(ExceptionType which)
 					ASSERTNOTREACHED();
 					break;
 #endif
+				case SC_Sleep:
+					DEBUG(dbgSys, "Sleep " << kernel->machine->ReadRegister(4) << "\n");
+					SysSleep((int)kernel->machine->ReadRegister(4));
+					kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+					kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+					kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+					return;
+					ASSERTNOTREACHED();
+					break;
 				case SC_Add:
 					DEBUG(dbgSys, "Add " << kernel->machine->ReadRegister(4) << " + " << kernel->machine->ReadRegister(5) << "\n");
 					/* Process SysAdd Systemcall*/
@@ -238,6 +256,17 @@ ExceptionHandler(ExceptionType which)
 					DEBUG(dbgAddr, "Program exit\n");
 					val=kernel->machine->ReadRegister(4);
 					cout << "return value:" << val << endl;
+#ifndef FILESYS_STUB
+					// write back the files it left open, and
+					// only those
+					for (int fd = THREAD_FIRST_FILE_FD;
+					     fd <= THREAD_MAX_OPEN_FILE_NUM; fd++) {
+						int fdsys = kernel->currentThread->GetOpFileTable(fd);
+						if (fdsys >= 0) {
+							SysSync(fdsys);
+						}
+					}
+#endif
 					kernel->currentThread->Finish();
 					break;
 				default:
@@ -245,6 +274,15 @@ ExceptionHandler(ExceptionType which)
 					break;
 			}
 			break;
+		case PageFaultException:
+			// with a TLB, this is usually just a TLB miss
+			if (kernel->machine->tlb != NULL &&
+			    kernel->currentThread->space->LoadTlb(
+				kernel->machine->ReadRegister(BadVAddrReg))) {
+				return;		// try the instruction again
+			}
+			cerr << "Page fault at " << kernel->machine->ReadRegister(BadVAddrReg) << "\n";
+			break;
 		default:
 			cerr << "Unexpected user mode exception " << (int)which << "\n";
 			break;
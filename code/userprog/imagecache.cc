@@ -0,0 +1,263 @@
+// imagecache.cc
+//	Routines to read executables into memory, and to keep the
+//	most recently used ones there.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "imagecache.h"
+
+//----------------------------------------------------------------------
+// SwapHeader
+// 	Do little endian to big endian conversion on the bytes in the 
+//	object file header, in case the file was generated on a little
+//	endian machine, and we're now running on a big endian machine.
+//----------------------------------------------------------------------
+
+static void 
+SwapHeader (NoffHeader *noffH)
+{
+    noffH->noffMagic = WordToHost(noffH->noffMagic);
+    noffH->code.size = WordToHost(noffH->code.size);
+    noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
+    noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
+#ifdef RDATA
+    noffH->readonlyData.size = WordToHost(noffH->readonlyData.size);
+    noffH->readonlyData.virtualAddr = 
+           WordToHost(noffH->readonlyData.virtualAddr);
+    noffH->readonlyData.inFileAddr = 
+           WordToHost(noffH->readonlyData.inFileAddr);
+#endif 
+    noffH->initData.size = WordToHost(noffH->initData.size);
+    noffH->initData.virtualAddr = WordToHost(noffH->initData.virtualAddr);
+    noffH->initData.inFileAddr = WordToHost(noffH->initData.inFileAddr);
+    noffH->uninitData.size = WordToHost(noffH->uninitData.size);
+    noffH->uninitData.virtualAddr = WordToHost(noffH->uninitData.virtualAddr);
+    noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
+
+#ifdef RDATA
+    DEBUG(dbgAddr, "code = " << noffH->code.size <<  
+                   " readonly = " << noffH->readonlyData.size <<
+                   " init = " << noffH->initData.size <<
+                   " uninit = " << noffH->uninitData.size << "\n");
+#endif
+}
+
+//----------------------------------------------------------------------
+// NoffImage::NoffImage
+// 	Read an executable into memory: first the header, then the
+//	contents of each segment, into one buffer.
+//
+//	"executable" -- the file to read, which must be in NOFF format
+//----------------------------------------------------------------------
+
+NoffImage::NoffImage(OpenFile *executable)
+{
+    char *next;
+
+    executable->ReadAt((char *)&header, sizeof(header), 0);
+    if ((header.noffMagic != NOFFMAGIC) && 
+		(WordToHost(header.noffMagic) == NOFFMAGIC))
+    	SwapHeader(&header);
+    ASSERT(header.noffMagic == NOFFMAGIC);
+
+    size = header.code.size + header.initData.size;
+#ifdef RDATA
+    size += header.readonlyData.size;
+#endif
+    contents = new char[max(size, 1)];
+    refs = 0;
+
+    next = contents;
+    code = NULL;
+    if (header.code.size > 0) {
+	code = next;
+	executable->ReadAt(code, header.code.size, header.code.inFileAddr);
+	next += header.code.size;
+    }
+    initData = NULL;
+    if (header.initData.size > 0) {
+	initData = next;
+	executable->ReadAt(initData, header.initData.size,
+					header.initData.inFileAddr);
+	next += header.initData.size;
+    }
+#ifdef RDATA
+    readonlyData = NULL;
+    if (header.readonlyData.size > 0) {
+	readonlyData = next;
+	executable->ReadAt(readonlyData, header.readonlyData.size,
+					header.readonlyData.inFileAddr);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// NoffImage::~NoffImage
+// 	De-allocate an executable image.
+//----------------------------------------------------------------------
+
+NoffImage::~NoffImage()
+{
+    ASSERT(refs == 0);
+    delete [] contents;
+}
+
+#ifndef FILESYS_STUB
+
+//----------------------------------------------------------------------
+// ImageCache::ImageCache
+// 	Initialize an empty cache of executables.
+//----------------------------------------------------------------------
+
+ImageCache::ImageCache()
+{
+    for (int i = 0; i < ImageCacheSize; i++) {
+	entries[i].image = NULL;
+    }
+    useCount = 0;
+    changes = 0;
+}
+
+//----------------------------------------------------------------------
+// ImageCache::~ImageCache
+// 	De-allocate the cache, and the images no one else is using.
+//----------------------------------------------------------------------
+
+ImageCache::~ImageCache()
+{
+    for (int i = 0; i < ImageCacheSize; i++) {
+	if (entries[i].image != NULL) {
+	    Drop(&entries[i]);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// ImageCache::Find
+// 	Return the entry caching the file whose header is at "sector",
+//	or NULL if it isn't cached.
+//----------------------------------------------------------------------
+
+ImageCacheEntry *
+ImageCache::Find(int sector)
+{
+    for (int i = 0; i < ImageCacheSize; i++) {
+	if (entries[i].image != NULL && entries[i].sector == sector) {
+	    return &entries[i];
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// ImageCache::Drop
+// 	Throw an image out of the cache.  If no one is using it, it
+//	is deleted now; otherwise, when the last user Puts it.
+//----------------------------------------------------------------------
+
+void
+ImageCache::Drop(ImageCacheEntry *entry)
+{
+    NoffImage *image = entry->image;
+
+    entry->image = NULL;
+    image->refs--;
+    if (image->refs == 0) {
+	delete image;
+    }
+}
+
+//----------------------------------------------------------------------
+// ImageCache::Get
+// 	Return the image of an executable, reading it in if it isn't
+//	cached.  The least recently used image makes room for it.
+//
+//	The caller must Put() the image when done with it.
+//
+//	"executable" -- the file, which must be in NOFF format
+//----------------------------------------------------------------------
+
+NoffImage *
+ImageCache::Get(OpenFile *executable)
+{
+    int sector = executable->HeaderSector();
+    ImageCacheEntry *entry = Find(sector);
+    ImageCacheEntry *victim;
+    NoffImage *image;
+    int changesBefore;
+
+    if (entry != NULL) {
+	DEBUG(dbgAddr, "Image cache hit, file header " << sector);
+	kernel->stats->numImageCacheHits++;
+	entry->lastUsed = ++useCount;
+	entry->image->refs++;
+	return entry->image;
+    }
+
+    DEBUG(dbgAddr, "Image cache miss, file header " << sector);
+    changesBefore = changes;
+    image = new NoffImage(executable);		// may wait for the disk
+    image->refs = 1;
+    if (changes != changesBefore || Find(sector) != NULL) {
+	return image;		// may be stale, or someone else was reading
+				// it too; just use it this once
+    }
+
+    victim = &entries[0];
+    for (int i = 0; i < ImageCacheSize; i++) {
+	if (entries[i].image == NULL) {
+	    victim = &entries[i];
+	    break;
+	}
+	if (entries[i].lastUsed < victim->lastUsed) {
+	    victim = &entries[i];
+	}
+    }
+    if (victim->image != NULL) {
+	Drop(victim);
+    }
+    victim->image = image;
+    victim->sector = sector;
+    victim->lastUsed = ++useCount;
+    image->refs++;		// one for the cache
+    return image;
+}
+
+//----------------------------------------------------------------------
+// ImageCache::Put
+// 	The caller is done with an image from Get().
+//----------------------------------------------------------------------
+
+void
+ImageCache::Put(NoffImage *image)
+{
+    ASSERT(image->refs > 0);
+    image->refs--;
+    if (image->refs == 0) {	// it was thrown out of the cache
+	delete image;
+    }
+}
+
+//----------------------------------------------------------------------
+// ImageCache::Invalidate
+// 	The file whose header is at "sector" has been written to or
+//	removed, so throw out its image, if we have one.
+//----------------------------------------------------------------------
+
+void
+ImageCache::Invalidate(int sector)
+{
+    ImageCacheEntry *entry = Find(sector);
+
+    changes++;
+    if (entry != NULL) {
+	DEBUG(dbgAddr, "Image cache invalidate, file header " << sector);
+	Drop(entry);
+    }
+}
+
+#endif // FILESYS_STUB
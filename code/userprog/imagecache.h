@@ -0,0 +1,94 @@
+// imagecache.h
+//	Data structures for keeping executable files in memory, so
+//	that a program that is run over and over again is only read
+//	from disk once.
+//
+//	A NoffImage is an executable that has been read in: its header,
+//	already converted to the host's byte order, and the contents of
+//	its segments.  AddrSpace::Load copies the segments from it into
+//	the new address space.
+//
+//	The ImageCache keeps the most recently used images, keyed by
+//	the sector holding the executable's file header.  Writing to
+//	the file, or removing it, throws away its image.  An image that
+//	was being read from disk while the file was written is not
+//	kept, since it may be half old and half new.
+//
+//	Images are reference counted, like SectorLockTable's locks: Get
+//	returns one for the caller to use, and Put hands it back.  An
+//	image thrown out of the cache is deleted when its last user is
+//	done with it.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include "copyright.h"
+#include "openfile.h"
+#include "noff.h"
+
+#define ImageCacheSize	8		// executables kept in memory
+
+// The following class defines an executable file read into memory.
+
+class NoffImage {
+  public:
+    NoffImage(OpenFile *executable);	// read in an executable
+    ~NoffImage();			// de-allocate it
+
+    NoffHeader header;			// in host byte order
+    char *code;				// the contents of each segment,
+    char *initData;			// or NULL if it is empty
+#ifdef RDATA
+    char *readonlyData;
+#endif
+    int size;				// bytes of segment contents
+
+    int refs;				// users, counting the cache
+
+  private:
+    char *contents;			// all of the segments
+};
+
+#ifndef FILESYS_STUB
+
+// An executable, as kept in the cache
+
+class ImageCacheEntry {
+  public:
+    NoffImage *image;			// NULL if nothing cached here
+    int sector;				// the file header's sector
+    int lastUsed;			// for LRU replacement
+};
+
+// The following class defines a cache of executables in memory.
+
+class ImageCache {
+  public:
+    ImageCache();			// initialize an empty cache
+    ~ImageCache();			// de-allocate the cache
+
+    NoffImage *Get(OpenFile *executable);
+					// Find "executable" in the cache,
+					// or read it in
+    void Put(NoffImage *image);		// Done with the image from Get()
+
+    void Invalidate(int sector);	// The file whose header is at
+					// "sector" has changed
+
+  private:
+    ImageCacheEntry entries[ImageCacheSize];
+    int useCount;			// bumped each time an entry is used
+    int changes;			// bumped by every Invalidate, to catch
+					// writes made while reading a file
+
+    ImageCacheEntry *Find(int sector);	// where "sector" is cached, or NULL
+    void Drop(ImageCacheEntry *entry);	// throw out an entry
+};
+
+#endif // FILESYS_STUB
+
+#endif // IMAGECACHE_H
@@ -18,6 +18,7 @@
 
 void SysHalt()
 {
+  kernel->fileSystem->Sync();
   kernel->interrupt->Halt();
 }
 
@@ -26,6 +27,36 @@ int SysAdd(int op1, int op2)
   return op1 + op2;
 }
 
+void SysSleep(int ticks)
+{
+  kernel->alarm->WaitUntil(ticks);
+}
+
+int SysWriteConsole(char *buf, int size)
+{
+  for (int i = 0; i < size; i++)
+    kernel->synchConsoleOut->PutChar(buf[i]);
+  return size;
+}
+
+int SysReadConsole(char *buf, int size)
+{
+  // like a UNIX terminal, return at the end of a line, so a
+  // buffered reader doesn't wait for more than the user typed
+  int n = 0;
+  char ch;
+
+  while (n < size) {
+    ch = kernel->synchConsoleIn->GetChar();
+    if (ch == EOF)
+      break;
+    buf[n++] = ch;
+    if (ch == '\n')
+      break;
+  }
+  return n;
+}
+
 #ifdef FILESYS_STUB
 int SysCreate(char *filename)
 {
@@ -74,6 +105,11 @@ int SysSeek(int position, OpenFileId id)
 {
 	return kernel->interrupt->SeekFile(position, id);
 }
+
+int SysSync(int fd)
+{
+	return kernel->interrupt->SyncFile(fd);
+}
 #endif
 
 #endif /* ! __USERPROG_KSYSCALL_H__ */
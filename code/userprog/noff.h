@@ -5,6 +5,9 @@
  *	code (read-only), initialized data, and unitialized data
  */
 
+#ifndef NOFF_H
+#define NOFF_H
+
 #define NOFFMAGIC	0xbadfad 	/* magic number denoting Nachos 
 					 * object code file 
 					 */
@@ -26,3 +29,25 @@ typedef struct noffHeader {
 				 * should be zero'ed before use 
 				 */
 } NoffHeader;
+
+/* A NOFF file may end with a table of the procedures in it, so that
+ * PCs can be given names.  The trailer is the last thing in the file;
+ * it says where the symbols are.  They are sorted by address, and
+ * their names (null-terminated) follow them.
+ */
+
+#define NOFFSYMMAGIC	0xbadfae	/* denotes a symbol table trailer */
+
+typedef struct noffSymbol {
+  int value;			/* address of the procedure */
+  int name;			/* offset of its name, after the symbols */
+} NoffSymbol;
+
+typedef struct noffSymbolTrailer {
+  int numSymbols;		/* how many symbols there are */
+  int inFileAddr;		/* location of the symbols in this file */
+  int stringSize;		/* size of the names that follow them */
+  int symMagic;			/* should be NOFFSYMMAGIC */
+} NoffSymbolTrailer;
+
+#endif /* NOFF_H */
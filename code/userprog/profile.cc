@@ -0,0 +1,318 @@
+// profile.cc
+//	Routines to profile user programs: count the instructions
+//	executed, sample the PC, and print the results when Nachos
+//	halts.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "main.h"
+
+// One line of the flat profile: the samples with the same key.
+
+class ProfileEntry {
+  public:
+    ProfileSample *sample;	// the first of them
+    int count;			// how many there are
+};
+
+//----------------------------------------------------------------------
+// CompareSamples, CompareEntries, CompareOpcodes
+// 	Orderings for qsort: samples by program and key, so that the
+//	ones to count together are next to each other; then profile
+//	entries, and opcodes, by how often they came up, most first.
+//----------------------------------------------------------------------
+
+static int
+CompareSamples(const void *a, const void *b)
+{
+    ProfileSample *x = (ProfileSample *) a;
+    ProfileSample *y = (ProfileSample *) b;
+
+    if (x->symbols != y->symbols) {
+	return (x->symbols < y->symbols) ? -1 : 1;
+    }
+    return x->key - y->key;
+}
+
+static int
+CompareEntries(const void *a, const void *b)
+{
+    return ((ProfileEntry *) b)->count - ((ProfileEntry *) a)->count;
+}
+
+static int *opcodeCounts;	// what CompareOpcodes sorts by
+
+static int
+CompareOpcodes(const void *a, const void *b)
+{
+    return opcodeCounts[*(int *) b] - opcodeCounts[*(int *) a];
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::SymbolTable
+// 	Read the procedure names from the end of an executable.  If
+//	coff2noff didn't put any there, we have none.
+//
+//	"fileName" -- the name of the executable
+//	"executable" -- the file itself
+//----------------------------------------------------------------------
+
+SymbolTable::SymbolTable(char *fileName, OpenFile *executable)
+{
+    NoffSymbolTrailer trailer;
+    int length = executable->Length();
+    int stringSize;
+
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+    numSymbols = 0;
+    symbols = NULL;
+    strings = NULL;
+
+    if (length < (int) (sizeof(NoffHeader) + sizeof(NoffSymbolTrailer))) {
+	return;
+    }
+    executable->ReadAt((char *) &trailer, sizeof(NoffSymbolTrailer),
+				length - sizeof(NoffSymbolTrailer));
+    if (WordToHost(trailer.symMagic) != NOFFSYMMAGIC) {
+	DEBUG(dbgAddr, "No symbols in " << fileName);
+	return;
+    }
+    numSymbols = WordToHost(trailer.numSymbols);
+    stringSize = WordToHost(trailer.stringSize);
+    symbols = new NoffSymbol[numSymbols];
+    executable->ReadAt((char *) symbols, numSymbols * sizeof(NoffSymbol),
+				WordToHost(trailer.inFileAddr));
+    strings = new char[stringSize + 1];
+    executable->ReadAt(strings, stringSize, WordToHost(trailer.inFileAddr)
+				+ numSymbols * sizeof(NoffSymbol));
+    strings[stringSize] = '\0';
+
+    for (int i = 0; i < numSymbols; i++) {
+	symbols[i].value = WordToHost(symbols[i].value);
+	symbols[i].name = WordToHost(symbols[i].name);
+	ASSERT(symbols[i].name >= 0 && symbols[i].name < stringSize);
+    }
+    DEBUG(dbgAddr, "Read " << numSymbols << " symbols from " << fileName);
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::~SymbolTable
+// 	De-allocate the names.
+//----------------------------------------------------------------------
+
+SymbolTable::~SymbolTable()
+{
+    delete [] name;
+    delete [] symbols;
+    delete [] strings;
+}
+
+//----------------------------------------------------------------------
+// SymbolTable::Find
+// 	Return which procedure "pc" is in: the last one starting at or
+//	before it.  Returns -1 if it comes before all of them, or
+//	there are none.
+//----------------------------------------------------------------------
+
+int
+SymbolTable::Find(int pc)
+{
+    int low = 0, high = numSymbols - 1, mid;
+    int found = -1;
+
+    while (low <= high) {
+	mid = (low + high) / 2;
+	if (symbols[mid].value <= pc) {
+	    found = mid;
+	    low = mid + 1;
+	} else {
+	    high = mid - 1;
+	}
+    }
+    return found;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Profiler
+// 	Start profiling.  The sample buffer is allocated now, so that
+//	taking a sample is cheap.
+//
+//	"sampleInterval" -- how many ticks between PC samples
+//----------------------------------------------------------------------
+
+Profiler::Profiler(int sampleInterval)
+{
+    ASSERT(sampleInterval > 0);
+    interval = sampleInterval;
+    nextSample = kernel->stats->totalTicks + interval;
+    for (int i = 0; i < NumOpcodes; i++) {
+	opCounts[i] = 0;
+    }
+    samples = new ProfileSample[ProfileSamples];
+    numSamples = 0;
+    numDropped = 0;
+    current = NULL;
+    tables = new List<SymbolTable *>;
+}
+
+//----------------------------------------------------------------------
+// Profiler::~Profiler
+// 	De-allocate the samples, and the symbol tables.
+//----------------------------------------------------------------------
+
+Profiler::~Profiler()
+{
+    delete [] samples;
+    while (!tables->IsEmpty()) {
+	delete tables->RemoveFront();
+    }
+    delete tables;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Count
+// 	Called by the simulated CPU each time it finishes an
+//	instruction.  Count its opcode, and if it is time, record
+//	where it was.
+//
+//	"opCode" -- the instruction's opcode, as numbered in mipssim.h
+//	"pc" -- its address
+//----------------------------------------------------------------------
+
+void
+Profiler::Count(int opCode, int pc)
+{
+    int now = kernel->stats->totalTicks;
+
+    opCounts[opCode]++;
+    if (now < nextSample) {
+	return;
+    }
+    nextSample = now + interval;
+    if (numSamples == ProfileSamples) {
+	numDropped++;
+	return;
+    }
+    samples[numSamples].pc = pc;
+    samples[numSamples].symbols = current;
+    numSamples++;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Symbols
+// 	Return the procedure names for a program being loaded.  They
+//	are only read the first time the program is run.
+//
+//	"fileName" -- the name of the executable
+//	"executable" -- the file itself
+//----------------------------------------------------------------------
+
+SymbolTable *
+Profiler::Symbols(char *fileName, OpenFile *executable)
+{
+    ListIterator<SymbolTable *> iter(tables);
+    SymbolTable *symbols;
+
+    for (; !iter.IsDone(); iter.Next()) {
+	if (strcmp(iter.Item()->FileName(), fileName) == 0) {
+	    return iter.Item();
+	}
+    }
+    symbols = new SymbolTable(fileName, executable);
+    tables->Append(symbols);
+    return symbols;
+}
+
+//----------------------------------------------------------------------
+// Profiler::PrintOpcodes
+// 	Print how many of each kind of instruction were executed,
+//	the most common first.
+//----------------------------------------------------------------------
+
+void
+Profiler::PrintOpcodes()
+{
+    int order[NumOpcodes];
+    int total = 0;
+    int i;
+
+    for (i = 0; i < NumOpcodes; i++) {
+	order[i] = i;
+	total += opCounts[i];
+    }
+    opcodeCounts = opCounts;
+    qsort(order, NumOpcodes, sizeof(int), CompareOpcodes);
+
+    cout << "Instruction mix, " << total << " instructions:\n";
+    for (i = 0; i < NumOpcodes && opCounts[order[i]] > 0; i++) {
+	cout << "\t" << OpcodeName(order[i]) << "\t" << opCounts[order[i]]
+		<< "\t" << (100.0 * opCounts[order[i]] / total) << "%\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// Profiler::Print
+// 	Print the instruction mix, and a flat profile: the procedures
+//	the most samples fell in.  Samples in a program without names
+//	are counted by PC.
+//----------------------------------------------------------------------
+
+void
+Profiler::Print()
+{
+    ProfileEntry *entries;
+    ProfileSample *s;
+    int numEntries = 0;
+    int i;
+
+    PrintOpcodes();
+
+    for (i = 0; i < numSamples; i++) {
+	s = &samples[i];
+	s->key = -1;
+	if (s->symbols != NULL) {
+	    s->key = s->symbols->Find(s->pc);
+	}
+	if (s->key < 0) {		// count it by itself
+	    s->symbols = NULL;
+	    s->key = s->pc;
+	}
+    }
+    qsort(samples, numSamples, sizeof(ProfileSample), CompareSamples);
+
+    entries = new ProfileEntry[numSamples];
+    for (i = 0; i < numSamples; i++) {
+	if (i > 0 && CompareSamples(&samples[i - 1], &samples[i]) == 0) {
+	    entries[numEntries - 1].count++;
+	} else {
+	    entries[numEntries].sample = &samples[i];
+	    entries[numEntries].count = 1;
+	    numEntries++;
+	}
+    }
+    qsort(entries, numEntries, sizeof(ProfileEntry), CompareEntries);
+
+    cout << "Flat profile, " << numSamples << " samples, one every "
+	<< interval << " ticks";
+    if (numDropped > 0) {
+	cout << " (" << numDropped << " more didn't fit)";
+    }
+    cout << ":\n";
+    for (i = 0; i < numEntries && i < ProfileLines; i++) {
+	s = entries[i].sample;
+	cout << "\t" << (100.0 * entries[i].count / numSamples) << "%\t"
+		<< entries[i].count << "\t";
+	if (s->symbols != NULL) {
+	    cout << s->symbols->SymbolName(s->key) << " ("
+		<< s->symbols->FileName() << ")\n";
+	} else {
+	    cout << "PC " << s->key << "\n";
+	}
+    }
+    delete [] entries;
+}
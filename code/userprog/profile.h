@@ -0,0 +1,94 @@
+// profile.h
+//	Data structures for profiling user programs.
+//
+//	While it is turned on (-prof), the simulated CPU tells the
+//	Profiler about every instruction it completes.  The Profiler
+//	counts how many of each opcode were executed, and every so
+//	many ticks it records the PC of the instruction, in a buffer
+//	allocated up front so that profiling doesn't allocate memory
+//	as the program runs.  When Nachos halts, it prints the mix of
+//	instructions, and a flat profile: how many of the samples fell
+//	in each procedure.
+//
+//	To name the procedures, coff2noff copies the procedure names
+//	from the COFF file into a table at the end of the NOFF file
+//	(see noff.h).  A program without one is profiled by PC.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "list.h"
+#include "openfile.h"
+#include "noff.h"
+
+#define NumOpcodes	64		// opcodes, as numbered in mipssim.h
+#define ProfileSamples	100000		// most PC samples we keep
+#define ProfileLines	20		// how much of the profile to print
+
+// The following class defines the procedure names of an executable.
+
+class SymbolTable {
+  public:
+    SymbolTable(char *fileName, OpenFile *executable);
+    				// read the names from an executable
+    ~SymbolTable();
+
+    char *FileName() { return name; }
+    int Find(int pc);		// which procedure is "pc" in?
+    char *SymbolName(int i) { return &strings[symbols[i].name]; }
+
+  private:
+    char *name;			// the file the names came from
+    int numSymbols;		// 0 if it had none
+    NoffSymbol *symbols;	// procedures, sorted by address
+    char *strings;		// their names
+};
+
+// A PC sample, and the program it was in.
+
+class ProfileSample {
+  public:
+    int pc;
+    SymbolTable *symbols;	// to name the procedure; NULL if the
+				// program wasn't loaded from a file
+    int key;			// where the sample is counted in
+				// the profile; set when it is printed
+};
+
+// The following class defines the profiler.
+
+class Profiler {
+  public:
+    Profiler(int sampleInterval);	// start profiling, taking a sample
+					// every "sampleInterval" ticks
+    ~Profiler();
+
+    void Count(int opCode, int pc);	// an instruction was executed
+
+    SymbolTable *Symbols(char *fileName, OpenFile *executable);
+    				// get the names for a program being loaded
+    void SetSymbols(SymbolTable *symbols) { current = symbols; }
+    				// a context switch to another program
+
+    void Print();		// print the instruction mix and
+				// flat profile
+
+  private:
+    int interval;		// ticks between samples
+    int nextSample;		// when to take the next one
+    int opCounts[NumOpcodes];	// how often each opcode was executed
+    ProfileSample *samples;	// the samples taken so far
+    int numSamples;
+    int numDropped;		// samples that didn't fit
+    SymbolTable *current;	// names for the running program
+    List<SymbolTable *> *tables;	// every program that has been loaded
+
+    void PrintOpcodes();	// print the instruction mix
+};
+
+#endif // PROFILE_H
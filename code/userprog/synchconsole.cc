@@ -8,6 +8,7 @@
 
 #include "copyright.h"
 #include "synchconsole.h"
+#include "main.h"
 
 //----------------------------------------------------------------------
 // SynchConsoleInput::SynchConsoleInput
@@ -22,6 +23,7 @@ SynchConsoleInput::SynchConsoleInput(char *inputFile)
     consoleInput = new ConsoleInput(inputFile, this);
     lock = new Lock("console in");
     waitFor = new Semaphore("console in", 0);
+    numWaiting = 0;
 }
 
 //----------------------------------------------------------------------
@@ -46,13 +48,32 @@ SynchConsoleInput::GetChar()
 {
     char ch;
 
+    numWaiting++;
     lock->Acquire();
+    consoleInput->Enable();	// in case there was nothing to run before
     waitFor->P();	// wait for EOF or a char to be available.
     ch = consoleInput->GetChar();
     lock->Release();
+    numWaiting--;
     return ch;
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleInput::Disable
+//      Called when there is nothing left to run (Kernel::PrepareToEnd),
+//	so the keyboard doesn't keep the machine going.  But if someone
+//	is waiting for a key, that is why there is nothing to run, so
+//	keep polling for them.  GetChar starts the polling again.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleInput::Disable()
+{
+    if (numWaiting == 0) {
+	consoleInput->Disable();
+    }
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleInput::CallBack
 //      Interrupt handler called when keystroke is hit; wake up
@@ -102,7 +123,9 @@ SynchConsoleOutput::PutChar(char ch)
 {
     lock->Acquire();
     consoleOutput->PutChar(ch);
-    waitFor->P();
+    if (!kernel->untimed) {
+	waitFor->P();		// no interrupt in untimed mode
+    }
     lock->Release();
 }
 
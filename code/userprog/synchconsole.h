@@ -25,7 +25,8 @@ class SynchConsoleInput : public CallBackObj {
     SynchConsoleInput(char *inputFile); // Initialize the console device
     ~SynchConsoleInput();		// Deallocate console device
 	
-	void Disable() { consoleInput->Disable(); }// 2015.11.25
+	void Disable();		// stop polling the keyboard, unless
+				// someone is waiting for it
 
     char GetChar();		// Read a character, waiting if necessary
     
@@ -33,6 +34,7 @@ class SynchConsoleInput : public CallBackObj {
     ConsoleInput *consoleInput;	// the hardware keyboard
     Lock *lock;			// only one reader at a time
     Semaphore *waitFor;		// wait for callBack
+    int numWaiting;		// threads in GetChar
 
     void CallBack();		// called when a keystroke is available
 };
@@ -34,6 +34,7 @@
 #define SC_ExecV	13
 #define SC_ThreadExit   14
 #define SC_ThreadJoin   15
+#define SC_Sleep	16
 #define SC_Add		42
 #define SC_MSG		100
 
@@ -183,6 +184,12 @@ int ThreadJoin(ThreadId id);
  */
 void ThreadExit(int ExitCode);	
 
+/* Put the current thread to sleep for "ticks" ticks of simulated time.
+ * Other threads run in the meantime; if there are none, the machine
+ * idles until the time is up.
+ */
+void Sleep(int ticks);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -47,3 +47,58 @@ struct scnhdr {
         long            s_flags;        /* flags */
       };
  
+
+/* The symbolic header, at f_symptr.  Of the symbol table, we only
+ * use the external symbols, to get the names of the procedures.
+ */
+
+#define magicSym        0x7009
+
+typedef struct hdrr {
+        short   magic;          /* magicSym */
+        short   vstamp;         /* version stamp */
+        long    ilineMax;       /* number of line number entries */
+        long    cbLine;         /* byte size of line number entries */
+        long    cbLineOffset;   /* offset to line number entries */
+        long    idnMax;         /* max index into dense number table */
+        long    cbDnOffset;     /* offset to dense number table */
+        long    ipdMax;         /* number of procedure descriptors */
+        long    cbPdOffset;     /* offset to procedure descriptors */
+        long    isymMax;        /* number of local symbols */
+        long    cbSymOffset;    /* offset to local symbols */
+        long    ioptMax;        /* max index into optimization table */
+        long    cbOptOffset;    /* offset to optimization table */
+        long    iauxMax;        /* number of auxiliary symbols */
+        long    cbAuxOffset;    /* offset to auxiliary symbols */
+        long    issMax;         /* size of local string table */
+        long    cbSsOffset;     /* offset to local string table */
+        long    issExtMax;      /* size of external string table */
+        long    cbSsExtOffset;  /* offset to external string table */
+        long    ifdMax;         /* number of file descriptors */
+        long    cbFdOffset;     /* offset to file descriptors */
+        long    crfd;           /* number of relative file descriptors */
+        long    cbRfdOffset;    /* offset to relative file descriptors */
+        long    iextMax;        /* number of external symbols */
+        long    cbExtOffset;    /* offset to external symbols */
+      } HDRR;
+
+/* An external symbol, as it is laid out in a little-endian file.
+ * The symbol type is the low 6 bits of es_bits, and its storage
+ * class the 5 bits above that.
+ */
+
+typedef struct extr {
+        unsigned char   es_flags;       /* jmptbl, cobol_main, weakext */
+        unsigned char   es_reserved;
+        short           es_ifd;         /* where the symbol is defined */
+        long            es_iss;         /* offset of its name in the
+                                         * external string table */
+        long            es_value;       /* its address */
+        unsigned long   es_bits;        /* type, storage class, index */
+      } EXTR;
+
+#define ExtSymType(bits)        ((bits) & 0x3f)
+#define ExtSymClass(bits)       (((bits) >> 6) & 0x1f)
+
+#define stProc          6               /* symbol type of a procedure */
+#define scText          1               /* storage class of text */
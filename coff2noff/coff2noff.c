@@ -18,6 +18,10 @@
  *      .rdata  -- read-only data (e.g., string literals).
  *                 mark this segment readonly to prevent it from being modified
 #endif
+ *
+ * If the COFF file has a symbol table, the names and addresses of its
+ * procedures are copied to the end of the NOFF file (see noff.h), for
+ * the Nachos profiler.
  *
  *
  * Copyright (c) 1992-1993 The Regents of the University of California.
@@ -148,6 +152,83 @@ void Write(int fd, char *buf, int nBytes)
     }
 }
 
+/* sort procedures by address, for qsort */
+static int
+CompareSymbols(const void *a, const void *b)
+{
+    return ((NoffSymbol *)a)->value - ((NoffSymbol *)b)->value;
+}
+
+/* Copy the names and addresses of the procedures from the COFF
+ * symbol table, if there is one, to the end of the NOFF file, so
+ * that the Nachos profiler can say which procedure a PC is in.
+ * "inNoffFile" is where the output file is now.
+ *
+ * Only external procedures are copied; static ones show up as part
+ * of the procedure before them.
+ */
+void WriteSymbols(int fdIn, int fdOut, struct filehdr *fileh, int inNoffFile)
+{
+    HDRR symh;
+    EXTR *ext;
+    NoffSymbol *syms;
+    NoffSymbolTrailer trailer;
+    char *strings;
+    int i, n;
+
+    if (fileh->f_symptr == 0) {
+	return;				/* stripped */
+    }
+    lseek(fdIn, fileh->f_symptr, 0);
+    ReadStruct(fdIn, symh);
+    if (ShortToHost(symh.magic) != magicSym) {
+	fprintf(stderr, "Bad symbolic header, symbols not copied\n");
+	return;
+    }
+    symh.iextMax = WordToHost(symh.iextMax);
+    symh.cbExtOffset = WordToHost(symh.cbExtOffset);
+    symh.issExtMax = WordToHost(symh.issExtMax);
+    symh.cbSsExtOffset = WordToHost(symh.cbSsExtOffset);
+
+    ext = (EXTR *)malloc(symh.iextMax * sizeof(EXTR));
+    lseek(fdIn, symh.cbExtOffset, 0);
+    Read(fdIn, (char *) ext, symh.iextMax * sizeof(EXTR));
+    strings = malloc(symh.issExtMax);
+    lseek(fdIn, symh.cbSsExtOffset, 0);
+    Read(fdIn, strings, symh.issExtMax);
+
+    syms = (NoffSymbol *)malloc(symh.iextMax * sizeof(NoffSymbol));
+    n = 0;
+    for (i = 0; i < symh.iextMax; i++) {
+	ext[i].es_bits = WordToHost(ext[i].es_bits);
+	if (ExtSymType(ext[i].es_bits) == stProc
+			&& ExtSymClass(ext[i].es_bits) == scText) {
+	    syms[n].value = WordToHost(ext[i].es_value);
+	    syms[n].name = WordToHost(ext[i].es_iss);
+	    n++;
+	}
+    }
+    qsort(syms, n, sizeof(NoffSymbol), CompareSymbols);
+    printf("Copying %d procedure names\n", n);
+
+    for (i = 0; i < n; i++) {
+	syms[i].value = WordToMachine(syms[i].value);
+	syms[i].name = WordToMachine(syms[i].name);
+    }
+    Write(fdOut, (char *)syms, n * sizeof(NoffSymbol));
+    Write(fdOut, strings, symh.issExtMax);
+
+    trailer.numSymbols = WordToMachine(n);
+    trailer.inFileAddr = WordToMachine(inNoffFile);
+    trailer.stringSize = WordToMachine(symh.issExtMax);
+    trailer.symMagic = WordToMachine(NOFFSYMMAGIC);
+    Write(fdOut, (char *)&trailer, sizeof(NoffSymbolTrailer));
+
+    free(ext);
+    free(strings);
+    free(syms);
+}
+
 int main(int argc, char **argv)
 {
     int fdIn, fdOut, numsections, i, inNoffFile;
@@ -181,6 +262,7 @@ int main(int argc, char **argv)
     ReadStruct(fdIn,fileh);
     fileh.f_magic = ShortToHost(fileh.f_magic);
     fileh.f_nscns = ShortToHost(fileh.f_nscns); 
+    fileh.f_symptr = WordToHost(fileh.f_symptr);
     if (fileh.f_magic != MIPSELMAGIC) {
 	fprintf(stderr, "File is not a MIPSEL COFF file\n");
         unlink(noffFileName);
@@ -287,6 +369,7 @@ int main(int argc, char **argv)
 	    exit(1);
 	}
     }
+    WriteSymbols(fdIn, fdOut, &fileh, inNoffFile);
     lseek(fdOut, 0, 0);
 
     // convert the NOFF header to little-endian before
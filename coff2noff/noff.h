@@ -26,3 +26,23 @@ typedef struct noffHeader {
 				 * should be zero'ed before use 
 				 */
 } NoffHeader;
+
+/* A NOFF file may end with a table of the procedures in it, so that
+ * PCs can be given names.  The trailer is the last thing in the file;
+ * it says where the symbols are.  They are sorted by address, and
+ * their names (null-terminated) follow them.
+ */
+
+#define NOFFSYMMAGIC	0xbadfae	/* denotes a symbol table trailer */
+
+typedef struct noffSymbol {
+  int value;			/* address of the procedure */
+  int name;			/* offset of its name, after the symbols */
+} NoffSymbol;
+
+typedef struct noffSymbolTrailer {
+  int numSymbols;		/* how many symbols there are */
+  int inFileAddr;		/* location of the symbols in this file */
+  int stringSize;		/* size of the names that follow them */
+  int symMagic;			/* should be NOFFSYMMAGIC */
+} NoffSymbolTrailer;
@@ -0,0 +1,484 @@
+// replay.cc
+//	Replay a trace of disk requests, recorded by running Nachos with
+//	-dtrace, against a different model of the disk, without running
+//	Nachos again.
+//
+//	    replay [-model recorded|nachos|notrackbuf] [-sched fifo|sstf|scan]
+//		   [-cache sectors] [-seek ticks] [-rotation ticks] traceFile
+//
+//	-model says how long each request takes:
+//	    recorded	-- what it took when the trace was made
+//	    nachos	-- Disk::ComputeLatency, with its track buffer
+//	    notrackbuf	-- Disk::ComputeLatency, built with NOTRACKBUF
+//	-sched says which waiting request each disk does next:
+//	    fifo	-- the oldest (what SynchDisk does)
+//	    sstf	-- the one on the nearest track
+//	    scan	-- the elevator: the nearest one in the direction
+//			   the head is moving, turning at the last one
+//	-cache puts an LRU cache of that many sectors in front of the
+//	    disks.  Writes go through it to the disk; a read that hits
+//	    in it never gets to the disk.
+//	-seek and -rotation change SeekTime and RotationTime, for the
+//	    nachos and notrackbuf models.
+//
+//	Each request reaches its disk at the tick it was made in the
+//	trace, however long the ones before it take here; so a slower
+//	model or a better scheduler shows up in the queueing delay.  The
+//	trace, replayed with "-model recorded -sched fifo" and no cache,
+//	takes exactly what it took in Nachos.
+//
+//	SynchDisk gives each disk only one request at a time, so in a
+//	trace of it nothing ever waits for a disk, and -sched makes no
+//	difference -- unless a slower model makes the requests pile up.
+//
+//	At the end we print the response time of the requests (from
+//	being made to being done) -- mean, percentiles, and worst --
+//	and how long the disks were busy.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "disktrace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MaxUnits	8		// DiskTraceUnit has three bits
+
+enum Model { ModelRecorded, ModelNachos, ModelNoTrackBuf };
+enum Scheduler { SchedFifo, SchedSstf, SchedScan };
+
+// What we know about the disk, from the trace header and the options
+
+static DiskTraceHeader geometry;
+static Model model = ModelNachos;
+static Scheduler scheduler = SchedFifo;
+static int cacheSize = 0;
+
+// One request being replayed
+
+class Request {
+  public:
+    int arrival;		// tick it was made
+    int sector;
+    int unit;
+    bool writing;
+    int recorded;		// latency in the trace
+    bool hit;			// a read satisfied by the cache
+    int done;			// tick it finished
+};
+
+// The state of one simulated disk: where its head is, and what is
+// in its track buffer (see Disk in ../code/machine/disk.cc)
+
+class DiskState {
+  public:
+    int lastSector;
+    int bufferInit;
+    bool up;			// for scan: is the head moving up?
+    int busy;			// ticks spent doing requests
+};
+
+//----------------------------------------------------------------------
+// Usage
+// 	Say how to run us, and give up.
+//----------------------------------------------------------------------
+
+static void
+Usage()
+{
+    fprintf(stderr, "Usage: replay [-model recorded|nachos|notrackbuf] "
+		"[-sched fifo|sstf|scan]\n\t[-cache sectors] [-seek ticks] "
+		"[-rotation ticks] traceFile\n");
+    exit(1);
+}
+
+//----------------------------------------------------------------------
+// ReadTrace
+// 	Read the trace file into an array of requests.  Returns how
+//	many there are.
+//----------------------------------------------------------------------
+
+static int
+ReadTrace(char *fileName, Request **requests)
+{
+    FILE *fp = fopen(fileName, "rb");
+    DiskTraceRecord record;
+    int numRequests = 0, maxRequests = 1024;
+    Request *r;
+
+    if (fp == NULL) {
+	perror(fileName);
+	exit(1);
+    }
+    if (fread(&geometry, sizeof(DiskTraceHeader), 1, fp) != 1
+		|| geometry.magic != DISKTRACEMAGIC) {
+	fprintf(stderr, "%s is not a disk trace from this kind of host\n",
+			fileName);
+	exit(1);
+    }
+    *requests = new Request[maxRequests];
+    while (fread(&record, sizeof(DiskTraceRecord), 1, fp) == 1) {
+	if (numRequests == maxRequests) {
+	    Request *more = new Request[maxRequests * 2];
+
+	    memcpy(more, *requests, maxRequests * sizeof(Request));
+	    delete [] *requests;
+	    *requests = more;
+	    maxRequests *= 2;
+	}
+	r = &(*requests)[numRequests++];
+	r->arrival = record.tick;
+	r->sector = DiskTraceSector(record.request);
+	r->unit = DiskTraceUnit(record.request);
+	r->writing = DiskTraceWriting(record.request);
+	r->recorded = record.latency;
+	r->hit = false;
+	r->done = 0;
+    }
+    fclose(fp);
+    return numRequests;
+}
+
+//----------------------------------------------------------------------
+// ApplyCache
+// 	Run the requests through an LRU cache of "cacheSize" sectors,
+//	in the order they were made, and mark the reads it satisfies.
+//	Returns how many there were.
+//----------------------------------------------------------------------
+
+static int
+ApplyCache(Request *requests, int numRequests)
+{
+    int *keys = new int[cacheSize];	// most recently used first
+    int numCached = 0, hits = 0, i, j, key;
+
+    for (i = 0; i < numRequests; i++) {
+	key = requests[i].sector * MaxUnits + requests[i].unit;
+	for (j = 0; j < numCached; j++) {
+	    if (keys[j] == key) {
+		break;
+	    }
+	}
+	if (j < numCached) {
+	    if (!requests[i].writing) {
+		requests[i].hit = true;
+		hits++;
+	    }
+	} else if (numCached < cacheSize) {
+	    j = numCached++;
+	} else {
+	    j = cacheSize - 1;		// throw out the least recently used
+	}
+	for (; j > 0; j--) {		// move it to the front
+	    keys[j] = keys[j - 1];
+	}
+	keys[0] = key;
+    }
+    delete [] keys;
+    return hits;
+}
+
+//----------------------------------------------------------------------
+// TimeToSeek, ModuloDiff, ComputeLatency, UpdateLast
+// 	The same as in Disk, but at the tick "now" rather than
+//	kernel->stats->totalTicks, and with the timing from the
+//	trace header (or the options).
+//----------------------------------------------------------------------
+
+static int
+TimeToSeek(DiskState *disk, int now, int newSector, int *rotation)
+{
+    int newTrack = newSector / geometry.sectorsPerTrack;
+    int oldTrack = disk->lastSector / geometry.sectorsPerTrack;
+    int seek = abs(newTrack - oldTrack) * geometry.seekTime;
+    int over = (now + seek) % geometry.rotationTime;
+
+    *rotation = 0;
+    if (over > 0)
+	*rotation = geometry.rotationTime - over;
+    return seek;
+}
+
+static int
+ModuloDiff(int to, int from)
+{
+    int toOffset = to % geometry.sectorsPerTrack;
+    int fromOffset = from % geometry.sectorsPerTrack;
+
+    return ((toOffset - fromOffset) + geometry.sectorsPerTrack)
+		% geometry.sectorsPerTrack;
+}
+
+static int
+ComputeLatency(DiskState *disk, int now, int newSector, bool writing)
+{
+    int rotation;
+    int seek = TimeToSeek(disk, now, newSector, &rotation);
+    int timeAfter = now + seek + rotation;
+
+    if (model == ModelNachos && !writing && seek == 0
+		&& ((timeAfter - disk->bufferInit) / geometry.rotationTime)
+		> ModuloDiff(newSector,
+			disk->bufferInit / geometry.rotationTime)) {
+	return geometry.rotationTime;
+    }
+    rotation += ModuloDiff(newSector, timeAfter / geometry.rotationTime)
+		* geometry.rotationTime;
+    return seek + rotation + geometry.rotationTime;
+}
+
+static void
+UpdateLast(DiskState *disk, int now, int newSector)
+{
+    int rotate;
+    int seek = TimeToSeek(disk, now, newSector, &rotate);
+
+    if (seek != 0)
+	disk->bufferInit = now + seek + rotate;
+    disk->lastSector = newSector;
+}
+
+//----------------------------------------------------------------------
+// PickNext
+// 	Choose which of the waiting requests a disk does next.
+//
+//	"waiting" -- the requests that have arrived, oldest first
+//----------------------------------------------------------------------
+
+static int
+PickNext(DiskState *disk, Request **waiting, int numWaiting)
+{
+    int headTrack = disk->lastSector / geometry.sectorsPerTrack;
+    int best = 0, bestDistance = -1, distance, track, i;
+
+    if (scheduler == SchedFifo) {
+	return 0;
+    }
+    for (int pass = 0; pass < 2 && bestDistance < 0; pass++) {
+	for (i = 0; i < numWaiting; i++) {
+	    track = waiting[i]->sector / geometry.sectorsPerTrack;
+	    distance = abs(track - headTrack);
+	    if (scheduler == SchedScan
+			&& (disk->up ? track < headTrack : track > headTrack)) {
+		continue;		// behind the head
+	    }
+	    if (bestDistance < 0 || distance < bestDistance) {
+		best = i;
+		bestDistance = distance;
+	    }
+	}
+	if (bestDistance < 0) {		// nothing ahead; turn around
+	    disk->up = !disk->up;
+	}
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// ReplayUnit
+// 	Replay the requests to one disk.  They arrive when the trace
+//	says; whenever the disk is idle and some are waiting, it does
+//	the one the scheduler picks.
+//----------------------------------------------------------------------
+
+static void
+ReplayUnit(int unit, Request *requests, int numRequests, DiskState *disk)
+{
+    Request **waiting = new Request *[numRequests];
+    int numWaiting = 0, next = 0, now = 0, latency, i;
+    Request *r;
+
+    disk->lastSector = 0;
+    disk->bufferInit = 0;
+    disk->up = true;
+    disk->busy = 0;
+    for (;;) {
+	// everything that has arrived by now joins the queue
+	for (; next < numRequests; next++) {
+	    r = &requests[next];
+	    if (r->unit != unit || r->hit) {
+		continue;
+	    }
+	    if (r->arrival > now) {
+		if (numWaiting > 0) {
+		    break;
+		}
+		now = r->arrival;	// idle until it comes
+	    }
+	    waiting[numWaiting++] = r;
+	}
+	if (numWaiting == 0) {
+	    break;
+	}
+	i = PickNext(disk, waiting, numWaiting);
+	r = waiting[i];
+	memmove(&waiting[i], &waiting[i + 1],
+			(numWaiting - i - 1) * sizeof(Request *));
+	numWaiting--;
+
+	if (model == ModelRecorded) {
+	    latency = r->recorded;
+	} else {
+	    latency = ComputeLatency(disk, now, r->sector, r->writing);
+	}
+	UpdateLast(disk, now, r->sector);
+	now += latency;
+	disk->busy += latency;
+	r->done = now;
+    }
+    delete [] waiting;
+}
+
+//----------------------------------------------------------------------
+// Compare
+// 	For qsort, to put times in order.
+//----------------------------------------------------------------------
+
+static int
+Compare(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+//----------------------------------------------------------------------
+// PrintTimes
+// 	Print the mean, percentiles and worst of some times, in ticks.
+//----------------------------------------------------------------------
+
+static void
+PrintTimes(const char *name, int *times, int count)
+{
+    double total = 0;
+    int i;
+
+    if (count == 0) {
+	printf("%-12s none\n", name);
+	return;
+    }
+    qsort(times, count, sizeof(int), Compare);
+    for (i = 0; i < count; i++) {
+	total += times[i];
+    }
+    printf("%-12s mean %.0f, p50 %d, p90 %d, p99 %d, max %d\n", name,
+		total / count, times[count / 2], times[count * 90 / 100],
+		times[count * 99 / 100], times[count - 1]);
+}
+
+//----------------------------------------------------------------------
+// main
+// 	Read the options and the trace, replay it, and print how it
+//	went.
+//----------------------------------------------------------------------
+
+int
+main(int argc, char **argv)
+{
+    char *traceFile = NULL;
+    int seekTime = -1, rotationTime = -1;
+    Request *requests;
+    DiskState disks[MaxUnits];
+    int numRequests, hits = 0, numReads = 0, numWrites = 0;
+    int numTimes = 0, numRecorded = 0, lastDone = 0, i;
+    int *times, *recorded;
+
+    for (i = 1; i < argc; i++) {
+	if (strcmp(argv[i], "-model") == 0 && i + 1 < argc) {
+	    i++;
+	    if (strcmp(argv[i], "recorded") == 0) {
+		model = ModelRecorded;
+	    } else if (strcmp(argv[i], "nachos") == 0) {
+		model = ModelNachos;
+	    } else if (strcmp(argv[i], "notrackbuf") == 0) {
+		model = ModelNoTrackBuf;
+	    } else {
+		Usage();
+	    }
+	} else if (strcmp(argv[i], "-sched") == 0 && i + 1 < argc) {
+	    i++;
+	    if (strcmp(argv[i], "fifo") == 0) {
+		scheduler = SchedFifo;
+	    } else if (strcmp(argv[i], "sstf") == 0) {
+		scheduler = SchedSstf;
+	    } else if (strcmp(argv[i], "scan") == 0) {
+		scheduler = SchedScan;
+	    } else {
+		Usage();
+	    }
+	} else if (strcmp(argv[i], "-cache") == 0 && i + 1 < argc) {
+	    cacheSize = atoi(argv[++i]);
+	} else if (strcmp(argv[i], "-seek") == 0 && i + 1 < argc) {
+	    seekTime = atoi(argv[++i]);
+	} else if (strcmp(argv[i], "-rotation") == 0 && i + 1 < argc) {
+	    rotationTime = atoi(argv[++i]);
+	} else if (argv[i][0] != '-' && traceFile == NULL) {
+	    traceFile = argv[i];
+	} else {
+	    Usage();
+	}
+    }
+    if (traceFile == NULL || cacheSize < 0 || rotationTime == 0) {
+	Usage();
+    }
+
+    numRequests = ReadTrace(traceFile, &requests);
+    if (seekTime >= 0) {
+	geometry.seekTime = seekTime;
+    }
+    if (rotationTime > 0) {
+	geometry.rotationTime = rotationTime;
+    }
+    for (i = 0; i < numRequests; i++) {
+	if (requests[i].writing) {
+	    numWrites++;
+	} else {
+	    numReads++;
+	}
+	if (model == ModelRecorded && requests[i].recorded == 0) {
+	    fprintf(stderr, "%s was made with -untimed; use another -model\n",
+			traceFile);
+	    exit(1);
+	}
+    }
+    if (cacheSize > 0) {
+	hits = ApplyCache(requests, numRequests);
+    }
+    for (i = 0; i < geometry.numDisks && i < MaxUnits; i++) {
+	ReplayUnit(i, requests, numRequests, &disks[i]);
+    }
+
+    times = new int[numRequests];
+    recorded = new int[numRequests];
+    for (i = 0; i < numRequests; i++) {
+	if (requests[i].recorded > 0) {
+	    recorded[numRecorded++] = requests[i].recorded;
+	}
+	if (!requests[i].hit) {
+	    times[numTimes++] = requests[i].done - requests[i].arrival;
+	    if (requests[i].done > lastDone) {
+		lastDone = requests[i].done;
+	    }
+	}
+    }
+
+    printf("%d requests (%d reads, %d writes) to %d disks\n", numRequests,
+		numReads, numWrites, geometry.numDisks);
+    if (cacheSize > 0) {
+	printf("Cache of %d sectors: %d read hits (%.1f%% of reads)\n",
+		cacheSize, hits, numReads ? 100.0 * hits / numReads : 0.0);
+    }
+    PrintTimes("Response:", times, numTimes);
+    PrintTimes("Recorded:", recorded, numRecorded);
+    printf("Last request done at tick %d\n", lastDone);
+    for (i = 0; i < geometry.numDisks && i < MaxUnits; i++) {
+	printf("Disk %d busy %d ticks\n", i, disks[i].busy);
+    }
+
+    delete [] times;
+    delete [] recorded;
+    delete [] requests;
+    return 0;
+}